@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpu.hpp"
+
+namespace M68K {
+
+struct BatchJob {
+    std::string program;  // ELF executable or snapshot image, see load_elf() and load_image()
+    uint32_t input_address = 0;
+    std::vector<uint8_t> input;  // written to input_address after the program is loaded
+
+    // the job ends before the instruction at stop_pc or after max_instructions, see RunLimits
+    uint32_t stop_pc = 0;
+    uint64_t max_instructions = std::numeric_limits<uint64_t>::max();
+
+    uint32_t output_address = 0;
+    uint32_t output_size = 0;  // bytes copied to BatchResult::output
+};
+
+struct BatchResult {
+    bool loaded = false;
+    bool stopped = false;  // stop_pc was reached
+    bool halted = false;   // the program ended in an idle loop, e.g. for(;;), or by a double fault
+    uint64_t instructions = 0;
+    Registers registers;
+    std::vector<uint8_t> output;
+    std::string error;  // what() of an exception raised while running, e.g. a memory fault
+};
+
+
+// Runs independent jobs on a pool of threads. Each thread owns a CPU that is built with the
+// runner and kept between jobs and run() calls: a job on the program loaded last restores its
+// start state with CPU::restore(), so only pages written by the previous job are copied and
+// the block cache stays warm. Every job starts with cleared cycles, interrupt requests,
+// scheduler events and halted and stopped flags. Jobs are split into one range per thread, idle threads steal half of the
+// range of another. Results are written to their own slot, without locks.
+class BatchRunner {
+public:
+    explicit BatchRunner(unsigned thread_count = 0);  // 0 uses one thread per core
+    ~BatchRunner();
+
+    std::vector<BatchResult> run(const std::vector<BatchJob>& jobs);
+
+    unsigned threadCount() const {
+        return (unsigned)this->workers.size();
+    }
+
+private:
+    struct Worker;
+
+    void work(Worker& worker, const std::vector<BatchJob>& jobs, std::vector<BatchResult>& results);
+    bool steal(Worker& thief, uint32_t& job);
+    static bool prepare(Worker& worker, const std::string& program);
+    static void execute(Worker& worker, const BatchJob& job, BatchResult& result);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+};
+
+}  // namespace M68K
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "instructions/instruction.hpp"
+#include "memory.hpp"
+
+namespace M68K {
+
+struct JitContext;
+// native code of a block, returns the number of executed instructions
+typedef uint32_t (*JitFunction)(JitContext* context, uint32_t* registers);
+
+
+// An instruction of a block. Its operands are not predecoded: execute() reads the register
+// fields from the opcode it was decoded for and the extension words at the PC, like step().
+struct BlockEntry {
+    INSTRUCTION::Instruction* instruction = nullptr;
+    uint32_t pc = 0;      // address of the opcode word
+    uint16_t length = 0;  // opcode + extension words in bytes, 0 for branches
+    uint16_t cycles = 0;  // of the instruction, see CYCLES::instructionCycles()
+};
+
+
+class BasicBlock {
+public:
+    static const std::size_t MAX_LENGTH = 64;
+
+    uint32_t start_pc = 0;
+    uint32_t end_pc = 0;  // address right after the last instruction
+    std::vector<BlockEntry> entries;
+    uint32_t cycles = 0;  // of all entries
+
+    // Successor chaining, saves the cache lookup on hot back edges.
+    BasicBlock* link[2] = {nullptr, nullptr};
+    std::vector<BasicBlock*> linked_from;  // blocks with a link to this one
+
+    // Branches back to its start and writes nothing but registers: when an iteration leaves the
+    // registers unchanged the loop never ends, see CPUCore::run(const RunLimits&)
+    bool idle_candidate = false;
+    bool reads_memory = false;
+
+    uint32_t exec_count = 0;      // interpreted runs, a block gets compiled when it reaches the JIT threshold
+    JitFunction native = nullptr;
+
+    BasicBlock* successor(uint32_t pc) const {
+        if (link[0] && link[0]->start_pc == pc)
+            return link[0];
+        if (link[1] && link[1]->start_pc == pc)
+            return link[1];
+        return nullptr;
+    }
+    void chain(BasicBlock* next);
+
+    // cycles of the first count entries
+    uint32_t cyclesOf(std::size_t count) const {
+        if (count == this->entries.size())
+            return this->cycles;
+        uint32_t sum = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            sum += this->entries[i].cycles;
+        }
+        return sum;
+    }
+};  // class BasicBlock
+//////////////////////////////////////////////////////////////////////////
+
+
+
+class BlockCache {
+private:
+    static const uint32_t PAGE_SHIFT = CodeWatch::CODE_PAGE_SHIFT;
+
+    std::unordered_map<uint32_t, std::unique_ptr<BasicBlock>> blocks;
+    std::unordered_map<uint32_t, std::vector<BasicBlock*>> pages;  // blocks by the pages of their code
+
+    void remove(BasicBlock* block);
+
+public:
+    BlockCache() = default;
+
+    BasicBlock* find(uint32_t pc) const {
+        auto it = blocks.find(pc);
+        return it != blocks.end() ? it->second.get() : nullptr;
+    }
+    BasicBlock* insert(std::unique_ptr<BasicBlock> block);
+
+    // Drops the blocks with code on a page and the links to them. CPUCore::run() calls it for
+    // the pages in CodeWatch::writtenCode(), so only code patched in memory a CodeWatch does not
+    // see needs invalidate(), which drops the blocks on the pages of the range.
+    void invalidatePage(uint32_t page);
+    void invalidate(uint32_t address, uint32_t size);
+    void clear();
+
+    std::size_t size() const {
+        return blocks.size();
+    }
+};  // class BlockCache
+//////////////////////////////////////////////////////////////////////////
+
+
+}  // namespace M68K
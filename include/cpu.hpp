@@ -1,20 +1,201 @@
 #pragma once
+#include "block_cache.hpp"
 #include "cpu_state.hpp"
 #include "instruction_decoder.hpp"
+#include "jit.hpp"
+#include "scheduler.hpp"
+
+#include <limits>
+#include <memory>
+#include <ostream>
+#include <utility>
+#include <vector>
 
 namespace M68K {
-class CPU {
+// Stop conditions of CPUCore::run(), checked at block boundaries
+struct RunLimits {
+    uint64_t instructions = std::numeric_limits<uint64_t>::max();  // may be exceeded by the rest of a block
+    uint64_t cycles = std::numeric_limits<uint64_t>::max();        // clock cycles of this run, exact to the instruction
+    // PCs to stop at before their instruction is executed. The first instruction of a run() is
+    // never stopped at, so a run() from a breakpoint continues past it.
+    std::vector<uint32_t> breakpoints;
+    // Stops in a loop that only reads registers and memory and ran an iteration without
+    // changing a register, like for(;;) or polling RAM no one else writes. With an event or a
+    // cycle limit ahead its iterations are skipped up to it instead.
+    bool detect_idle = true;
+};
+
+enum StopReason {
+    STOP_INSTRUCTIONS,  // RunLimits::instructions reached
+    STOP_CYCLES,        // RunLimits::cycles reached, never without M68K_CYCLES
+    STOP_BREAKPOINT,    // PC is one of RunLimits::breakpoints
+    STOP_HALT,          // CPUState::halted is set
+    STOP_IDLE,          // waits for an interrupt after STOP or in a loop, see RunLimits::detect_idle
+};
+
+struct RunResult {
+    StopReason reason = STOP_INSTRUCTIONS;
+    uint64_t instructions = 0;
+    uint64_t cycles = 0;
+};
+
+
+// Everything of a CPU but the memory, the memory type is chosen by BasicCPU
+class CPUCore {
+public:
+    CPUState state;
+    const InstructionDecoder& instruction_decoder = InstructionDecoder::shared();
+    BlockCache block_cache;
+    // events of the devices, not part of snapshots and clones
+    Scheduler scheduler;
+#if M68K_JIT
+    JitCompiler jit;
+#endif
+
+    // Executes one instruction, nothing while halted or stopped and no interrupt is taken, like
+    // run(). A stopped CPU advances its cycles to the next event instead.
+    void step();
+
+    // Executes whole basic blocks from the block cache until at least instruction_limit
+    // instructions have been executed or the CPU is halted. Returns the executed count.
+    uint64_t run(uint64_t instruction_limit);
+    // Executes blocks until one of the limits is reached. Blocks stop early at breakpoints and
+    // at the instruction a scheduler event or the cycle limit falls on, new blocks end there.
+    // An idle loop waits for the next event by skipping its iterations up to it, which count as
+    // executed instructions. The CPU stays where it was in a loop run() stops at with STOP_IDLE,
+    // a run() after an interrupt was raised or memory was written continues it.
+    RunResult run(const RunLimits& limits);
+
+#if M68K_STATS
+    // counters of the calling thread, the one running this CPU, see STATS::writeCsv()
+    void writeStatsCsv(std::ostream& out) const {
+        STATS::writeCsv(out, STATS::local());
+    }
+    void writeStatsJson(std::ostream& out) const {
+        STATS::writeJson(out, STATS::local());
+    }
+#endif
+
+protected:
+    explicit CPUCore(const CPUState& in_state) : state(in_state) {
+    }
+
 private:
+    BasicBlock* translate(uint32_t pc, const std::vector<uint32_t>& breakpoints, uint64_t cycle_budget);
+    // Interprets the first count entries of a block and adds them to executed. Returns false
+    // if one raised an exception, the CPU is at its handler then.
+    bool interpret(const BasicBlock& block, size_t count, uint64_t& executed);
+
+    void countCycles(const BasicBlock& block, std::size_t count) {
+#if M68K_CYCLES
+        this->state.cycles += block.cyclesOf(count);
+#else
+        (void)block, (void)count;
+#endif
+    }
+    void countStats(const BasicBlock& block, std::size_t count, uint64_t times = 1) {
+#if M68K_STATS
+        ExecutionStats& stats = STATS::local();
+        for (std::size_t i = 0; i < count; i++) {
+            stats.opcodes[block.entries[i].instruction->getOpcode()] += times;
+        }
+#else
+        (void)block, (void)count, (void)times;
+#endif
+    }
+#if M68K_JIT
+    JitContext jit_context;
+#endif
+};
+
+
+// Owns the memory of a BasicCPU, constructed before CPUCore takes its address
+template <class Memory>
+struct CPUMemory {
+    Memory memory;
+
+    template <class... Args>
+    explicit CPUMemory(Args&&... args) : memory(std::forward<Args>(args)...) {
+    }
+};
+
+// Memory owned by the caller and reached through the virtual interface
+template <>
+struct CPUMemory<IMemory> {
+    IMemory& memory;
+
+    explicit CPUMemory(IMemory& in_memory) : memory(in_memory) {
+    }
+};
+
+
+// Registers and memory of a CPU, see BasicCPU::snapshot()
+struct CPUSnapshot {
+    Registers registers;
+    bool halted = false;
+    bool stopped = false;
+    uint64_t cycles = 0;
+    MemorySnapshot memory;
+};
+
+
+// CPU on a memory type known at compile time. BaseMemory and MemoryBus based memories are
+// accessed by CPUState without virtual calls, BasicCPU<IMemory> takes any memory by reference.
+template <class Memory>
+class BasicCPU : public CPUMemory<Memory>, public CPUCore {
 public:
-    CPU() = default;
+    template <class... Args>
+    explicit BasicCPU(Args&&... args) : CPUMemory<Memory>(std::forward<Args>(args)...), CPUCore(CPUState(&this->memory)) {
+    }
 
-    SimpleMemory memory;
-    CPUState state = CPUState(&memory);
-    InstructionDecoder instruction_decoder = InstructionDecoder();
+    // New CPU with the registers, halted, stopped, cycles and interrupt requests of this one on
+    // memory shared through Memory::shareFrom(), copy-on-write for a MemoryBus. This CPU must not
+    // run meanwhile. The clone starts with an empty block cache and scheduler, the events call
+    // back into the devices of this CPU and are not copied.
+    std::unique_ptr<BasicCPU> clone() {
+        std::unique_ptr<BasicCPU> copy(new BasicCPU());
+        copy->memory.shareFrom(this->memory);
+        copy->state.registers = this->state.registers;
+        copy->state.halted = this->state.halted;
+        copy->state.stopped = this->state.stopped;
+        copy->state.cycles = this->state.cycles;
+        for (int level = 1; level < 8; level++) {
+            if (this->state.requestedIRQs() & (1 << level))
+                copy->state.raiseIRQ(level, this->state.irqVector(level));
+        }
+#if M68K_JIT
+        copy->jit.enabled = this->jit.enabled;
+        copy->jit.threshold = this->jit.threshold;
+#endif
+        return copy;
+    }
 
-    void step();
+    // For memories derived from BaseMemory. After the first snapshot() a restore() copies back
+    // only the pages written since, and drops the cached blocks on them.
+    CPUSnapshot snapshot() {
+        CPUSnapshot result;
+        result.registers = this->state.registers;
+        result.halted = this->state.halted;
+        result.stopped = this->state.stopped;
+        result.cycles = this->state.cycles;
+        result.memory = this->memory.snapshot();
+        return result;
+    }
+
+    void restore(const CPUSnapshot& snapshot) {
+        this->memory.restore(snapshot.memory);  // the next run() drops the blocks on the pages it copies
+        this->state.registers = snapshot.registers;
+        this->state.halted = snapshot.halted;
+        this->state.stopped = snapshot.stopped;
+        this->state.cycles = snapshot.cycles;
+    }
 };
 
-extern bool load_elf(CPU* cpu, const std::string& filename);
+using CPU = BasicCPU<SimpleMemory>;
+
+// Loads an executable with load_elf_image() and starts it at its entry point: clears the block
+// and JIT caches, halted, stopped, the cycles, interrupt requests and a pending exception.
+// Scheduler events are kept, they belong to the devices.
+extern bool load_elf(CPUCore* cpu, const std::string& filename);
 
 };  // namespace M68K
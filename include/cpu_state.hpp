@@ -1,19 +1,170 @@
 #pragma once
 #include "memory.hpp"
+#include "memory_bus.hpp"
 #include "registers.hpp"
+#include "stats.hpp"
 
 namespace M68K {
+// Location of a read-modify-write operand, see CPUState::resolveEA()
+struct EffectiveAddress {
+    AddressingMode mode = ADDR_MODE_UNKNOWN;
+    RegisterType reg = REG_D0;
+    uint32_t address = 0;  // memory modes
+};
+
+
 class CPUState {
 public:
     IMemory* memoryPtr = nullptr;
     IMemory& memory = *memoryPtr;
     Registers registers = Registers();
+    bool halted = false;   // by a double fault, the CPU does nothing until the host clears it
+    bool stopped = false;  // by STOP, the CPU waits until it takes an interrupt
+    uint64_t cycles = 0;  // 68000 clock cycles executed, stays 0 without M68K_CYCLES
 
 public:
+    // the overload picked for the static type of the memory decides how readMemory() reaches it
     CPUState(IMemory* in_memory = nullptr) : memoryPtr(in_memory) {
     }
+    CPUState(BaseMemory* in_memory) : memoryPtr(in_memory), base_memory(in_memory) {
+    }
+    CPUState(MemoryBus* in_memory) : memoryPtr(in_memory), memory_bus(in_memory) {
+    }
+    CPUState(const CPUState& rh) = default;
     void operator=(const CPUState& rh) {
-        memoryPtr = rh.memoryPtr, registers = rh.registers;
+        memoryPtr = rh.memoryPtr, registers = rh.registers, halted = rh.halted, stopped = rh.stopped, cycles = rh.cycles;
+        base_memory = rh.base_memory, memory_bus = rh.memory_bus;
+        irq_levels = rh.irq_levels;
+        for (int level = 0; level < 8; level++)
+            irq_vectors[level] = rh.irq_vectors[level];
+    }
+
+    // memory.get()/set() without a virtual call when the concrete memory type is known.
+    // An odd word or long address raises an address error, an address past the end of a
+    // BaseMemory or on an unmapped MemoryBus page a bus error: the read returns 0 and the
+    // instruction runs to its end with its memory writes dropped, its caller undoes its register
+    // changes with abortOnFault(), then the CPU enters the handler, see processException().
+    // A device or other memory that throws raises a bus error too.
+    uint32_t readMemory(std::size_t address, DataSize size) noexcept {
+#if M68K_STATS
+        STATS::countRead(size);
+#endif
+        if (size != SIZE_BYTE && (address & 1))
+            return this->accessFault(VECTOR_ADDRESS_ERROR, address, false);
+        if (this->base_memory) {
+            if (!this->base_memory->contains(address, size))
+                return this->accessFault(VECTOR_BUS_ERROR, address, false);
+            return this->base_memory->load(address, size);
+        }
+        if (this->memory_bus && !this->memory_bus->mapped(address, size, PAGE_READ))
+            return this->accessFault(VECTOR_BUS_ERROR, address, false);
+        try {
+            if (this->memory_bus)
+                return this->memory_bus->get(address, size);
+            return this->memory.get(address, size);
+        } catch (...) {
+            return this->accessFault(VECTOR_BUS_ERROR, address, false);
+        }
+    }
+    void writeMemory(std::size_t address, DataSize size, uint32_t data) noexcept {
+        if (this->exception_vector != VECTOR_NONE)
+            return;
+#if M68K_STATS
+        STATS::countWrite(size);
+#endif
+        if (size != SIZE_BYTE && (address & 1)) {
+            this->accessFault(VECTOR_ADDRESS_ERROR, address, true);
+        } else if (this->base_memory) {
+            if (this->base_memory->contains(address, size))
+                this->base_memory->store(address, size, data);
+            else
+                this->accessFault(VECTOR_BUS_ERROR, address, true);
+        } else if (this->memory_bus && !this->memory_bus->mapped(address, size, PAGE_WRITE)) {
+            this->accessFault(VECTOR_BUS_ERROR, address, true);
+        } else {
+            try {
+                if (this->memory_bus)
+                    this->memory_bus->set(address, size, data);
+                else
+                    this->memory.set(address, size, data);
+            } catch (...) {
+                this->accessFault(VECTOR_BUS_ERROR, address, true);
+            }
+        }
+    }
+
+    // data dependent part of the cycles of an instruction, see CYCLES::instructionCycles()
+    void addCycles(int delta) noexcept {
+#if M68K_CYCLES && M68K_ACCURATE_CYCLES
+        this->cycles += static_cast<uint64_t>(static_cast<int64_t>(delta));
+#else
+        (void)delta;
+#endif
+    }
+
+    // Exceptions raised by an instruction are taken after it, the first one raised wins.
+    // Group 1 and 2 exceptions push the PC at that point, the instructions raising them set it.
+    void raiseException(ExceptionVector vector) noexcept {
+        if (this->exception_vector == VECTOR_NONE)
+            this->exception_vector = vector;
+    }
+    ExceptionVector pendingException() const noexcept {
+        return this->exception_vector;
+    }
+    // A bus or address error aborts the instruction that raised it: the registers and SR go back
+    // to before, the PC to the instruction. Its memory writes before the fault stay done.
+    void abortOnFault(const Registers& before) noexcept {
+        if (this->exception_vector == VECTOR_BUS_ERROR || this->exception_vector == VECTOR_ADDRESS_ERROR)
+            this->registers = before;
+    }
+    // Pushes the exception frame of the raised exception to the supervisor stack and jumps to
+    // its handler. instruction_pc is the address of the instruction that raised it, bus and
+    // address error frames hold its opcode. A fault while doing so halts the CPU.
+    void processException(uint32_t instruction_pc);
+
+    // Interrupt request of a device on level 1 to 7. vector is the one the device supplies on the
+    // acknowledge, 0 for the autovector VECTOR_SPURIOUS_INTERRUPT + level. The request stays
+    // pending until the CPU takes it, a device that keeps its line asserted raises it again.
+    // Level 7 is not masked. A newer request on a pending level replaces its vector.
+    void raiseIRQ(int level, uint8_t vector = 0);
+    // withdraws a request that was not taken yet
+    void clearIRQ(int level);
+    // bit n is set while level n is requested, and the vector the device supplied for it
+    uint8_t requestedIRQs() const noexcept {
+        return this->irq_levels;
+    }
+    uint8_t irqVector(int level) const {
+        return this->irq_vectors[level & 7];
+    }
+    // Clears halted, stopped, the cycles, interrupt requests and a pending exception, the state
+    // of a CPU that starts a new program. Registers and memory stay as they are.
+    void resetRunState() noexcept {
+        this->halted = this->stopped = false;
+        this->cycles = 0;
+        this->exception_vector = VECTOR_NONE;
+        this->irq_levels = 0;
+    }
+    // Set while an interrupt is requested, masked or not. The run loop tests it between blocks
+    // and only then compares the levels with the mask, see takeInterrupt().
+    bool attention() const noexcept {
+        return this->irq_levels != 0;
+    }
+    // Enters the handler of the highest requested level above the interrupt mask: pushes PC and
+    // SR, sets the mask to the level and clears stopped. Returns false if all are masked or the
+    // CPU is halted.
+    bool takeInterrupt();
+
+    // reads may return values this CPU did not write, from a device or from an unknown IMemory
+    bool memoryMayChange() const {
+        if (this->memory_bus)
+            return this->memory_bus->hasDevices();
+        return !this->base_memory;
+    }
+    // reports the writes to the code of cached blocks, nullptr if the memory does not
+    CodeWatch* codeWatch() const {
+        if (this->memory_bus)
+            return this->memory_bus;
+        return this->base_memory;
     }
 
     uint32_t stackPop(DataSize size);
@@ -22,8 +173,121 @@ public:
     uint32_t getData(AddressingMode mode, RegisterType reg, DataSize size);
     uint32_t getDataSilent(AddressingMode mode, RegisterType reg, DataSize size);
     void setData(AddressingMode mode, RegisterType reg, DataSize size, uint32_t data);
+
+    // Read-modify-write access: the extension words are read once by resolveEA(), getData() has no
+    // side effects and setData() does what setData(mode, reg, size, data) would, PC and (An)+/-(An) updates included.
+    EffectiveAddress resolveEA(AddressingMode mode, RegisterType reg, DataSize size);
+    uint32_t getData(const EffectiveAddress& ea, DataSize size);
+    void setData(const EffectiveAddress& ea, DataSize size, uint32_t data);
+
     bool checkCondition(Condition cond);
 
+    // getData(), getDataSilent() and setData() for a mode and size known at compile time.
+    // Register and register indirect modes are resolved inline, modes with extension words
+    // go through the generic functions.
+    template <AddressingMode Mode, DataSize Size>
+    uint32_t getData(RegisterType reg);
+    template <AddressingMode Mode, DataSize Size>
+    uint32_t getDataSilent(RegisterType reg);
+    template <AddressingMode Mode, DataSize Size>
+    void setData(RegisterType reg, uint32_t data);
+
     void debugPrint();
+
+private:
+    BaseMemory* base_memory = nullptr;
+    MemoryBus* memory_bus = nullptr;
+
+    ExceptionVector exception_vector = VECTOR_NONE;
+    uint32_t fault_address = 0;  // access of the bus or address error
+    bool fault_write = false;
+
+    uint8_t irq_levels = 0;  // bit n: level n is requested
+    uint8_t irq_vectors[8] = {};
+
+    uint32_t accessFault(ExceptionVector vector, std::size_t address, bool write) noexcept {
+        if (this->exception_vector == VECTOR_NONE) {
+            this->exception_vector = vector;
+            this->fault_address = (uint32_t)MASK_ADDR(address);
+            this->fault_write = write;
+        }
+        return 0;
+    }
+
+    // address register step of (An)+ and -(An), A7 stays word aligned
+    template <DataSize Size>
+    static uint32_t addressStep(RegisterType reg) {
+        return (Size == SIZE_BYTE && reg == REG_A7) ? 2 : Size;
+    }
 };
+
+
+template <AddressingMode Mode, DataSize Size>
+uint32_t CPUState::getData(RegisterType reg) {
+    switch (Mode) {
+        case ADDR_MODE_DIRECT_DATA:
+        case ADDR_MODE_DIRECT_ADDR:
+            return this->registers.get<Size>(reg);
+        case ADDR_MODE_INDIRECT:
+            return this->readMemory(this->registers.get<SIZE_LONG>(reg), Size);
+        case ADDR_MODE_INDIRECT_POSTINCREMENT: {
+            uint32_t addr = this->registers.get<SIZE_LONG>(reg);
+            uint32_t data = this->readMemory(addr, Size);
+            this->registers.set<SIZE_LONG>(reg, addr + addressStep<Size>(reg));
+            return data;
+        }
+        case ADDR_MODE_INDIRECT_PREDECREMENT: {
+            uint32_t addr = this->registers.get<SIZE_LONG>(reg) - addressStep<Size>(reg);
+            uint32_t data = this->readMemory(addr, Size);
+            this->registers.set<SIZE_LONG>(reg, addr);
+            return data;
+        }
+        default:
+            return this->getData(Mode, reg, Size);
+    }
+}
+
+template <AddressingMode Mode, DataSize Size>
+uint32_t CPUState::getDataSilent(RegisterType reg) {
+    switch (Mode) {
+        case ADDR_MODE_DIRECT_DATA:
+        case ADDR_MODE_DIRECT_ADDR:
+            return this->registers.get<Size>(reg);
+        case ADDR_MODE_INDIRECT:
+        case ADDR_MODE_INDIRECT_POSTINCREMENT:
+            return this->readMemory(this->registers.get<SIZE_LONG>(reg), Size);
+        case ADDR_MODE_INDIRECT_PREDECREMENT:
+            return this->readMemory(this->registers.get<SIZE_LONG>(reg) - addressStep<Size>(reg), Size);
+        default:
+            return this->getDataSilent(Mode, reg, Size);
+    }
+}
+
+template <AddressingMode Mode, DataSize Size>
+void CPUState::setData(RegisterType reg, uint32_t data) {
+    switch (Mode) {
+        case ADDR_MODE_DIRECT_DATA:
+        case ADDR_MODE_DIRECT_ADDR:
+            this->registers.set<Size>(reg, data);
+            break;
+        case ADDR_MODE_INDIRECT:
+            this->writeMemory(this->registers.get<SIZE_LONG>(reg), Size, data);
+            break;
+        case ADDR_MODE_INDIRECT_POSTINCREMENT: {
+            uint32_t addr = this->registers.get<SIZE_LONG>(reg);
+            this->writeMemory(addr, Size, data);
+            this->registers.set<SIZE_LONG>(reg, addr + addressStep<Size>(reg));
+            break;
+        }
+        case ADDR_MODE_INDIRECT_PREDECREMENT: {
+            uint32_t addr = this->registers.get<SIZE_LONG>(reg) - addressStep<Size>(reg);
+            this->writeMemory(addr, Size, data);
+            this->registers.set<SIZE_LONG>(reg, addr);
+            break;
+        }
+        default:
+            this->setData(Mode, reg, Size, data);
+            break;
+    }
+}
 }  // namespace M68K
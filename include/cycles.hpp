@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+
+#include "defines.hpp"
+
+namespace M68K {
+
+// 68000 clock cycles, from the instruction execution times of the M68000 user's manual.
+//
+// instructionCycles() is the cost of an opcode with its effective addresses, it is known at decode
+// time and summed per basic block, so counting costs nothing per instruction. The data dependent
+// part is fixed there: MUL and DIV at their worst case, register shift counts and Scc as 0 and
+// Bcc as taken. With M68K_ACCURATE_CYCLES the instructions add the difference to the exact
+// time through CPUState::addCycles().
+namespace CYCLES {
+const int MUL = 70;     // 38 + 2n
+const int DIVU = 140;
+const int DIVS = 158;
+const int INTERRUPT = 44;  // autovectored, from the end of an instruction to the first one of the handler
+
+uint16_t instructionCycles(uint16_t opcode);
+
+// calculation time of an effective address, included in instructionCycles()
+int effectiveAddress(AddressingMode mode, DataSize size);
+
+// exception processing on top of the instruction that raised it
+int exception(ExceptionVector vector);
+
+// exact times of the data dependent instructions, without effective addresses
+int mulu(uint16_t source);
+int muls(uint16_t source);
+int divu(uint32_t dividend, uint16_t divisor);
+int divs(int32_t dividend, int16_t divisor);
+}  // namespace CYCLES
+
+}  // namespace M68K
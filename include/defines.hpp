@@ -12,6 +12,44 @@
 #endif  // _MSC_VER
 
 
+// x86-64 translation of hot basic blocks, see jit.hpp
+#ifndef M68K_ENABLE_JIT
+#define M68K_ENABLE_JIT 1
+#endif
+#if M68K_ENABLE_JIT && (defined(__x86_64__) || defined(_M_X64))
+#define M68K_JIT 1
+#else
+#define M68K_JIT 0
+#endif
+
+// ALU instructions record their operands, condition codes are computed when they are read, see Registers::setFlags
+#ifndef M68K_LAZY_FLAGS
+#define M68K_LAZY_FLAGS 1
+#endif
+
+// guest words and longs are read and written with one host access and a byte swap, see LOAD_BE_16
+#ifndef M68K_BSWAP_MEMORY
+#define M68K_BSWAP_MEMORY 1
+#endif
+// CPUState::cycles counts 68000 clock cycles, 0 drops the counting, see cycles.hpp
+#ifndef M68K_CYCLES
+#define M68K_CYCLES 1
+#endif
+// adds the data dependent cycles of MUL, DIV, register shifts, Scc and branches not taken
+#ifndef M68K_ACCURATE_CYCLES
+#define M68K_ACCURATE_CYCLES 0
+#endif
+// counts executed opcodes and memory accesses per thread, see stats.hpp
+#ifndef M68K_STATS
+#define M68K_STATS 0
+#endif
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define M68K_HOST_BIG_ENDIAN 1
+#else
+#define M68K_HOST_BIG_ENDIAN 0
+#endif
+
+
 
 namespace M68K {
     enum DataSize{
@@ -55,6 +93,21 @@ namespace M68K {
         COND_LESS_EQUAL = 15,
     };
 
+    // Exception vector numbers, the handler address is read from vector * 4
+    enum ExceptionVector{
+        VECTOR_NONE = 0, // vector 0 holds the reset SSP, it is never raised
+        VECTOR_BUS_ERROR = 2,
+        VECTOR_ADDRESS_ERROR = 3,
+        VECTOR_ILLEGAL_INSTRUCTION = 4,
+        VECTOR_ZERO_DIVIDE = 5,
+        VECTOR_PRIVILEGE_VIOLATION = 8,
+        VECTOR_LINE_A = 10,
+        VECTOR_LINE_F = 11,
+        VECTOR_SPURIOUS_INTERRUPT = 24, // the autovector of interrupt level n is 24 + n
+        VECTOR_TRAP_0 = 32, // TRAP #n raises VECTOR_TRAP_0 + n
+        VECTOR_USER = 64, // 64 to 255, supplied by the device of a vectored interrupt
+    };
+
     const std::size_t MEMORY_SIZE = 0x01000000; // 16 MB
 };
 
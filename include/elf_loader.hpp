@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "memory.hpp"
+
+namespace M68K {
+
+struct ElfSegment {
+    uint32_t address = 0;
+    uint32_t file_size = 0;
+    uint32_t memory_size = 0;  // bytes past file_size are zero-filled
+    uint32_t flags = 0;        // PF_X | PF_W | PF_R
+};
+
+struct ElfSymbol {
+    std::string name;
+    uint32_t address = 0;
+    uint32_t size = 0;
+};
+
+struct ElfImage {
+    uint32_t entry = 0;
+    std::vector<ElfSegment> segments;
+    std::vector<ElfSymbol> symbols;  // named entries of the symbol tables, empty for stripped files
+};
+
+
+// Writes the PT_LOAD segments of a big-endian 68k executable to memory, without console output.
+// Returns false if the file can not be read or is not a 68k executable, memory errors throw.
+bool load_elf_image(IMemory& memory, const std::string& file_name, ElfImage& image);
+
+}  // namespace M68K
@@ -3,6 +3,10 @@
 #include <string> // std::to_string
 #include <assert.h>
 #include <stdexcept>
+#include <cstring> // std::memcpy
+#if defined(_MSC_VER)
+#include <stdlib.h> // _byteswap_ushort, _byteswap_ulong
+#endif
 
 namespace M68K{
     template<typename T> inline T MSB_8(T value) { return value & 0x80;}
@@ -136,6 +140,18 @@ namespace M68K{
         return false;
     }
 
+    // overflow of dest - src
+    template<typename T> inline bool IS_OVERFLOW_SUB(T src, T dest, DataSize size) {
+        uint32_t result = (uint32_t)dest - (uint32_t)src;
+        uint32_t v = ((uint32_t)src ^ (uint32_t)dest) & ((uint32_t)dest ^ result);
+        switch(size){
+            case SIZE_BYTE: return MSB_8(v) != 0;
+            case SIZE_WORD: return MSB_16(v) != 0;
+            case SIZE_LONG: return MSB_32(v) != 0;
+        }
+        return false;
+    }
+
     template<typename T> inline bool IS_CARRY(T v, DataSize size) {
         switch(size){
             case SIZE_BYTE: return v > MASK_8(v);
@@ -144,4 +160,45 @@ namespace M68K{
         }
         return false;
     }
+
+
+    inline uint16_t BSWAP_16(uint16_t v) {
+#if defined(_MSC_VER)
+        return _byteswap_ushort(v);
+#else
+        return __builtin_bswap16(v);
+#endif
+    }
+
+    inline uint32_t BSWAP_32(uint32_t v) {
+#if defined(_MSC_VER)
+        return _byteswap_ulong(v);
+#else
+        return __builtin_bswap32(v);
+#endif
+    }
+
+    // Big-endian guest words and longs with one host load or store, swapped on little-endian hosts.
+    // memcpy keeps it legal for the word aligned longs of the 68000.
+    inline uint16_t LOAD_BE_16(const uint8_t* p) {
+        uint16_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return M68K_HOST_BIG_ENDIAN ? v : BSWAP_16(v);
+    }
+
+    inline uint32_t LOAD_BE_32(const uint8_t* p) {
+        uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return M68K_HOST_BIG_ENDIAN ? v : BSWAP_32(v);
+    }
+
+    inline void STORE_BE_16(uint8_t* p, uint16_t v) {
+        v = M68K_HOST_BIG_ENDIAN ? v : BSWAP_16(v);
+        std::memcpy(p, &v, sizeof(v));
+    }
+
+    inline void STORE_BE_32(uint8_t* p, uint32_t v) {
+        v = M68K_HOST_BIG_ENDIAN ? v : BSWAP_32(v);
+        std::memcpy(p, &v, sizeof(v));
+    }
 }
@@ -1,19 +1,45 @@
 #pragma once
 #include "defines.hpp"
 #include "instructions.hpp"
+#include "instructions/illegal.hpp"
 
 #include <vector>
 #include <memory>
 
 namespace M68K{
+    // Decoded instructions are never modified after construction, so one table can be
+    // shared by every CPU, use InstructionDecoder::shared() instead of building a new one.
     class InstructionDecoder{
     private:
-        std::vector<std::unique_ptr<INSTRUCTION::Instruction>> opcode_table;
+        // Instructions of all valid opcodes, constructed in place in one buffer.
+        std::unique_ptr<unsigned char[]> arena;
+        std::vector<uint32_t> opcode_table;  // arena offset per opcode, below RESERVED for invalid opcodes
+
+        // The Illegal instances of invalid opcodes come first in the arena, one for the line A
+        // and line F emulator traps each and one for everything else.
+        static constexpr std::size_t RESERVED = 3 * sizeof(INSTRUCTION::Illegal);
+        static constexpr std::size_t illegalOffset(uint16_t opcode){
+            return (opcode >> 12) == 0xA ? sizeof(INSTRUCTION::Illegal) : (opcode >> 12) == 0xF ? 2 * sizeof(INSTRUCTION::Illegal) : 0;
+        }
 
         void generateOpcodeTable();
+        void destroyOpcodeTable();
     public:
         InstructionDecoder();
+        ~InstructionDecoder();
+        InstructionDecoder(InstructionDecoder&& other);
+        InstructionDecoder& operator=(InstructionDecoder&& other);
+
+        // Process-wide table, built on first use. Thread safe.
+        static const InstructionDecoder& shared();
 
-        INSTRUCTION::Instruction* Decode(uint16_t opcode);
+        INSTRUCTION::Instruction* Decode(uint16_t opcode) const{
+            return reinterpret_cast<INSTRUCTION::Instruction*>(this->arena.get() + this->opcode_table[opcode]);
+        }
+        bool isValid(uint16_t opcode) const{
+            return this->opcode_table[opcode] >= RESERVED;
+        }
+        // name of the table entry that decodes opcode, e.g. "Moveq", "Illegal", "LineA" or "LineF" for invalid opcodes
+        const char* handlerName(uint16_t opcode) const;
     };
 }
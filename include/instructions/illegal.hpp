@@ -6,7 +6,7 @@ namespace M68K{
     namespace INSTRUCTION{
         class Illegal : public Instruction{
         public:
-            Illegal(uint16_t opcode) : Instruction(opcode) {};
+            Illegal(uint16_t opcode) : Instruction(opcode) { is_branch = true; };
             void execute(CPUState& cpu_state) override;
             std::string disassembly(CPUState& cpu_state) override;
 
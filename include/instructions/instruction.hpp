@@ -6,6 +6,8 @@
 
 #include <string>
 #include <cstdint>
+#include <new>
+#include <type_traits>
 
 namespace M68K{
     namespace INSTRUCTION{
@@ -15,8 +17,11 @@ namespace M68K{
 
         public:
             bool is_valid = true;
+            bool is_branch = false; // may change PC non-sequentially, ends a basic block
+            uint16_t cycles = 0;    // set by the decoder, see CYCLES::instructionCycles()
 
             Instruction(uint16_t opcode) : opcode(opcode) {};
+            uint16_t getOpcode() const { return opcode; }
             virtual ~Instruction() = default;
             virtual void execute(CPUState&) {};
             virtual std::string disassembly(CPUState&) { return "unknown"; };
@@ -25,5 +30,44 @@ namespace M68K{
             static RegisterType getRegisterType(uint16_t part_mode, uint16_t part_reg);
             static Condition getCondition(uint16_t cond_part);
         };
+
+
+        // Helpers for binding an instruction to an execute() specialized on its addressing modes and
+        // size: f is called with the runtime value as a std::integral_constant, usable as a template
+        // argument through decltype(tag)::value. Only modes without extension words are specialized,
+        // nullptr is returned for the others.
+        template <AddressingMode Mode>
+        using ModeTag = std::integral_constant<AddressingMode, Mode>;
+        template <DataSize Size>
+        using SizeTag = std::integral_constant<DataSize, Size>;
+
+        // Constructs Form, a subclass of Base without members of its own, in the space of a Base.
+        template <class Form, class Base>
+        Instruction* constructForm(void* place, uint16_t opcode) {
+            static_assert(sizeof(Form) == sizeof(Base) && alignof(Form) == alignof(Base), "a form must fit in the place of its class");
+            return new (place) Form(opcode);
+        }
+
+        template <class F>
+        Instruction* withMode(AddressingMode mode, F f) {
+            switch (mode) {
+                case ADDR_MODE_DIRECT_DATA: return f(ModeTag<ADDR_MODE_DIRECT_DATA>());
+                case ADDR_MODE_DIRECT_ADDR: return f(ModeTag<ADDR_MODE_DIRECT_ADDR>());
+                case ADDR_MODE_INDIRECT: return f(ModeTag<ADDR_MODE_INDIRECT>());
+                case ADDR_MODE_INDIRECT_POSTINCREMENT: return f(ModeTag<ADDR_MODE_INDIRECT_POSTINCREMENT>());
+                case ADDR_MODE_INDIRECT_PREDECREMENT: return f(ModeTag<ADDR_MODE_INDIRECT_PREDECREMENT>());
+                default: return nullptr;
+            }
+        }
+
+        template <class F>
+        Instruction* withSize(DataSize size, F f) {
+            switch (size) {
+                case SIZE_BYTE: return f(SizeTag<SIZE_BYTE>());
+                case SIZE_WORD: return f(SizeTag<SIZE_WORD>());
+                case SIZE_LONG: return f(SizeTag<SIZE_LONG>());
+            }
+            return nullptr;
+        }
     }
 }
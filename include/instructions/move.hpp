@@ -5,7 +5,7 @@
 namespace M68K{
     namespace INSTRUCTION{
         class Move : public Instruction{
-        private:
+        protected:
             AddressingMode dest_mode = ADDR_MODE_UNKNOWN;
             AddressingMode src_mode = ADDR_MODE_UNKNOWN;
 
@@ -21,6 +21,8 @@ namespace M68K{
             std::string disassembly(CPUState& cpu_state) override;
 
             static std::unique_ptr<INSTRUCTION::Instruction> create(uint16_t opcode);
+            // constructs a form specialized on the addressing modes and size where there is one
+            static Instruction* construct(uint16_t opcode, void* place);
         };
     }
 }
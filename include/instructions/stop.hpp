@@ -0,0 +1,16 @@
+#pragma once
+#include "instruction.hpp"
+#include <memory>
+
+namespace M68K{
+    namespace INSTRUCTION{
+        class Stop : public Instruction{
+        public:
+            Stop(uint16_t opcode);
+            void execute(CPUState& cpu_state) override;
+            std::string disassembly(CPUState& cpu_state) override;
+
+            static std::unique_ptr<INSTRUCTION::Instruction> create(uint16_t opcode);
+        };
+    }
+}
@@ -5,7 +5,7 @@
 namespace M68K{
     namespace INSTRUCTION{
         class Subq : public Instruction{
-        private:
+        protected:
             AddressingMode dest_mode = ADDR_MODE_DIRECT_DATA;
             RegisterType dest_reg = REG_D0;
 
@@ -17,6 +17,8 @@ namespace M68K{
             std::string disassembly(CPUState& cpu_state) override;
 
             static std::unique_ptr<INSTRUCTION::Instruction> create(uint16_t opcode);
+            // constructs a form specialized on the addressing modes and size where there is one
+            static Instruction* construct(uint16_t opcode, void* place);
         };
     }
 }
@@ -0,0 +1,18 @@
+#pragma once
+#include "instruction.hpp"
+#include <memory>
+
+namespace M68K{
+    namespace INSTRUCTION{
+        class Trap : public Instruction{
+        private:
+            uint16_t vector = 0;
+        public:
+            Trap(uint16_t opcode);
+            void execute(CPUState& cpu_state) override;
+            std::string disassembly(CPUState& cpu_state) override;
+
+            static std::unique_ptr<INSTRUCTION::Instruction> create(uint16_t opcode);
+        };
+    }
+}
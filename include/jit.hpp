@@ -0,0 +1,65 @@
+#pragma once
+#include "block_cache.hpp"
+#include "cpu_state.hpp"
+
+#include <cstddef>
+#include <memory>
+
+#if M68K_JIT
+
+namespace M68K {
+
+struct JitContext {
+    CPUState* state = nullptr;
+};
+
+
+// Translates hot basic blocks to x86-64 code.
+//
+// Register, immediate and simple memory forms of MOVE, MOVEQ, ADD, SUB, AND, OR, EOR, CMP,
+// ADDQ, SUBQ, TST, CLR, LEA and Bcc are compiled natively, every other instruction calls its
+// interpreter implementation. The most used guest registers live in host registers, memory
+// goes through IMemory. CCR bits are only computed where a later instruction, a fallback,
+// a possible memory fault or the block exit can observe them.
+// Native code runs in user mode only, supervisor mode stays interpreted.
+//
+// The compilers of a thread share one code buffer, mapped on the first compile. Its pages are
+// writable only while a block is copied in and executable otherwise. A full buffer is reset by
+// the compiler that finds it full, the others see their code gone through exhausted().
+class JitCompiler {
+public:
+    static const std::size_t CODE_SIZE = 4 * 1024 * 1024;
+    static const uint32_t THRESHOLD = 16;
+
+    bool enabled = true;
+    uint32_t threshold = THRESHOLD;  // interpreted runs before a block is compiled
+
+public:
+    JitCompiler() = default;
+    JitCompiler(JitCompiler&& other) = default;
+    JitCompiler& operator=(JitCompiler&& other) = default;
+
+    // Takes the code buffer of the calling thread, compile() writes to it from then on. Returns
+    // true if the blocks compiled so far are in the buffer of another thread and have to be
+    // dropped before clear(), that thread may reset it at any time.
+    bool attach();
+
+    // Sets block.native. Returns false if the block was not compiled.
+    bool compile(BasicBlock& block, CPUState& state);
+
+    // The code buffer ran out of space or was reset by another compiler, blocks referencing it
+    // have to be dropped before clear().
+    bool exhausted() const;
+    void clear();
+
+private:
+    struct CodeBuffer;
+    std::shared_ptr<CodeBuffer> buffer;  // nullptr until attach()
+    uint64_t generation = 0;  // of the buffer when the native code of the blocks was written
+};  // class JitCompiler
+//////////////////////////////////////////////////////////////////////////
+
+
+}  // namespace M68K
+
+#endif  // M68K_JIT
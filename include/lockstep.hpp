@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "cpu.hpp"
+#include "memory_bus.hpp"
+
+namespace M68K {
+
+// Runs one program on many CPUs ("lanes") at once, e.g. for input sweeps or differential tests.
+//
+// The registers of all lanes are kept as a structure of arrays, REGS_COUNT arrays of lane_count
+// values. Each step picks the lowest PC of the running lanes, or the PC of a lane that waited
+// wait_limit steps, and executes the instruction there on every lane at that PC. Register forms
+// of MOVEQ, MOVE, ADD, SUB, AND, OR, EOR, CMP, ADDQ, SUBQ, TST, CLR and Bcc run as loops over the
+// register arrays, which the compiler vectorizes, see M68K_LOCKSTEP_AVX2. Every other instruction is executed by the interpreter, one lane after the
+// other. Lanes that diverge on a branch run on their own until their PCs meet again.
+//
+// Each lane is a clone() of the prototype CPU, its memory is shared copy-on-write. The code is
+// decoded once from the memory of lane 0, lanes must not modify it.
+class LockstepEngine {
+public:
+    LockstepEngine(BasicCPU<MemoryBus>& prototype, std::size_t lane_count);
+    ~LockstepEngine();
+
+    std::size_t laneCount() const {
+        return this->lane_count;
+    }
+    MemoryBus& memory(std::size_t lane) {
+        return this->lanes[lane]->memory;
+    }
+
+    // registers of a lane, without mapping A7 to the stack pointer of the current mode
+    uint32_t get(std::size_t lane, RegisterType reg) const {
+        return this->bank[reg * this->lane_count + lane];
+    }
+    void set(std::size_t lane, RegisterType reg, uint32_t value) {
+        this->bank[reg * this->lane_count + lane] = value;
+    }
+    Registers registers(std::size_t lane) const;
+
+    // Steps a running lane waits at most for the lanes at lower PCs, e.g. one that polls a
+    // flag in a loop, before the engine steps the lanes at its PC.
+    uint32_t wait_limit = 64;
+
+    // Steps until every lane reached stop_pc, halted or executed STOP, or after step_limit steps.
+    // Returns the number of instructions executed by all lanes together.
+    uint64_t run(uint64_t step_limit, uint32_t stop_pc);
+
+    bool stopped(std::size_t lane, uint32_t stop_pc) const {
+        return this->get(lane, REG_PC) == stop_pc;
+    }
+
+private:
+    struct Op;
+
+    const Op& decode(uint32_t pc);
+    void executeScalar(std::size_t lane, INSTRUCTION::Instruction* instruction);
+
+    uint32_t* bankOf(RegisterType reg) {
+        return this->bank.data() + reg * this->lane_count;
+    }
+
+    std::size_t lane_count;
+    std::vector<std::unique_ptr<BasicCPU<MemoryBus>>> lanes;
+    std::vector<uint32_t> bank;     // REGS_COUNT arrays of lane_count registers
+    std::vector<uint32_t> mask;     // ~0 for the lanes taking part in the current step
+    std::vector<uint32_t> operand;  // immediate of the current step for every lane
+    std::vector<uint32_t> waiting;  // steps since the lane took part in one
+    std::unordered_map<uint32_t, std::unique_ptr<Op>> ops;
+};
+
+}  // namespace M68K
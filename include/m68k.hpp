@@ -1 +1,5 @@
 #include "cpu.hpp"
+#include "elf_loader.hpp"
+#include "snapshot_image.hpp"
+#include "batch_runner.hpp"
+#include "lockstep.hpp"
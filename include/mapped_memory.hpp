@@ -0,0 +1,24 @@
+#pragma once
+#include "memory.hpp"
+
+
+namespace M68K {
+
+// Guest memory reserved with mmap (VirtualAlloc on Windows). The host commits and zero-fills
+// a page on its first touch, so an instance costs only the pages the guest program uses.
+class MappedMemory final : public BaseMemory {
+public:
+    MappedMemory();
+    virtual ~MappedMemory();
+
+    MappedMemory(const MappedMemory&) = delete;
+    MappedMemory& operator=(const MappedMemory&) = delete;
+
+private:
+    // throws std::bad_alloc when the address space can not be reserved
+    static void* reserve(std::size_t size);
+};  // class MappedMemory
+//////////////////////////////////////////////////////////////////////////
+
+
+};  // namespace M68K
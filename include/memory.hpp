@@ -3,6 +3,7 @@
 #include <vector>
 
 #include "defines.hpp"
+#include "helpers.hpp"
 
 namespace M68K {
 
@@ -17,6 +18,11 @@ public:
         set(address, sz, (uint32_t)val);
     }
 
+    // Byte ranges in guest order. The defaults go through get()/set() one byte at a time.
+    virtual void read_block(std::size_t address, uint8_t* data, std::size_t size);
+    virtual void write_block(std::size_t address, const uint8_t* data, std::size_t size);
+    virtual void fill(std::size_t address, uint8_t value, std::size_t size);
+
     static uint32_t read_real_mem(void* mem_addr, DataSize size);
     static void write_real_mem(void* mem_addr, DataSize size, uint32_t data);
 
@@ -27,14 +33,107 @@ public:
 
 
 
-class BaseMemory : public IMemory {
+// Copy of a BaseMemory, see BaseMemory::snapshot()
+struct MemorySnapshot {
+    std::vector<uint8_t> data;
+    uint64_t generation = 0;  // unique among the snapshots of all memories, 0 for none
+};
+
+
+
+// Pages holding the code of cached blocks, see CPUCore::run(). The first write to a watched
+// page, by the guest or by the host through the memory, lists the page in writtenCode() and
+// ends its watch. BaseMemory and MemoryBus report the writes to their RAM, host memory
+// written past them is not seen.
+class CodeWatch {
+public:
+    static const uint32_t CODE_PAGE_SHIFT = 12;
+
+    // watches the pages of [start, end)
+    void watchCode(uint32_t start, uint32_t end);
+    const std::vector<uint32_t>& writtenCode() const noexcept {
+        return this->written_code;
+    }
+    void clearWrittenCode() noexcept {
+        this->written_code.clear();
+    }
+
+protected:
+    explicit CodeWatch(std::size_t size) : code_page_count((uint32_t)((size + (1u << CODE_PAGE_SHIFT) - 1) >> CODE_PAGE_SHIFT)) {
+    }
+    // a write of size bytes, one test while no page is watched
+    void codeWrite(std::size_t address, DataSize size) noexcept {
+        if (this->code_map.empty())
+            return;
+        uint32_t first = (uint32_t)address >> CODE_PAGE_SHIFT;
+        uint32_t last = (uint32_t)(address + size - 1) >> CODE_PAGE_SHIFT;
+        if (this->code_map[first])
+            this->codeWritten(first);
+        if (this->code_map[last])
+            this->codeWritten(last);
+    }
+    void codeWriteRange(std::size_t address, std::size_t size) noexcept;
+
+private:
+    void codeWritten(uint32_t page) noexcept;
+
+    uint32_t code_page_count;
+    std::vector<uint8_t> code_map;  // one flag per page, empty until the first watchCode()
+    std::vector<uint32_t> written_code;
+};  // class CodeWatch
+//////////////////////////////////////////////////////////////////////////
+
+
+
+// Flat guest memory. get() and set() are final and inline, so CPUState calls them without
+// going through the vtable, see CPUState::readMemory()
+class BaseMemory : public IMemory, public CodeWatch {
 public:
+    static const uint32_t DIRTY_PAGE_SHIFT = 12;
+    static const uint32_t DIRTY_PAGE_SIZE = 1u << DIRTY_PAGE_SHIFT;
+
     uint8_t* baseAddr = nullptr;
     uint32_t memSize = 0;
 public:
     BaseMemory(void* _baseAddr, uint32_t _size);
-    virtual uint32_t get(std::size_t address, DataSize size) override;
-    virtual void set(std::size_t address, DataSize size, uint32_t data) override;
+    virtual uint32_t get(std::size_t address, DataSize size) override final;
+    virtual void set(std::size_t address, DataSize size, uint32_t data) override final;
+
+    // get()/set() without the checks, for an even address that passed contains().
+    // CPUState reports the faults of guest accesses this way instead of by exceptions.
+    bool contains(std::size_t address, DataSize size) const noexcept {
+        return MASK_ADDR(address) + size <= this->memSize;
+    }
+    uint32_t load(std::size_t address, DataSize size) noexcept;
+    void store(std::size_t address, DataSize size, uint32_t data) noexcept;
+
+    virtual void read_block(std::size_t address, uint8_t* data, std::size_t size) override;
+    virtual void write_block(std::size_t address, const uint8_t* data, std::size_t size) override;
+    virtual void fill(std::size_t address, uint8_t value, std::size_t size) override;
+
+    // Copies the whole memory and starts tracking the pages written by set().
+    // restore() copies back only the pages written since the last snapshot() or restore() when
+    // the snapshot is the one taken or restored last, any other snapshot is copied whole.
+    MemorySnapshot snapshot();
+    void restore(const MemorySnapshot& snapshot);
+
+    // indices of the DIRTY_PAGE_SIZE pages written since the last snapshot() or restore()
+    const std::vector<uint32_t>& dirtyPages() const {
+        return this->dirty_pages;
+    }
+    bool tracksDirtyPages() const {
+        return !this->dirty_map.empty();
+    }
+
+private:
+    void checkAccess(std::size_t address, DataSize size) const;
+    void checkBlock(std::size_t address, std::size_t size) const;
+    void markDirty(uint32_t page);
+    void markDirty(std::size_t address, std::size_t size);
+
+    std::vector<uint8_t> dirty_map;  // one flag per page, empty while nothing is tracked
+    std::vector<uint32_t> dirty_pages;
+    uint64_t generation = 0;  // of the snapshot the dirty pages are relative to
 };  // class BaseMemory
 //////////////////////////////////////////////////////////////////////////
 
@@ -50,4 +149,114 @@ public:
 //////////////////////////////////////////////////////////////////////////
 
 
+
+inline uint32_t IMemory::read_real_mem(void* mem_addr, DataSize size) {
+    uint8_t* addr = (uint8_t*)(mem_addr);
+    uint32_t output_data = 0;
+    switch (size) {
+        case DataSize::SIZE_BYTE:
+            output_data = addr[0];
+            break;
+#if M68K_BSWAP_MEMORY
+        case DataSize::SIZE_WORD:
+            output_data = LOAD_BE_16(addr);
+            break;
+        case DataSize::SIZE_LONG:
+            output_data = LOAD_BE_32(addr);
+            break;
+#else
+        case DataSize::SIZE_WORD:
+            output_data = addr[0];
+            output_data = (output_data << 8) | addr[1];
+            break;
+        case DataSize::SIZE_LONG:
+            output_data = addr[0];
+            output_data = (output_data << 8) | addr[1];
+            output_data = (output_data << 8) | addr[2];
+            output_data = (output_data << 8) | addr[3];
+            break;
+#endif
+        default:
+            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+    }
+    return output_data;
+}
+
+
+inline void IMemory::write_real_mem(void* mem_addr, DataSize size, uint32_t data) {
+    uint8_t* addr = (uint8_t*)(mem_addr);
+    switch (size) {
+        case DataSize::SIZE_BYTE:
+            addr[0] = (uint8_t)MASK_8(data);
+            break;
+#if M68K_BSWAP_MEMORY
+        case DataSize::SIZE_WORD:
+            STORE_BE_16(addr, (uint16_t)data);
+            break;
+        case DataSize::SIZE_LONG:
+            STORE_BE_32(addr, data);
+            break;
+#else
+        case DataSize::SIZE_WORD:
+            addr[0] = (uint8_t)MASK_8(data >> 8);
+            addr[1] = (uint8_t)MASK_8(data);
+            break;
+        case DataSize::SIZE_LONG:
+            addr[0] = (uint8_t)MASK_8(data >> 24);
+            addr[1] = (uint8_t)MASK_8(data >> 16);
+            addr[2] = (uint8_t)MASK_8(data >> 8);
+            addr[3] = (uint8_t)MASK_8(data);
+            break;
+#endif
+        default:
+            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+    }
+}
+
+
+inline void BaseMemory::checkAccess(std::size_t address, DataSize size) const {
+    if((size != DataSize::SIZE_BYTE) && (address % 2 != 0)){ // only even is valid in word and long mode
+        throw std::length_error("Memory address must be even."); //TODO: Throw special exception
+    }
+    if(address + size > this->memSize){ // memory out of range.
+        throw std::out_of_range(
+            "Memory address out of range. " +
+            std::to_string(address) + ">" + std::to_string(memSize)
+        ); //TODO: Throw special exception
+    }
+}
+
+
+inline uint32_t BaseMemory::get(std::size_t address, DataSize size){
+    this->checkAccess(MASK_ADDR(address), size);
+    return this->load(address, size);
+}
+
+
+inline void BaseMemory::set(std::size_t address, DataSize size, uint32_t data){
+    this->checkAccess(MASK_ADDR(address), size);
+    this->store(address, size, data);
+}
+
+
+inline uint32_t BaseMemory::load(std::size_t address, DataSize size) noexcept {
+    return read_real_mem(&baseAddr[MASK_ADDR(address)], size);
+}
+
+
+inline void BaseMemory::store(std::size_t address, DataSize size, uint32_t data) noexcept {
+    address = MASK_ADDR(address);
+    write_real_mem(&baseAddr[address], size, data);
+    this->codeWrite(address, size);
+    if(!this->dirty_map.empty()){
+        uint32_t first = (uint32_t)address >> DIRTY_PAGE_SHIFT;
+        uint32_t last = (uint32_t)(address + size - 1) >> DIRTY_PAGE_SHIFT;
+        if(!this->dirty_map[first])
+            this->markDirty(first);
+        if(!this->dirty_map[last])
+            this->markDirty(last);
+    }
+}
+
+
 }  // namespace M68K
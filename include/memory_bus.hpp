@@ -0,0 +1,212 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "memory.hpp"
+#include "helpers.hpp"
+
+namespace M68K {
+
+enum PageAccess {
+    PAGE_NONE = 0,
+    PAGE_READ = 1,
+    PAGE_WRITE = 2,
+    PAGE_READ_WRITE = PAGE_READ | PAGE_WRITE,
+};
+
+
+// 24 bit address space split into 4 KB pages.
+//
+// RAM and ROM pages hold a host pointer and are accessed inline by read()/write(). MMIO pages
+// forward to a device, any IMemory, with the address relative to the start of its mapping.
+// Accesses to unmapped pages throw std::out_of_range, writes to read-only pages are ignored.
+// CPUState checks mapped() first and raises a bus error instead.
+// The bus does not own the host memory or the devices, except for RAM added by mapRam().
+// Writes to RAM through the bus and new mappings end the watch of code pages, see CodeWatch.
+class MemoryBus final : public IMemory, public CodeWatch {
+public:
+    static const uint32_t PAGE_SHIFT = 12;
+    static const uint32_t PAGE_SIZE = 1u << PAGE_SHIFT;
+    static const uint32_t PAGE_COUNT = (uint32_t)(MEMORY_SIZE >> PAGE_SHIFT);
+
+public:
+    MemoryBus() : CodeWatch(MEMORY_SIZE) {
+    }
+    MemoryBus(const MemoryBus&) = delete;  // see shareFrom()
+    MemoryBus& operator=(const MemoryBus&) = delete;
+
+    // base and size have to be multiples of PAGE_SIZE, a new mapping replaces the old one
+    void mapMemory(uint32_t base, uint32_t size, uint8_t* host, PageAccess access = PAGE_READ_WRITE);
+    void mapDevice(uint32_t base, uint32_t size, IMemory* device);
+    void unmap(uint32_t base, uint32_t size);
+
+    // zero-filled RAM owned by the bus, a page gets host memory on its first write
+    void mapRam(uint32_t base, uint32_t size);
+    // RAM like mapRam() that starts with the content of data, which is only read. The bus keeps
+    // owner alive for as long as a page may still read from data.
+    void mapRam(uint32_t base, uint32_t size, const uint8_t* data, std::shared_ptr<const void> owner);
+    // read-only pages of data, the bus keeps owner alive like mapRam()
+    void mapRom(uint32_t base, uint32_t size, const uint8_t* data, std::shared_ptr<const void> owner);
+
+    // Replaces this mapping with the one of source. RAM from mapRam() is shared copy-on-write,
+    // both buses copy a shared page on their next write to it. Memory mapped by mapMemory() and
+    // devices are shared as they are. It changes the pages of source too, so nothing may access
+    // source meanwhile: stop the CPU that runs on it first.
+    void shareFrom(MemoryBus& source);
+
+    // some page is mapped to a device, reads may change without a write
+    bool hasDevices() const {
+        return this->device_pages > 0;
+    }
+    // An access of size at address does not throw: a readable page or a device for PAGE_READ,
+    // any mapping for PAGE_WRITE as writes to read-only pages are ignored. The address is even.
+    bool mapped(std::size_t address, DataSize size, PageAccess access) const noexcept {
+        uint32_t addr = (uint32_t)MASK_ADDR(address);
+        return mapped(this->pages[addr >> PAGE_SHIFT], access) &&
+               (inPage(addr, size) || mapped(this->pages[(uint32_t)MASK_ADDR(addr + size - 1) >> PAGE_SHIFT], access));
+    }
+    // the page of address is mapped to a device
+    bool isDevicePage(std::size_t address) const {
+        return this->pages[(uint32_t)MASK_ADDR(address) >> PAGE_SHIFT].device != nullptr;
+    }
+
+    // access of the host memory of the page of address, PAGE_NONE for devices and unmapped pages
+    PageAccess pageAccess(std::size_t address) const {
+        const Page& page = this->pages[(uint32_t)MASK_ADDR(address) >> PAGE_SHIFT];
+        if (page.owned)
+            return PAGE_READ_WRITE;
+        return (PageAccess)((page.read ? PAGE_READ : PAGE_NONE) | (page.write ? PAGE_WRITE : PAGE_NONE));
+    }
+
+    // host address of a RAM or ROM byte, nullptr if the page is MMIO, unmapped or lacks the access right
+    uint8_t* hostPointer(std::size_t address, PageAccess access) const;
+
+    template <DataSize Size>
+    uint32_t read(std::size_t address);
+    template <DataSize Size>
+    void write(std::size_t address, uint32_t data);
+
+    virtual uint32_t get(std::size_t address, DataSize size) override;
+    virtual void set(std::size_t address, DataSize size, uint32_t data) override;
+
+    // memcpy per RAM page, device and read-only pages take the byte path of get()/set()
+    virtual void read_block(std::size_t address, uint8_t* data, std::size_t size) override;
+    virtual void write_block(std::size_t address, const uint8_t* data, std::size_t size) override;
+    virtual void fill(std::size_t address, uint8_t value, std::size_t size) override;
+
+private:
+    struct Page {
+        uint8_t* read = nullptr;  // page start in host memory, nullptr sends reads to the slow path
+        uint8_t* write = nullptr;
+        IMemory* device = nullptr;
+        uint32_t device_base = 0;  // guest address of the start of the device mapping
+        bool owned = false;  // RAM of mapRam(), write is nullptr until the page is private
+    };
+
+    static bool mapped(const Page& page, PageAccess access) noexcept {
+        return page.read || page.device || ((access & PAGE_WRITE) && page.write);
+    }
+    static bool inPage(uint32_t address, DataSize size) {
+        return (address & (PAGE_SIZE - 1)) <= PAGE_SIZE - size;
+    }
+    static void checkAlignment(uint32_t address, DataSize size) {
+        if ((size != SIZE_BYTE) && (address % 2 != 0)) {  // only even is valid in word and long mode
+            throw std::length_error("Memory address must be even.");
+        }
+    }
+    void checkRange(uint32_t base, uint32_t size) const;
+    Page& resetPage(uint32_t address);
+    void makePrivate(uint32_t index);
+    // host memory of a write to the page of address, nullptr if it has to go through set()
+    uint8_t* writablePage(uint32_t address);
+
+    uint32_t readSlow(uint32_t address, DataSize size);
+    void writeSlow(uint32_t address, DataSize size, uint32_t data);
+
+    Page pages[PAGE_COUNT];
+    uint32_t device_pages = 0;
+    std::vector<std::shared_ptr<uint8_t>> frames;  // host memory of owned pages, empty until mapRam()
+    std::vector<std::shared_ptr<const void>> owners;  // initial content of mapRam() pages
+};  // class MemoryBus
+//////////////////////////////////////////////////////////////////////////
+
+
+
+template <DataSize Size>
+uint32_t MemoryBus::read(std::size_t address) {
+    uint32_t addr = (uint32_t)MASK_ADDR(address);
+    checkAlignment(addr, Size);
+    const uint8_t* page = this->pages[addr >> PAGE_SHIFT].read;
+    if (page && inPage(addr, Size)) {
+        const uint8_t* p = page + (addr & (PAGE_SIZE - 1));
+        switch (Size) {
+            case SIZE_BYTE:
+                return p[0];
+            case SIZE_WORD:
+                return LOAD_BE_16(p);
+            case SIZE_LONG:
+                return LOAD_BE_32(p);
+        }
+    }
+    return this->readSlow(addr, Size);
+}
+
+
+template <DataSize Size>
+void MemoryBus::write(std::size_t address, uint32_t data) {
+    uint32_t addr = (uint32_t)MASK_ADDR(address);
+    checkAlignment(addr, Size);
+    uint8_t* page = this->pages[addr >> PAGE_SHIFT].write;
+    if (page && inPage(addr, Size)) {
+        uint8_t* p = page + (addr & (PAGE_SIZE - 1));
+        switch (Size) {
+            case SIZE_BYTE:
+                p[0] = (uint8_t)data;
+                break;
+            case SIZE_WORD:
+                STORE_BE_16(p, (uint16_t)data);
+                break;
+            case SIZE_LONG:
+                STORE_BE_32(p, data);
+                break;
+        }
+        this->codeWrite(addr, Size);
+        return;
+    }
+    this->writeSlow(addr, Size, data);
+}
+
+
+inline uint32_t MemoryBus::get(std::size_t address, DataSize size) {
+    switch (size) {
+        case SIZE_BYTE:
+            return this->read<SIZE_BYTE>(address);
+        case SIZE_WORD:
+            return this->read<SIZE_WORD>(address);
+        case SIZE_LONG:
+            return this->read<SIZE_LONG>(address);
+        default:
+            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+    }
+}
+
+
+inline void MemoryBus::set(std::size_t address, DataSize size, uint32_t data) {
+    switch (size) {
+        case SIZE_BYTE:
+            this->write<SIZE_BYTE>(address, data);
+            break;
+        case SIZE_WORD:
+            this->write<SIZE_WORD>(address, data);
+            break;
+        case SIZE_LONG:
+            this->write<SIZE_LONG>(address, data);
+            break;
+        default:
+            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+    }
+}
+
+}  // namespace M68K
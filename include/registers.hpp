@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <cstddef>
 #include <array>
+#include <cassert>
 
 #include "defines.hpp"
 
@@ -40,6 +41,17 @@ namespace M68K {
         SR_FLAG_TRACE = (1 << 15)
     };
 
+    // How an ALU instruction sets the condition codes, see Registers::setFlags
+    enum FlagsOperation : uint8_t {
+        FLAGS_NONE = 0,  // SR holds the current flags
+        FLAGS_ADD,       // XNZVC of dest + src
+        FLAGS_SUB,       // XNZVC of dest - src
+        FLAGS_CMP,       // NZVC of dest - src
+        FLAGS_LOGIC,     // NZ of dest, V and C cleared
+        FLAGS_SHIFT,     // NZ of dest, V cleared, X and C set to src
+        FLAGS_ROTATE,    // NZ of dest, V cleared, C set to src
+    };
+
 
     class Registers {
     public:
@@ -89,6 +101,50 @@ namespace M68K {
         bool get(StatusRegisterFlag flag);
         void set(StatusRegisterFlag flag, bool value);
 
+        // Sets the condition codes of an ALU instruction. With M68K_LAZY_FLAGS only the
+        // operation is recorded, the flags are computed on the next read of SR or of a flag.
+        void setFlags(FlagsOperation op, DataSize size, uint32_t src, uint32_t dest) {
+#if M68K_LAZY_FLAGS
+            // X survives compare and logic instructions
+            if (this->flags_op != FLAGS_NONE && !(flagsMask(op) & SR_FLAG_EXTEND))
+                resolveFlags();
+            this->flags_op = op;
+            this->flags_size = size;
+            this->flags_src = src;
+            this->flags_dest = dest;
+#else
+            uint32_t mask = flagsMask(op);
+            this->reg_buffer[REG_SR] = (this->reg_buffer[REG_SR] & ~mask) | computeFlags(op, size, src, dest);
+#endif
+        }
+
+        // Writes pending condition codes to SR. Needed before SR is read directly
+        // through reg_buffer or the sr bit fields.
+        void materializeFlags() {
+#if M68K_LAZY_FLAGS
+            if (this->flags_op != FLAGS_NONE)
+                resolveFlags();
+#endif
+        }
+
+        // get()/set() with the size known at compile time, for data and address registers only
+        template <DataSize Size>
+        uint32_t get(RegisterType reg_ind) {
+            assert(reg_ind <= REG_A7);
+            if (reg_ind == REG_A7 && sr.supervisor)
+                reg_ind = REG_SSP;
+            return this->reg_buffer[reg_ind] & sizeMask(Size);
+        }
+
+        template <DataSize Size>
+        void set(RegisterType reg_ind, uint32_t data) {
+            assert(reg_ind <= REG_A7);
+            if (reg_ind == REG_A7 && sr.supervisor)
+                reg_ind = REG_SSP;
+            const uint32_t mask = sizeMask(Size);
+            this->reg_buffer[reg_ind] = (this->reg_buffer[reg_ind] & ~mask) | (data & mask);
+        }
+
         uint32_t& stack_ptr() {
             return sr.supervisor ? ssp : usp;
         }
@@ -98,5 +154,36 @@ namespace M68K {
             DataSize sz = (DataSize)(sizeof(T));
             set(reg_ind, sz, (uint32_t)val);
         }
+
+    private:
+        static constexpr uint32_t sizeMask(DataSize size) {
+            return size == SIZE_BYTE ? 0xff : size == SIZE_WORD ? 0xffff : 0xffffffff;
+        }
+
+        static uint32_t flagsMask(FlagsOperation op) {
+            switch (op) {
+                case FLAGS_ADD:
+                case FLAGS_SUB:
+                case FLAGS_SHIFT:
+                    return SR_FLAG_EXTEND | SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY;
+                case FLAGS_CMP:
+                case FLAGS_LOGIC:
+                case FLAGS_ROTATE:
+                    return SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY;
+                case FLAGS_NONE:
+                    break;
+            }
+            return 0;
+        }
+        static uint32_t computeFlags(FlagsOperation op, DataSize size, uint32_t src, uint32_t dest);
+
+#if M68K_LAZY_FLAGS
+        void resolveFlags();
+
+        FlagsOperation flags_op = FLAGS_NONE;
+        DataSize flags_size = SIZE_BYTE;
+        uint32_t flags_src = 0;
+        uint32_t flags_dest = 0;
+#endif
     };
 }
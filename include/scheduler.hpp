@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace M68K {
+
+// Device events keyed on CPU cycles, see CPUState::cycles.
+//
+// A min-heap on the deadline, the earliest one is kept in deadline() for the run loop.
+// CPUCore::run() executes blocks up to the next deadline and calls the due events at the
+// instruction boundary their deadline falls on, the same one step() calls them at. Without a due
+// event this costs one comparison per block and nothing per instruction. Events need M68K_CYCLES.
+class Scheduler {
+public:
+    typedef uint64_t EventId;
+    // gets the cycle the event is called at, which is at or after its deadline
+    typedef std::function<void(uint64_t now)> Callback;
+
+    static const uint64_t NEVER = std::numeric_limits<uint64_t>::max();
+
+    Scheduler() = default;
+    Scheduler(const Scheduler&) = delete;  // the callbacks belong to the devices of one CPU
+    Scheduler& operator=(const Scheduler&) = delete;
+    Scheduler(Scheduler&&) = default;
+    Scheduler& operator=(Scheduler&&) = default;
+
+    // Calls callback once the CPU reached cycle. Events of the same cycle are called in the order
+    // they were scheduled. A callback may schedule and cancel events, also for the current cycle.
+    EventId schedule(uint64_t cycle, Callback callback);
+    // false if the event was called or cancelled already
+    bool cancel(EventId id);
+    void clear();
+
+    // cycle of the earliest event, NEVER without events
+    uint64_t deadline() const {
+        return this->next;
+    }
+    bool empty() const {
+        return this->events.empty();
+    }
+    std::size_t size() const {
+        return this->events.size();
+    }
+
+    // calls the events with a deadline up to now
+    void dispatch(uint64_t now);
+
+private:
+    struct Event {
+        uint64_t cycle;
+        EventId id;
+        Callback callback;
+    };
+    // heap order of std::push_heap(), the earliest event at the front
+    static bool later(const Event& a, const Event& b) {
+        return a.cycle != b.cycle ? a.cycle > b.cycle : a.id > b.id;
+    }
+    void update() {
+        this->next = this->events.empty() ? NEVER : this->events.front().cycle;
+    }
+
+    std::vector<Event> events;
+    EventId next_id = 1;
+    uint64_t next = NEVER;
+};  // class Scheduler
+
+}  // namespace M68K
@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+
+#include "cpu.hpp"
+
+namespace M68K {
+
+// Snapshot image file: header, register file, run state and the readable pages of guest memory.
+//
+//   char[8]  "M68KIMG2"
+//   uint32   page size, register count, page count (little-endian)
+//   uint32   registers[register count]
+//   uint32   flags (1 halted, 2 stopped), cycles (low, high), requested interrupt levels
+//   uint8    interrupt vectors[8]
+//   uint32   guest address of each page, ored with 1 for a read-only page and 2 for a page
+//            of zeros that has no data in the file
+//   ...      page data, aligned to the page size so the file can be mapped as is
+//
+// All functions return false if the file can not be written, read or is not an image.
+// Loading clears the block and JIT caches and a pending exception.
+
+// Unmapped and MMIO device pages of a MemoryBus are skipped, reading a device may change it.
+bool save_image(CPUCore* cpu, const std::string& file_name);
+
+// Copies the pages into memory with write_block() and zeros all other pages but those of
+// devices. The mapping of a MemoryBus stays as it is, writes to its ROM are ignored.
+bool load_image(CPUCore* cpu, const std::string& file_name);
+
+// Maps the file read-only and replaces the mapping of the bus by the one of the image: RAM
+// pages become copy-on-write RAM, see MemoryBus::mapRam(), ROM pages read-only memory and
+// pages that are not in the image are unmapped. Device pages stay as they are. Nothing is
+// copied until the guest writes to a page.
+bool load_image(BasicCPU<MemoryBus>* cpu, const std::string& file_name);
+
+}  // namespace M68K
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+#include "defines.hpp"
+
+namespace M68K {
+
+// Execution counters of one thread, kept with M68K_STATS. Without it the hooks in the CPU
+// compile to nothing and this file declares only the types.
+//
+// Every executed instruction counts its opcode, native blocks included. The histograms of
+// handlers and addressing modes are derived from the opcodes when they are written, the modes
+// only estimated from the ea fields of the opcode, see "mode_estimate". Memory
+// counts are the accesses of CPUState::readMemory() and writeMemory(): operands, the stack,
+// the opcodes of blocks being recorded and the extension words the interpreter reads, not the
+// ones compiled into native code.
+struct alignas(64) ExecutionStats {
+    uint64_t reads = 0;
+    uint64_t read_bytes = 0;
+    uint64_t writes = 0;
+    uint64_t write_bytes = 0;
+    alignas(64) uint64_t opcodes[0x10000] = {};
+
+    uint64_t instructions() const;
+    void reset();
+    ExecutionStats& operator+=(const ExecutionStats& other);
+};
+
+#if M68K_STATS
+namespace STATS {
+// owner of the counters of a thread, adds them to total() when the thread ends
+struct LocalStats {
+    ExecutionStats stats;
+    LocalStats();
+    ~LocalStats();
+};
+
+// counters of the calling thread
+inline ExecutionStats& local() {
+    static thread_local LocalStats counters;
+    return counters.stats;
+}
+// Sum of the counters of all threads into sum, sum is a static or thread_local as it does not
+// fit on a stack. Running threads are read without synchronization, call it while no CPU runs.
+void total(ExecutionStats& sum);
+// clears the counters of all threads, the same way
+void reset();
+
+// "kind,name,count" lines: memory counters, then handlers, estimated addressing modes (kind
+// "mode_estimate", "addressing_modes_estimate" in JSON) and opcodes by count
+void writeCsv(std::ostream& out, const ExecutionStats& stats);
+void writeJson(std::ostream& out, const ExecutionStats& stats);
+
+inline void countRead(DataSize size) {
+    ExecutionStats& stats = local();
+    stats.reads++;
+    stats.read_bytes += size;
+}
+inline void countWrite(DataSize size) {
+    ExecutionStats& stats = local();
+    stats.writes++;
+    stats.write_bytes += size;
+}
+}  // namespace STATS
+#endif
+
+}  // namespace M68K
@@ -0,0 +1,169 @@
+#include "batch_runner.hpp"
+#include "elf_loader.hpp"
+#include "snapshot_image.hpp"
+
+#include <exception>
+#include <thread>
+
+
+namespace M68K {
+
+namespace {
+
+// [begin, end) of job indices packed into one word, begin in the upper half
+uint64_t packRange(uint32_t begin, uint32_t end) {
+    return ((uint64_t)begin << 32) | end;
+}
+
+uint32_t rangeBegin(uint64_t range) {
+    return (uint32_t)(range >> 32);
+}
+
+uint32_t rangeEnd(uint64_t range) {
+    return (uint32_t)range;
+}
+
+}  // namespace
+
+
+struct BatchRunner::Worker {
+    CPU cpu;
+    std::string program;  // loaded into cpu, its start state is in initial
+    CPUSnapshot initial;
+    std::atomic<uint64_t> range{0};
+
+    // the first job of the range, taken by the owner
+    bool take(uint32_t& job) {
+        uint64_t current = this->range.load();
+        while (rangeBegin(current) < rangeEnd(current)) {
+            if (this->range.compare_exchange_weak(current, packRange(rangeBegin(current) + 1, rangeEnd(current)))) {
+                job = rangeBegin(current);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+
+BatchRunner::BatchRunner(unsigned thread_count) {
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    if (thread_count == 0) {
+        thread_count = 1;
+    }
+    for (unsigned i = 0; i < thread_count; i++) {
+        this->workers.emplace_back(new Worker());
+        this->workers.back()->cpu.state.memory.fill(0, 0, MEMORY_SIZE);
+    }
+}
+
+
+BatchRunner::~BatchRunner() = default;
+
+
+std::vector<BatchResult> BatchRunner::run(const std::vector<BatchJob>& jobs) {
+    std::vector<BatchResult> results(jobs.size());
+    const uint64_t count = jobs.size();
+    const uint64_t threads = this->workers.size();
+    for (uint64_t i = 0; i < threads; i++) {
+        this->workers[i]->range.store(packRange((uint32_t)(count * i / threads), (uint32_t)(count * (i + 1) / threads)));
+    }
+
+    std::vector<std::thread> pool;
+    for (size_t i = 1; i < this->workers.size(); i++) {
+        Worker& worker = *this->workers[i];
+        pool.emplace_back([this, &worker, &jobs, &results]() { this->work(worker, jobs, results); });
+    }
+    this->work(*this->workers[0], jobs, results);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    return results;
+}
+
+
+void BatchRunner::work(Worker& worker, const std::vector<BatchJob>& jobs, std::vector<BatchResult>& results) {
+    uint32_t job = 0;
+    while (worker.take(job) || this->steal(worker, job)) {
+        execute(worker, jobs[job], results[job]);
+    }
+}
+
+
+bool BatchRunner::steal(Worker& thief, uint32_t& job) {
+    for (std::unique_ptr<Worker>& victim : this->workers) {
+        if (victim.get() == &thief) {
+            continue;
+        }
+        uint64_t current = victim->range.load();
+        while (rangeBegin(current) < rangeEnd(current)) {
+            uint32_t begin = rangeBegin(current);
+            uint32_t end = rangeEnd(current);
+            uint32_t middle = begin + (end - begin) / 2;  // the victim keeps [begin, middle)
+            if (victim->range.compare_exchange_weak(current, packRange(begin, middle))) {
+                // only the owner refills its empty range, thieves skip it
+                thief.range.store(packRange(middle + 1, end));
+                job = middle;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+bool BatchRunner::prepare(Worker& worker, const std::string& program) {
+    // nothing of the previous job carries over but the block cache of the same program
+    worker.cpu.state.resetRunState();
+    worker.cpu.scheduler.clear();
+    if (!worker.program.empty() && worker.program == program) {
+        worker.cpu.restore(worker.initial);
+        return true;
+    }
+    worker.program.clear();
+    worker.cpu.state.memory.fill(0, 0, MEMORY_SIZE);
+    worker.cpu.state.registers = Registers();
+    if (!load_elf(&worker.cpu, program) && !load_image(&worker.cpu, program)) {
+        return false;
+    }
+    worker.initial = worker.cpu.snapshot();
+    worker.program = program;
+    return true;
+}
+
+
+void BatchRunner::execute(Worker& worker, const BatchJob& job, BatchResult& result) {
+    CPU& cpu = worker.cpu;
+    try {
+        result.loaded = prepare(worker, job.program);
+        if (!result.loaded) {
+            return;
+        }
+        if (!job.input.empty()) {
+            cpu.state.memory.write_block(job.input_address, job.input.data(), job.input.size());
+        }
+        if (cpu.state.registers.get(REG_PC, SIZE_LONG) == job.stop_pc) {
+            result.stopped = true;
+        } else {
+            RunLimits limits;
+            limits.instructions = job.max_instructions;
+            limits.breakpoints.push_back(job.stop_pc);
+            RunResult run = cpu.run(limits);
+            result.instructions = run.instructions;
+            result.stopped = run.reason == STOP_BREAKPOINT;
+            result.halted = run.reason == STOP_IDLE || run.reason == STOP_HALT;
+        }
+        if (job.output_size > 0) {
+            result.output.resize(job.output_size);
+            cpu.state.memory.read_block(job.output_address, result.output.data(), job.output_size);
+        }
+    } catch (const std::exception& e) {
+        result.error = e.what();
+    }
+    result.registers = cpu.state.registers;
+    result.registers.materializeFlags();
+}
+
+}  // namespace M68K
@@ -0,0 +1,89 @@
+#include "block_cache.hpp"
+
+#include <algorithm>
+
+namespace M68K {
+
+namespace {
+void unlinkFrom(std::vector<BasicBlock*>& blocks, BasicBlock* block) {
+    auto it = std::find(blocks.begin(), blocks.end(), block);
+    if (it != blocks.end())
+        blocks.erase(it);
+}
+}
+
+
+void BasicBlock::chain(BasicBlock* next) {
+    if (link[0] == next || link[1] == next)
+        return;
+    if (link[1])
+        unlinkFrom(link[1]->linked_from, this);
+    link[1] = link[0];
+    link[0] = next;
+    next->linked_from.push_back(this);
+}
+
+
+BasicBlock* BlockCache::insert(std::unique_ptr<BasicBlock> block) {
+    BasicBlock* raw = block.get();
+    auto it = blocks.find(raw->start_pc);
+    if (it != blocks.end())
+        remove(it->second.get());
+    uint32_t last = (raw->end_pc - 1) >> PAGE_SHIFT;
+    for (uint32_t page = raw->start_pc >> PAGE_SHIFT; page <= last; page++) {
+        pages[page].push_back(raw);
+    }
+    blocks[raw->start_pc] = std::move(block);
+    return raw;
+}
+
+
+void BlockCache::remove(BasicBlock* block) {
+    for (BasicBlock* from : block->linked_from) {
+        for (BasicBlock*& link : from->link) {
+            if (link == block)
+                link = nullptr;
+        }
+    }
+    for (BasicBlock* to : block->link) {
+        if (to)
+            unlinkFrom(to->linked_from, block);
+    }
+    uint32_t last = (block->end_pc - 1) >> PAGE_SHIFT;
+    for (uint32_t page = block->start_pc >> PAGE_SHIFT; page <= last; page++) {
+        auto it = pages.find(page);
+        if (it == pages.end())
+            continue;
+        unlinkFrom(it->second, block);
+        if (it->second.empty())
+            pages.erase(it);
+    }
+    blocks.erase(block->start_pc);
+}
+
+
+void BlockCache::invalidatePage(uint32_t page) {
+    auto it = pages.find(page);
+    while (it != pages.end()) {
+        remove(it->second.back());  // erases the list with its last block
+        it = pages.find(page);
+    }
+}
+
+
+void BlockCache::invalidate(uint32_t address, uint32_t size) {
+    if (size == 0)
+        return;
+    uint32_t last = (address + size - 1) >> PAGE_SHIFT;
+    for (uint32_t page = address >> PAGE_SHIFT; page <= last; page++) {
+        invalidatePage(page);
+    }
+}
+
+
+void BlockCache::clear() {
+    blocks.clear();
+    pages.clear();
+}
+
+};  // namespace M68K
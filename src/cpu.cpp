@@ -1,71 +1,407 @@
 #include "cpu.hpp"
-#include "elfio/elfio.hpp"
 
-#include <iostream>
-
-
-using namespace ELFIO;
+#include <algorithm>
+#include <array>
 
 
 namespace M68K {
-void CPU::step(){
+void CPUCore::step(){
+    if(this->state.attention())
+        this->state.takeInterrupt();
+    if(this->state.halted)
+        return;
+    if(this->state.stopped){
+#if M68K_CYCLES
+        // nothing happens before the next event
+        if(this->scheduler.deadline() != Scheduler::NEVER){
+            this->state.cycles = std::max(this->state.cycles, this->scheduler.deadline());
+            this->scheduler.dispatch(this->state.cycles);
+        }
+#endif
+        return;
+    }
     uint32_t pc = (uint32_t)this->state.registers.get(REG_PC);
-    uint16_t opcode = (uint16_t)this->state.memory.get(pc, SIZE_WORD);
+    uint16_t opcode = (uint16_t)this->state.readMemory(pc, SIZE_WORD);
 
-    INSTRUCTION::Instruction* instruction;
-    instruction = this->instruction_decoder.Decode(opcode);
-    //std::cout << typeid(*instruction).name() << std::endl;
-    instruction->execute(this->state);
+    if(this->state.pendingException() == VECTOR_NONE){ // else the fetch failed
+        INSTRUCTION::Instruction* instruction;
+        instruction = this->instruction_decoder.Decode(opcode);
+        //std::cout << typeid(*instruction).name() << std::endl;
+        Registers before = this->state.registers;
+        instruction->execute(this->state);
+        if(this->state.pendingException() != VECTOR_NONE)
+            this->state.abortOnFault(before);
+#if M68K_CYCLES
+        this->state.cycles += instruction->cycles;
+#endif
+#if M68K_STATS
+        STATS::local().opcodes[instruction->getOpcode()]++;
+#endif
+    }
+    if(this->state.pendingException() != VECTOR_NONE)
+        this->state.processException(pc);
+#if M68K_CYCLES
+    if(this->state.cycles >= this->scheduler.deadline())
+        this->scheduler.dispatch(this->state.cycles);
+#endif
 }
 
 
-bool M68K::load_elf(CPU* cpu, const std::string& file_name){
-    ELFIO::elfio elf_reader;
-    if(!elf_reader.load(file_name)){
-        return false;
+namespace {
+bool isBreakpoint(const std::vector<uint32_t>& breakpoints, uint32_t pc){
+    for(uint32_t breakpoint : breakpoints){
+        if(breakpoint == pc)
+            return true;
     }
+    return false;
+}
 
-    if(
-        (elf_reader.get_class() != ELFIO::ELFCLASS32) ||
-        (elf_reader.get_encoding() != ELFIO::ELFDATA2MSB) ||
-        (elf_reader.get_type() != ELFIO::ET_EXEC) ||
-        (elf_reader.get_machine() != ELFIO::EM_68K)
-    ){
+// Consecutive runs of an idle loop candidate between checks of its registers
+const uint32_t IDLE_CHECK_INTERVAL = 64;
+
+// MOVE, MOVEQ, TST, CMP, BTST and the ALU instructions with a register destination, which
+// leave memory alone. Others may still write only registers, they are just not recognized.
+bool writesOnlyRegisters(uint16_t opcode){
+    switch(opcode >> 12){
+        case 0x0: // CMPI, BTST #n and BTST Dn
+            return (opcode & 0xFF00) == 0x0C00 || (opcode & 0xFFC0) == 0x0800 || (opcode & 0xF1C0) == 0x0100;
+        case 0x1:
+        case 0x2:
+        case 0x3: // MOVE and MOVEA to a register
+            return ((opcode >> 6) & 0x7) <= 1;
+        case 0x4: // TST, 0x4AC0 is TAS
+            return (opcode & 0xFF00) == 0x4A00 && (opcode & 0x00C0) != 0x00C0;
+        case 0x7: // MOVEQ
+            return !(opcode & 0x0100);
+        case 0x8:
+        case 0x9:
+        case 0xB:
+        case 0xC:
+        case 0xD: // <ea>,Dn and the An, MUL and DIV forms
+            return !(opcode & 0x0100) || (opcode & 0x00C0) == 0x00C0;
+    }
+    return false;
+}
+
+// the source <ea> of an instruction accepted by writesOnlyRegisters() is in memory
+bool readsMemory(uint16_t opcode){
+    if((opcode >> 12) == 0x7)
         return false;
+    uint16_t mode = (opcode >> 3) & 0x7;
+    uint16_t reg = opcode & 0x7;
+    return mode >= 2 && !(mode == 7 && reg == 4);
+}
+
+// target of a Bcc other than BSR, 0 for other branches
+uint32_t conditionalTarget(CPUState& state, uint32_t pc, uint16_t opcode){
+    if((opcode & 0xF000) != 0x6000 || (opcode & 0x0F00) == 0x0100)
+        return 0;
+    uint16_t displacement = opcode & 0xFF;
+    if(displacement == 0xFF)
+        return 0;
+    int32_t offset = (int8_t)displacement;
+    if(displacement == 0x00)
+        offset = (int16_t)state.readMemory(pc + SIZE_WORD, SIZE_WORD);
+    return pc + SIZE_WORD + (uint32_t)offset;
+}
+
+// a breakpoint after the first instruction of the block
+bool breakpointInside(const std::vector<uint32_t>& breakpoints, const BasicBlock& block){
+    for(uint32_t breakpoint : breakpoints){
+        if(breakpoint > block.start_pc && breakpoint < block.end_pc)
+            return true;
     }
+    return false;
+}
+}
 
-    uint32_t entry_address = (uint32_t)elf_reader.get_entry();
-
-    for (const auto& segment : elf_reader.sections) {
-        std::string name = segment->get_name();
-        std::cout << name;
-        for (size_t i = name.size(); i < 16; ++i)
-            std::cout << ' ';
-        std::cout << "\t"
-                   << segment->get_address() << "\t"
-                   << segment->get_size() << "\t"
-                   << segment->get_offset() << "\t"
-                   << segment->get_addr_align() << "\t"
-                   << segment->get_link() << "\t"
-                   << segment->get_flags() << "\t"
-                   << segment->get_info() << "\t"
-                   << segment->get_type() << std::endl;
-
-        Elf_Xword f = segment->get_flags();
-        if(segment->get_type() == ELFIO::PT_LOAD && (f & SHF_ALLOC) != 0){
-            uint32_t base_address = (uint32_t)segment->get_address();
-            uint32_t size = (uint32_t)segment->get_size();
-            auto data = segment->get_data();
-            for(uint32_t i = 0; i < size; i++){
-                uint32_t address = base_address + i;
-                cpu->state.memory.set(address, SIZE_BYTE, data[i]); // little slow, but good enough
-            }
+
+BasicBlock* CPUCore::translate(uint32_t pc, const std::vector<uint32_t>& breakpoints, uint64_t cycle_budget){
+    // Recording while executing: the PC after each non-branch instruction
+    // is the exact address of the next one, extension words included.
+    // The block ends after an instruction raising an exception, the exception is left pending,
+    // and after the instruction that uses up cycle_budget.
+    // Returns nullptr if the first instruction could not be fetched.
+    // Each page is watched before an instruction on it runs, so a write to code already
+    // recorded drops the block again, see run(const RunLimits&).
+    std::unique_ptr<BasicBlock> block(new BasicBlock());
+    CodeWatch* code_watch = this->state.codeWatch();
+    block->start_pc = pc;
+    block->entries.reserve(8);
+    bool register_only = true;
+
+    while(true){
+        uint16_t opcode = (uint16_t)this->state.readMemory(pc, SIZE_WORD);
+        if(this->state.pendingException() != VECTOR_NONE)
+            break;
+        INSTRUCTION::Instruction* instruction = this->instruction_decoder.Decode(opcode);
+        if(instruction->is_branch){
+            block->idle_candidate = register_only && conditionalTarget(this->state, pc, opcode) == block->start_pc;
+        }else{
+            register_only = register_only && writesOnlyRegisters(opcode);
+            block->reads_memory = block->reads_memory || readsMemory(opcode);
+        }
+        if(code_watch)
+            code_watch->watchCode(pc, pc + 2);
+        Registers before = this->state.registers;
+        instruction->execute(this->state);
+
+        uint32_t next_pc = this->state.registers.pc;
+        if(this->state.pendingException() != VECTOR_NONE)
+            this->state.abortOnFault(before);
+        BlockEntry entry;
+        entry.instruction = instruction;
+        entry.pc = pc;
+        entry.length = instruction->is_branch ? 0 : (uint16_t)(next_pc - pc);
+        entry.cycles = instruction->cycles;
+        block->entries.push_back(entry);
+        block->cycles += entry.cycles;
+
+        if(instruction->is_branch){
+            block->end_pc = pc + 6; // longest branch encoding, a conservative bound for invalidate()
+            break;
+        }
+        pc = next_pc;
+        if(block->entries.size() >= BasicBlock::MAX_LENGTH || isBreakpoint(breakpoints, pc) ||
+           this->state.pendingException() != VECTOR_NONE || block->cycles >= cycle_budget){
+            block->end_pc = pc;
+            break;
         }
     }
+    if(block->entries.empty())
+        return nullptr;
+    if(code_watch)
+        code_watch->watchCode(block->start_pc, block->end_pc); // extension words on the next page
+    return this->block_cache.insert(std::move(block));
+}
+
 
-    cpu->state.registers.set(REG_USP, SIZE_LONG, MEMORY_SIZE);
-    cpu->state.registers.set(REG_PC, SIZE_LONG, entry_address);
+bool CPUCore::interpret(const BasicBlock& block, size_t count, uint64_t& executed){
+    for(size_t i = 0; i < count; i++){
+        const BlockEntry& entry = block.entries[i];
+        Registers before = this->state.registers;
+        entry.instruction->execute(this->state);
+        if(this->state.pendingException() != VECTOR_NONE){
+            this->state.abortOnFault(before);
+            this->countCycles(block, i + 1);
+            this->countStats(block, i + 1);
+            this->state.processException(entry.pc);
+            executed += i + 1;
+            return false;
+        }
+    }
+    this->countCycles(block, count);
+    this->countStats(block, count);
+    executed += count;
     return true;
 }
 
+
+uint64_t CPUCore::run(uint64_t instruction_limit){
+    RunLimits limits;
+    limits.instructions = instruction_limit;
+    limits.detect_idle = false;
+    return this->run(limits).instructions;
+}
+
+
+RunResult CPUCore::run(const RunLimits& limits){
+    const bool watch = !limits.breakpoints.empty();
+    uint64_t executed = 0;
+    BasicBlock* prev = nullptr;
+    uint32_t idle_spins = 0;
+    const uint64_t start_cycles = this->state.cycles;
+    const uint64_t cycle_limit = limits.cycles < Scheduler::NEVER - start_cycles ? start_cycles + limits.cycles : Scheduler::NEVER;
+    RunResult result;
+    CodeWatch* const code_watch = this->state.codeWatch();
+#if M68K_JIT
+    if(this->jit.attach()){
+        // the native code of the blocks belongs to the thread that ran this CPU before
+        this->block_cache.clear();
+    }
+#endif
+
+    while(true){
+#if M68K_CYCLES
+        if(this->state.cycles >= this->scheduler.deadline())
+            this->scheduler.dispatch(this->state.cycles);
+#endif
+        if(this->state.attention() && this->state.takeInterrupt())
+            prev = nullptr;
+        if(code_watch && !code_watch->writtenCode().empty()){
+            // code written by the last block, by step() or by the host since the last run.
+            // The rest of the block that wrote it ran as recorded.
+            for(uint32_t page : code_watch->writtenCode()){
+                this->block_cache.invalidatePage(page);
+            }
+            code_watch->clearWrittenCode();
+            prev = nullptr;
+        }
+        if(executed >= limits.instructions){
+            result.reason = STOP_INSTRUCTIONS;
+            break;
+        }
+        if(this->state.cycles >= cycle_limit){
+            result.reason = STOP_CYCLES;
+            break;
+        }
+        if(this->state.halted){
+            result.reason = STOP_HALT;
+            break;
+        }
+#if M68K_JIT
+        if(this->jit.exhausted()){
+            // native code of every block goes away with the buffer
+            this->block_cache.clear();
+            this->jit.clear();
+            prev = nullptr;
+        }
+#endif
+#if M68K_CYCLES
+        // the next event or the cycle limit, whichever comes first
+        const uint64_t horizon = std::min(cycle_limit, this->scheduler.deadline());
+#else
+        const uint64_t horizon = Scheduler::NEVER;
+#endif
+        if(this->state.stopped){
+            if(horizon == Scheduler::NEVER){
+                result.reason = STOP_IDLE;
+                break;
+            }
+            // waits for the interrupt of an event, or up to the cycle limit
+            this->state.cycles = std::max(this->state.cycles, horizon);
+            continue;
+        }
+        uint32_t pc = this->state.registers.pc;
+        if(watch && executed > 0 && isBreakpoint(limits.breakpoints, pc)){
+            result.reason = STOP_BREAKPOINT;
+            break;
+        }
+
+        BasicBlock* block = prev ? prev->successor(pc) : nullptr;
+        if(!block){
+            block = this->block_cache.find(pc);
+            if(!block){
+                // the first pass of a block runs while it is being recorded
+                block = this->translate(pc, limits.breakpoints, horizon - this->state.cycles);
+                prev = block;
+                if(!block){ // fetch from an odd PC
+                    this->state.processException(pc);
+                    executed++;
+                    continue;
+                }
+                executed += block->entries.size();
+                this->countCycles(*block, block->entries.size());
+                this->countStats(*block, block->entries.size());
+                if(this->state.pendingException() != VECTOR_NONE){
+                    this->state.processException(block->entries.back().pc);
+                    prev = nullptr;
+                }
+                continue;
+            }
+            if(prev)
+                prev->chain(block);
+        }
+
+        if(watch && breakpointInside(limits.breakpoints, *block)){
+            // a block recorded before the breakpoint was set runs up to it
+            const std::vector<BlockEntry>& entries = block->entries;
+            size_t stop = 1;
+            while(stop < entries.size() && !isBreakpoint(limits.breakpoints, entries[stop].pc)){
+                stop++;
+            }
+            if(stop < entries.size()){
+                if(!this->interpret(*block, stop, executed)){ // entered an exception handler instead
+                    prev = nullptr;
+                    continue;
+                }
+                result.reason = STOP_BREAKPOINT;
+                break;
+            }
+        }
+
+#if M68K_CYCLES
+        if(this->state.cycles + block->cycles > horizon){
+            // a block recorded before runs up to the instruction the deadline falls on
+            size_t count = 0;
+            uint64_t cycles = this->state.cycles;
+            while(count < block->entries.size() && cycles < horizon){
+                cycles += block->entries[count++].cycles;
+            }
+            if(count < block->entries.size()){
+                this->interpret(*block, count, executed);
+                prev = nullptr;
+                continue;
+            }
+        }
+#endif
+
+        // An idle loop candidate that ran an iteration without changing a register spins forever,
+        // unless a device can change what it reads
+        bool check_idle = false;
+        std::array<uint32_t, REGS_COUNT> before;
+        if(limits.detect_idle && block->idle_candidate && block == prev && ++idle_spins % IDLE_CHECK_INTERVAL == 0 &&
+           !(block->reads_memory && this->state.memoryMayChange())){
+            this->state.registers.materializeFlags();
+            before = this->state.registers.reg_buffer;
+            check_idle = true;
+        }
+
+#if M68K_JIT
+        if(block->native && !this->state.registers.sr.supervisor){
+            this->jit_context.state = &this->state;
+            this->state.registers.materializeFlags(); // native code works on SR directly
+            uint32_t count = block->native(&this->jit_context, this->state.registers.reg_buffer.data());
+            // native code exits with the PC at an instruction that raised an exception, see jitExecute()
+            bool raised = this->state.pendingException() != VECTOR_NONE;
+            if(raised)
+                count++;
+            this->countCycles(*block, count);
+            this->countStats(*block, count);
+            executed += count;
+            if(raised){
+                this->state.processException(this->state.registers.pc);
+                block = nullptr;
+            }
+        }else
+#endif
+        {
+#if M68K_JIT
+            if(++block->exec_count == this->jit.threshold && this->jit.enabled){
+                this->jit.compile(*block, this->state);
+            }
+#endif
+            if(!this->interpret(*block, block->entries.size(), executed))
+                block = nullptr;
+        }
+        prev = block;
+
+        if(check_idle){
+            this->state.registers.materializeFlags();
+            if(this->state.registers.reg_buffer == before){
+#if M68K_CYCLES
+                if(block && horizon != Scheduler::NEVER && block->cycles > 0){
+                    // nothing changes before the next event or the cycle limit, the iterations up
+                    // to it are skipped as if executed, as many as the instruction limit leaves
+                    const uint64_t size = block->entries.size();
+                    const uint64_t remaining = limits.instructions - std::min(executed, limits.instructions);
+                    uint64_t iterations = (horizon - std::min(horizon, this->state.cycles) + block->cycles - 1) / block->cycles;
+                    iterations = std::min(iterations, (remaining + size - 1) / size);
+                    this->state.cycles += iterations * block->cycles;
+                    this->countStats(*block, size, iterations);
+                    executed += iterations * size;
+                    continue;
+                }
+#endif
+                result.reason = STOP_IDLE;
+                break;
+            }
+        }
+    }
+    result.instructions = executed;
+    result.cycles = this->state.cycles - start_cycles;
+    return result;
+}
+
+
 };  // namespace M68K
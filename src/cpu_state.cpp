@@ -1,15 +1,18 @@
 #include "cpu_state.hpp"
 #include "instructions/instruction.hpp"
 #include "helpers.hpp"
+#include "cycles.hpp"
 
 #include <cstdio>
+#include <stdexcept>
+#include <string>
 
 using namespace M68K;
 using namespace INSTRUCTION;
 
 uint32_t CPUState::stackPop(DataSize size){
     uint32_t stack_ptr = this->registers.get(REG_USP, SIZE_LONG);
-    uint32_t data = this->memory.get(stack_ptr, size);
+    uint32_t data = this->readMemory(stack_ptr, size);
     stack_ptr += static_cast<uint32_t>(size);
     this->registers.set(REG_USP, SIZE_LONG, stack_ptr);
     return data;
@@ -19,7 +22,7 @@ void CPUState::stackPush(DataSize size, uint32_t data){
     uint32_t stack_ptr = this->registers.get(REG_USP, SIZE_LONG);
     stack_ptr -= static_cast<uint32_t>(size);
     this->registers.set(REG_USP, SIZE_LONG, stack_ptr);
-    this->memory.set(stack_ptr, size, data);
+    this->writeMemory(stack_ptr, size, data);
 }
 
 uint32_t CPUState::getControlAddress(AddressingMode mode, RegisterType reg, DataSize /*size*/){
@@ -32,7 +35,7 @@ uint32_t CPUState::getControlAddress(AddressingMode mode, RegisterType reg, Data
         case ADDR_MODE_INDIRECT_DISPLACEMENT: {
             addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
             addr += offset;
             break;
@@ -40,7 +43,7 @@ uint32_t CPUState::getControlAddress(AddressingMode mode, RegisterType reg, Data
         case ADDR_MODE_INDIRECT_INDEX: {
             addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -56,14 +59,14 @@ uint32_t CPUState::getControlAddress(AddressingMode mode, RegisterType reg, Data
         }
         case ADDR_MODE_PC_DISPLACEMENT: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
             addr = pc + offset;
             break;
         }
         case ADDR_MODE_PC_INDEX: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -80,13 +83,13 @@ uint32_t CPUState::getControlAddress(AddressingMode mode, RegisterType reg, Data
         case ADDR_MODE_ABS_WORD: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            addr = this->memory.get(pc, SIZE_WORD);
+            addr = this->readMemory(pc, SIZE_WORD);
             break;
         }
         case ADDR_MODE_ABS_LONG: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_LONG);
-            addr = this->memory.get(pc, SIZE_LONG);
+            addr = this->readMemory(pc, SIZE_LONG);
             break;
         }
         case ADDR_MODE_IMMEDIATE:
@@ -111,12 +114,12 @@ uint32_t CPUState::getData(AddressingMode mode, RegisterType reg, DataSize size)
         }
         case ADDR_MODE_INDIRECT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_INDIRECT_POSTINCREMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             addr += size;
             // stack pointer should be aligned to a word boundary
             if (reg == REG_A7 && (size & 1) != 0)
@@ -129,22 +132,22 @@ uint32_t CPUState::getData(AddressingMode mode, RegisterType reg, DataSize size)
             addr -= size;
             if (reg == REG_A7 && (size & 1) != 0)
                 -- addr;
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             this->registers.set(reg, SIZE_LONG, addr);
             break;
         }
         case ADDR_MODE_INDIRECT_DISPLACEMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            data = this->memory.get(addr + offset, size);
+            data = this->readMemory(addr + offset, size);
             break;
         }
         case ADDR_MODE_INDIRECT_INDEX: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -155,19 +158,19 @@ uint32_t CPUState::getData(AddressingMode mode, RegisterType reg, DataSize size)
             }
 
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            data = this->memory.get(addr + ext_reg_offset + ext_offset, size);
+            data = this->readMemory(addr + ext_reg_offset + ext_offset, size);
             break;
         }
         case ADDR_MODE_PC_DISPLACEMENT: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            data = this->memory.get(pc + offset, size);
+            data = this->readMemory(pc + offset, size);
             break;
         }
         case ADDR_MODE_PC_INDEX: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -178,27 +181,27 @@ uint32_t CPUState::getData(AddressingMode mode, RegisterType reg, DataSize size)
             }
 
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            data = this->memory.get(pc + ext_reg_offset + ext_offset, size);
+            data = this->readMemory(pc + ext_reg_offset + ext_offset, size);
             break;
         }
         case ADDR_MODE_ABS_WORD: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t addr = this->memory.get(pc, SIZE_WORD);
+            uint32_t addr = this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_ABS_LONG: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t addr = this->memory.get(pc, SIZE_LONG);
+            uint32_t addr = this->readMemory(pc, SIZE_LONG);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_LONG);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_IMMEDIATE: {
             DataSize memory_size = (size == SIZE_LONG ? SIZE_LONG : SIZE_WORD);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t value = this->memory.get(pc, memory_size);
+            uint32_t value = this->readMemory(pc, memory_size);
             this->registers.set(REG_PC, SIZE_LONG, pc + memory_size);
             data = (size == SIZE_BYTE ? MASK_8(value) : value);
             break;
@@ -220,12 +223,12 @@ uint32_t CPUState::getDataSilent(AddressingMode mode, RegisterType reg, DataSize
         }
         case ADDR_MODE_INDIRECT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_INDIRECT_POSTINCREMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_INDIRECT_PREDECREMENT: {
@@ -233,20 +236,20 @@ uint32_t CPUState::getDataSilent(AddressingMode mode, RegisterType reg, DataSize
             addr -= size;
             if (reg == REG_A7 && (size & 1) != 0)
                 --addr;
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_INDIRECT_DISPLACEMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
-            data = this->memory.get(addr + offset, size);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
+            data = this->readMemory(addr + offset, size);
             break;
         }
         case ADDR_MODE_INDIRECT_INDEX: { // (d8, A4, Xn)
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType indexed_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ind_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -255,18 +258,18 @@ uint32_t CPUState::getDataSilent(AddressingMode mode, RegisterType reg, DataSize
             if(ind_reg_size == SIZE_WORD){
                 ext_reg_offset = static_cast<int16_t>(ext_reg_offset);
             }
-            data = this->memory.get(addr + ext_reg_offset + ext_offset, size);
+            data = this->readMemory(addr + ext_reg_offset + ext_offset, size);
             break;
         }
         case ADDR_MODE_PC_DISPLACEMENT: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
-            data = this->memory.get(pc + offset, size);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
+            data = this->readMemory(pc + offset, size);
             break;
         }
         case ADDR_MODE_PC_INDEX: { // TODO
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -275,26 +278,26 @@ uint32_t CPUState::getDataSilent(AddressingMode mode, RegisterType reg, DataSize
             if(ext_reg_size == SIZE_WORD){
                 ext_reg_offset = static_cast<int16_t>(ext_reg_offset);
             }
-            data = this->memory.get(pc + ext_reg_offset + ext_offset, size);
+            data = this->readMemory(pc + ext_reg_offset + ext_offset, size);
             break;
         }
         case ADDR_MODE_ABS_WORD: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int signedWord = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int signedWord = (int16_t)this->readMemory(pc, SIZE_WORD);
             uint32_t addr = (uint32_t)signedWord;
-            data = this->memory.get(addr, size);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_ABS_LONG: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t addr = this->memory.get(pc, SIZE_LONG);
-            data = this->memory.get(addr, size);
+            uint32_t addr = this->readMemory(pc, SIZE_LONG);
+            data = this->readMemory(addr, size);
             break;
         }
         case ADDR_MODE_IMMEDIATE: {
             DataSize memory_size = (size == SIZE_LONG ? SIZE_LONG : SIZE_WORD);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t value = this->memory.get(pc, memory_size);
+            uint32_t value = this->readMemory(pc, memory_size);
             data = (size == SIZE_BYTE ? MASK_8(value) : value);
             break;
         }
@@ -315,12 +318,12 @@ void CPUState::setData(AddressingMode mode, RegisterType reg, DataSize size, uin
         }
         case ADDR_MODE_INDIRECT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            this->memory.set(addr, size, data);
+            this->writeMemory(addr, size, data);
             break;
         }
         case ADDR_MODE_INDIRECT_POSTINCREMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
-            this->memory.set(addr, size, data);
+            this->writeMemory(addr, size, data);
             addr += size;
             // stack pointer should be aligned to a word boundary
             if (reg == REG_A7 && (size & 1) != 0)
@@ -334,22 +337,22 @@ void CPUState::setData(AddressingMode mode, RegisterType reg, DataSize size, uin
             // stack pointer should be aligned to a word boundary
             if (reg == REG_A7 && (size & 1) != 0)
                 --addr;
-            this->memory.set(addr, size, data);
+            this->writeMemory(addr, size, data);
             this->registers.set(reg, SIZE_LONG, addr);
             break;
         }
         case ADDR_MODE_INDIRECT_DISPLACEMENT: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int16_t offset = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            this->memory.set(addr + offset, size, data);
+            this->writeMemory(addr + offset, size, data);
             break;
         }
         case ADDR_MODE_INDIRECT_INDEX: {
             uint32_t addr = this->registers.get(reg, SIZE_LONG);
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint16_t ext_word = (uint16_t)this->memory.get(pc, SIZE_WORD);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
             RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
             DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
             int8_t ext_offset = ext_word & 0xFF;
@@ -360,19 +363,19 @@ void CPUState::setData(AddressingMode mode, RegisterType reg, DataSize size, uin
             }
 
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-            this->memory.set(addr + ext_reg_offset + ext_offset, size, data);
+            this->writeMemory(addr + ext_reg_offset + ext_offset, size, data);
             break;
         }
         // case ADDR_MODE_PC_DISPLACEMENT: { // read-only
         //     uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-        //     int16_t offset = this->memory.get(pc, SIZE_WORD);
+        //     int16_t offset = this->readMemory(pc, SIZE_WORD);
         //     this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-        //     this->memory.set(pc + offset, size, data);
+        //     this->writeMemory(pc + offset, size, data);
         //     break;
         // }
         // case ADDR_MODE_PC_INDEX: { // read-only
         //     uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-        //     uint16_t ext_word = this->memory.get(pc, SIZE_WORD);
+        //     uint16_t ext_word = this->readMemory(pc, SIZE_WORD);
         //     RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
         //     DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
         //     int8_t ext_offset = ext_word & 0xFF;
@@ -383,22 +386,22 @@ void CPUState::setData(AddressingMode mode, RegisterType reg, DataSize size, uin
         //     }
 
         //     this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
-        //     this->memory.set(pc + ext_reg_offset + ext_offset, size, data);
+        //     this->writeMemory(pc + ext_reg_offset + ext_offset, size, data);
         //     break;
         // }
         case ADDR_MODE_ABS_WORD: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            int signedWord = (int16_t)this->memory.get(pc, SIZE_WORD);
+            int signedWord = (int16_t)this->readMemory(pc, SIZE_WORD);
             uint32_t addr = (uint32_t)signedWord;
-            this->memory.set(addr, size, data);
+            this->writeMemory(addr, size, data);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_WORD);
             break;
         }
         case ADDR_MODE_ABS_LONG: {
             uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
-            uint32_t addr = this->memory.get(pc, SIZE_LONG);
+            uint32_t addr = this->readMemory(pc, SIZE_LONG);
             this->registers.set(REG_PC, SIZE_LONG, pc + SIZE_LONG);
-            this->memory.set(addr, size, data);
+            this->writeMemory(addr, size, data);
             break;
         }
         case ADDR_MODE_PC_DISPLACEMENT:
@@ -410,6 +413,126 @@ void CPUState::setData(AddressingMode mode, RegisterType reg, DataSize size, uin
     }
 }
 
+EffectiveAddress CPUState::resolveEA(AddressingMode mode, RegisterType reg, DataSize size){
+    EffectiveAddress ea;
+    ea.mode = mode;
+    ea.reg = reg;
+    switch(mode){
+        case ADDR_MODE_INDIRECT:
+        case ADDR_MODE_INDIRECT_POSTINCREMENT: {
+            ea.address = this->registers.get(reg, SIZE_LONG);
+            break;
+        }
+        case ADDR_MODE_INDIRECT_PREDECREMENT: {
+            ea.address = this->registers.get(reg, SIZE_LONG) - size;
+            // stack pointer should be aligned to a word boundary
+            if (reg == REG_A7 && (size & 1) != 0)
+                --ea.address;
+            break;
+        }
+        case ADDR_MODE_INDIRECT_DISPLACEMENT: {
+            uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
+            int16_t offset = (int16_t)this->readMemory(pc, SIZE_WORD);
+            ea.address = this->registers.get(reg, SIZE_LONG) + offset;
+            break;
+        }
+        case ADDR_MODE_INDIRECT_INDEX: {
+            uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
+            uint16_t ext_word = (uint16_t)this->readMemory(pc, SIZE_WORD);
+            RegisterType ext_reg = Instruction::getRegisterType((ext_word & 0x8000), (ext_word >> 12) & 0x7);
+            DataSize ext_reg_size = ((ext_word >> 11) & 0x1) ? SIZE_LONG : SIZE_WORD;
+            int8_t ext_offset = ext_word & 0xFF;
+            int32_t ext_reg_offset = this->registers.get(ext_reg, ext_reg_size);
+
+            if(ext_reg_size == SIZE_WORD){
+                ext_reg_offset = static_cast<int16_t>(ext_reg_offset);
+            }
+            ea.address = this->registers.get(reg, SIZE_LONG) + ext_reg_offset + ext_offset;
+            break;
+        }
+        case ADDR_MODE_ABS_WORD: {
+            uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
+            ea.address = (uint32_t)(int16_t)this->readMemory(pc, SIZE_WORD);
+            break;
+        }
+        case ADDR_MODE_ABS_LONG: {
+            uint32_t pc = this->registers.get(REG_PC, SIZE_LONG);
+            ea.address = this->readMemory(pc, SIZE_LONG);
+            break;
+        }
+        default:{ // registers and the read-only modes
+            break;
+        }
+    }
+    return ea;
+}
+
+uint32_t CPUState::getData(const EffectiveAddress& ea, DataSize size){
+    switch(ea.mode){
+        case ADDR_MODE_DIRECT_ADDR:
+        case ADDR_MODE_DIRECT_DATA:
+            return this->registers.get(ea.reg, size);
+        case ADDR_MODE_INDIRECT:
+        case ADDR_MODE_INDIRECT_POSTINCREMENT:
+        case ADDR_MODE_INDIRECT_PREDECREMENT:
+        case ADDR_MODE_INDIRECT_DISPLACEMENT:
+        case ADDR_MODE_INDIRECT_INDEX:
+        case ADDR_MODE_ABS_WORD:
+        case ADDR_MODE_ABS_LONG:
+            return this->readMemory(ea.address, size);
+        default:
+            return this->getDataSilent(ea.mode, ea.reg, size);
+    }
+}
+
+void CPUState::setData(const EffectiveAddress& ea, DataSize size, uint32_t data){
+    // same order of memory, PC and register updates as setData(mode, reg, size, data)
+    switch(ea.mode){
+        case ADDR_MODE_DIRECT_ADDR:
+        case ADDR_MODE_DIRECT_DATA: {
+            this->registers.set(ea.reg, size, data);
+            break;
+        }
+        case ADDR_MODE_INDIRECT: {
+            this->writeMemory(ea.address, size, data);
+            break;
+        }
+        case ADDR_MODE_INDIRECT_POSTINCREMENT: {
+            this->writeMemory(ea.address, size, data);
+            uint32_t addr = ea.address + size;
+            // stack pointer should be aligned to a word boundary
+            if (ea.reg == REG_A7 && (size & 1) != 0)
+                ++addr;
+            this->registers.set(ea.reg, SIZE_LONG, addr);
+            break;
+        }
+        case ADDR_MODE_INDIRECT_PREDECREMENT: {
+            this->writeMemory(ea.address, size, data);
+            this->registers.set(ea.reg, SIZE_LONG, ea.address);
+            break;
+        }
+        case ADDR_MODE_INDIRECT_DISPLACEMENT:
+        case ADDR_MODE_INDIRECT_INDEX: {
+            this->registers.set(REG_PC, SIZE_LONG, this->registers.get(REG_PC, SIZE_LONG) + SIZE_WORD);
+            this->writeMemory(ea.address, size, data);
+            break;
+        }
+        case ADDR_MODE_ABS_WORD: {
+            this->writeMemory(ea.address, size, data);
+            this->registers.set(REG_PC, SIZE_LONG, this->registers.get(REG_PC, SIZE_LONG) + SIZE_WORD);
+            break;
+        }
+        case ADDR_MODE_ABS_LONG: {
+            this->registers.set(REG_PC, SIZE_LONG, this->registers.get(REG_PC, SIZE_LONG) + SIZE_LONG);
+            this->writeMemory(ea.address, size, data);
+            break;
+        }
+        default:{ // read-only modes
+            break;
+        }
+    }
+}
+
 bool CPUState::checkCondition(Condition cond){
     //bool flag_extend = this->registers.get(SR_FLAG_EXTEND);
     bool flag_negative = this->registers.get(SR_FLAG_NEGATIVE);
@@ -438,6 +561,91 @@ bool CPUState::checkCondition(Condition cond){
     return false;
 }
 
+void CPUState::processException(uint32_t instruction_pc){
+    ExceptionVector vector = this->exception_vector;
+    this->exception_vector = VECTOR_NONE;
+#if M68K_CYCLES
+    this->cycles += CYCLES::exception(vector);
+#endif
+
+    uint16_t sr = (uint16_t)this->registers.get(REG_SR, SIZE_WORD);
+    bool was_supervisor = this->registers.sr.supervisor;
+    this->registers.sr.supervisor = 1;
+    this->registers.sr.trace = 0;
+
+    if(vector == VECTOR_BUS_ERROR || vector == VECTOR_ADDRESS_ERROR){
+        // Group 0 frame: status word, access address, opcode, SR and PC. The 68000 pushes a PC
+        // 2 to 10 bytes past the instruction, here it is always the address of its extension words.
+        bool fetch = this->fault_address == MASK_ADDR(instruction_pc) && !this->fault_write;
+        uint16_t function_code = (was_supervisor ? 4 : 0) | (fetch ? 2 : 1);
+        uint16_t opcode = fetch ? 0 : (uint16_t)this->readMemory(instruction_pc, SIZE_WORD);
+        this->stackPush(SIZE_LONG, instruction_pc + SIZE_WORD);
+        this->stackPush(SIZE_WORD, sr);
+        this->stackPush(SIZE_WORD, opcode);
+        this->stackPush(SIZE_LONG, this->fault_address);
+        this->stackPush(SIZE_WORD, (this->fault_write ? 0 : 0x10) | function_code);
+    }else{
+        this->stackPush(SIZE_LONG, this->registers.pc);
+        this->stackPush(SIZE_WORD, sr);
+    }
+    uint32_t handler = this->readMemory(vector * SIZE_LONG, SIZE_LONG);
+
+    if(this->exception_vector != VECTOR_NONE){
+        // double fault, the 68000 stops until reset
+        this->exception_vector = VECTOR_NONE;
+        this->halted = true;
+        return;
+    }
+    this->registers.pc = handler;
+}
+
+void CPUState::raiseIRQ(int level, uint8_t vector){
+    if(level < 1 || level > 7)
+        throw std::out_of_range("Interrupt level must be 1 to 7. " + std::to_string(level));
+    this->irq_levels |= (uint8_t)(1 << level);
+    this->irq_vectors[level] = vector;
+}
+
+void CPUState::clearIRQ(int level){
+    if(level < 1 || level > 7)
+        throw std::out_of_range("Interrupt level must be 1 to 7. " + std::to_string(level));
+    this->irq_levels &= (uint8_t)~(1 << level);
+}
+
+bool CPUState::takeInterrupt(){
+    if(this->halted)
+        return false;
+    int level = 7;
+    while(!(this->irq_levels & (1 << level))){
+        level--;
+    }
+    if(level <= this->registers.sr.interrupt_mask && level != 7)
+        return false;
+    this->irq_levels &= (uint8_t)~(1 << level);
+    uint32_t vector = this->irq_vectors[level] ? this->irq_vectors[level] : VECTOR_SPURIOUS_INTERRUPT + level;
+    this->stopped = false;
+#if M68K_CYCLES
+    this->cycles += CYCLES::INTERRUPT;
+#endif
+
+    uint16_t sr = (uint16_t)this->registers.get(REG_SR, SIZE_WORD);
+    this->registers.sr.supervisor = 1;
+    this->registers.sr.trace = 0;
+    this->registers.sr.interrupt_mask = level;
+    this->stackPush(SIZE_LONG, this->registers.pc);
+    this->stackPush(SIZE_WORD, sr);
+    uint32_t handler = this->readMemory(vector * SIZE_LONG, SIZE_LONG);
+
+    if(this->exception_vector != VECTOR_NONE){
+        // double fault, see processException()
+        this->exception_vector = VECTOR_NONE;
+        this->halted = true;
+        return true;
+    }
+    this->registers.pc = handler;
+    return true;
+}
+
 void CPUState::debugPrint(){
     puts("CPU state:");
     for(size_t i = 0; i < 8; i++){
@@ -0,0 +1,286 @@
+#include "cycles.hpp"
+#include "instructions/instruction.hpp"
+
+#include <cstdlib>
+
+using namespace M68K;
+using namespace INSTRUCTION;
+
+namespace {
+// by AddressingMode, byte and word accesses
+const uint8_t EA_WORD[] = {0, 0, 4, 4, 6, 8, 10, 8, 10, 8, 12, 4};
+const uint8_t EA_LONG[] = {0, 0, 8, 8, 10, 12, 14, 12, 14, 12, 16, 8};
+// destination of MOVE, -(An) costs no more than (An)
+const uint8_t MOVE_WORD[] = {0, 0, 4, 4, 4, 8, 10, 8, 10, 8, 12, 4};
+const uint8_t MOVE_LONG[] = {0, 0, 8, 8, 8, 12, 14, 12, 14, 12, 16, 8};
+
+// (An), d16(An), d8(An,Xn), abs.W, abs.L, d16(PC), d8(PC,Xn)
+const uint8_t JMP[] = {8, 10, 14, 10, 12, 10, 14};
+const uint8_t JSR[] = {16, 18, 22, 18, 20, 18, 22};
+const uint8_t LEA[] = {4, 8, 12, 8, 12, 8, 12};
+const uint8_t PEA[] = {12, 16, 20, 16, 20, 16, 20};
+
+int control(AddressingMode mode, const uint8_t* costs){
+    switch(mode){
+        case ADDR_MODE_INDIRECT_DISPLACEMENT: return costs[1];
+        case ADDR_MODE_INDIRECT_INDEX: return costs[2];
+        case ADDR_MODE_ABS_WORD: return costs[3];
+        case ADDR_MODE_ABS_LONG: return costs[4];
+        case ADDR_MODE_PC_DISPLACEMENT: return costs[5];
+        case ADDR_MODE_PC_INDEX: return costs[6];
+        default: return costs[0];
+    }
+}
+
+bool isRegister(AddressingMode mode){
+    return mode == ADDR_MODE_DIRECT_DATA || mode == ADDR_MODE_DIRECT_ADDR;
+}
+
+DataSize standardSize(uint16_t opcode){
+    switch((opcode >> 6) & 0x3){
+        case 0: return SIZE_BYTE;
+        case 1: return SIZE_WORD;
+        default: return SIZE_LONG;
+    }
+}
+
+// ADD, SUB, AND and OR
+int standard(uint16_t opcode, AddressingMode mode){
+    DataSize size = standardSize(opcode);
+    int ea = CYCLES::effectiveAddress(mode, size);
+    if(opcode & 0x0100) // Dn,<ea>
+        return (size == SIZE_LONG ? 12 : 8) + ea;
+    if(size != SIZE_LONG)
+        return 4 + ea;
+    return (isRegister(mode) || mode == ADDR_MODE_IMMEDIATE ? 8 : 6) + ea;
+}
+
+// ADDA and SUBA
+int address(uint16_t opcode, AddressingMode mode){
+    if(!(opcode & 0x0100))
+        return 8 + CYCLES::effectiveAddress(mode, SIZE_WORD);
+    return (isRegister(mode) || mode == ADDR_MODE_IMMEDIATE ? 8 : 6) + CYCLES::effectiveAddress(mode, SIZE_LONG);
+}
+
+// ADDX and SUBX
+int extended(uint16_t opcode){
+    bool is_long = standardSize(opcode) == SIZE_LONG;
+    if(opcode & 0x0008) // -(Ay),-(Ax)
+        return is_long ? 30 : 18;
+    return is_long ? 8 : 4;
+}
+
+// CLR, NEG and the other single operand instructions
+int single(uint16_t opcode, AddressingMode mode){
+    DataSize size = standardSize(opcode);
+    if(isRegister(mode))
+        return size == SIZE_LONG ? 6 : 4;
+    return (size == SIZE_LONG ? 12 : 8) + CYCLES::effectiveAddress(mode, size);
+}
+
+// ORI, ANDI, SUBI, ADDI, EORI and CMPI, the immediate data is part of the base time
+int immediate(uint16_t opcode, AddressingMode mode){
+    bool is_long = standardSize(opcode) == SIZE_LONG;
+    bool compare = (opcode & 0xFF00) == 0x0C00;
+    int ea = CYCLES::effectiveAddress(mode, standardSize(opcode));
+    if(isRegister(mode))
+        return is_long ? (compare ? 14 : 16) : 8;
+    if(compare)
+        return (is_long ? 12 : 8) + ea;
+    return (is_long ? 20 : 12) + ea;
+}
+
+// BTST, BCHG, BCLR and BSET, the bit number of the static forms is part of the base time
+int bit(uint16_t opcode, AddressingMode mode){
+    uint16_t type = (opcode >> 6) & 0x3;
+    bool is_static = !(opcode & 0x0100);
+    if(isRegister(mode)){
+        static const uint8_t dynamic_register[] = {6, 8, 10, 8};
+        return dynamic_register[type] + (is_static ? 4 : 0);
+    }
+    return (type == 0 ? 4 : 8) + (is_static ? 4 : 0) + CYCLES::effectiveAddress(mode, SIZE_BYTE);
+}
+
+int move(uint16_t opcode, AddressingMode mode){
+    DataSize size = ((opcode >> 12) & 0x3) == 1 ? SIZE_BYTE : ((opcode >> 12) & 0x3) == 3 ? SIZE_WORD : SIZE_LONG;
+    AddressingMode dest = Instruction::getAddressingMode((opcode >> 6) & 0x7, (opcode >> 9) & 0x7);
+    const uint8_t* dest_costs = size == SIZE_LONG ? MOVE_LONG : MOVE_WORD;
+    return 4 + CYCLES::effectiveAddress(mode, size) + (dest == ADDR_MODE_UNKNOWN ? 0 : dest_costs[dest]);
+}
+
+int shift(uint16_t opcode, AddressingMode mode){
+    if((opcode & 0x00C0) == 0x00C0) // memory, by one bit
+        return 8 + CYCLES::effectiveAddress(mode, SIZE_WORD);
+    int base = standardSize(opcode) == SIZE_LONG ? 8 : 6;
+    if(opcode & 0x0020) // count in a register
+        return base;
+    uint16_t count = (opcode >> 9) & 0x7;
+    return base + 2 * (count ? count : 8);
+}
+}
+
+
+int CYCLES::effectiveAddress(AddressingMode mode, DataSize size){
+    if(mode == ADDR_MODE_UNKNOWN)
+        return 0;
+    return size == SIZE_LONG ? EA_LONG[mode] : EA_WORD[mode];
+}
+
+uint16_t CYCLES::instructionCycles(uint16_t opcode){
+    AddressingMode mode = Instruction::getAddressingMode((opcode >> 3) & 0x7, opcode & 0x7);
+    int cycles = 4;
+
+    switch(opcode >> 12){
+        case 0x0:
+            if((opcode & 0x0100) || (opcode & 0xFF00) == 0x0800)
+                cycles = bit(opcode, mode);
+            else
+                cycles = immediate(opcode, mode);
+            break;
+        case 0x1:
+        case 0x2:
+        case 0x3:
+            cycles = move(opcode, mode);
+            break;
+        case 0x4:
+            if(opcode == 0x4E73)
+                cycles = 20; // RTE
+            else if(opcode == 0x4E75)
+                cycles = 16; // RTS
+            else if((opcode & 0xFFF8) == 0x4E50)
+                cycles = 16; // LINK
+            else if((opcode & 0xFFF8) == 0x4E58)
+                cycles = 12; // UNLK
+            else if((opcode & 0xFFC0) == 0x4840)
+                cycles = control(mode, PEA);
+            else if((opcode & 0xFFC0) == 0x4E80)
+                cycles = control(mode, JSR);
+            else if((opcode & 0xFFC0) == 0x4EC0)
+                cycles = control(mode, JMP);
+            else if((opcode & 0xF1C0) == 0x41C0)
+                cycles = control(mode, LEA);
+            else if(opcode != 0x4AFC && (opcode & 0xFF00) == 0x4A00)
+                cycles = 4 + effectiveAddress(mode, standardSize(opcode)); // TST
+            else if((opcode & 0xFF00) == 0x4200 || (opcode & 0xFF00) == 0x4400)
+                cycles = single(opcode, mode); // CLR, NEG
+            break; // NOP, EXT, STOP, TRAP and ILLEGAL take 4
+        case 0x5:
+            if((opcode & 0x00C0) == 0x00C0) // Scc, as false
+                cycles = isRegister(mode) ? 4 : 8 + effectiveAddress(mode, SIZE_BYTE);
+            else if(mode == ADDR_MODE_DIRECT_ADDR) // ADDQ, SUBQ
+                cycles = 8;
+            else if(mode == ADDR_MODE_DIRECT_DATA)
+                cycles = standardSize(opcode) == SIZE_LONG ? 8 : 4;
+            else
+                cycles = single(opcode, mode);
+            break;
+        case 0x6:
+            cycles = ((opcode >> 8) & 0xF) == 1 ? 18 : 10; // BSR, Bcc taken
+            break;
+        case 0x7:
+            cycles = 4; // MOVEQ
+            break;
+        case 0x8:
+            if((opcode & 0xF1C0) == 0x80C0)
+                cycles = DIVU + effectiveAddress(mode, SIZE_WORD);
+            else if((opcode & 0xF1C0) == 0x81C0)
+                cycles = DIVS + effectiveAddress(mode, SIZE_WORD);
+            else
+                cycles = standard(opcode, mode);
+            break;
+        case 0x9:
+        case 0xD:
+            if((opcode & 0x00C0) == 0x00C0)
+                cycles = address(opcode, mode);
+            else if((opcode & 0x0130) == 0x0100)
+                cycles = extended(opcode);
+            else
+                cycles = standard(opcode, mode);
+            break;
+        case 0xB:
+            if((opcode & 0x00C0) == 0x00C0) // CMPA
+                cycles = 6 + effectiveAddress(mode, (opcode & 0x0100) ? SIZE_LONG : SIZE_WORD);
+            else if(opcode & 0x0100) // EOR
+                cycles = isRegister(mode) ? (standardSize(opcode) == SIZE_LONG ? 8 : 4) : standard(opcode, mode);
+            else // CMP
+                cycles = (standardSize(opcode) == SIZE_LONG ? 6 : 4) + effectiveAddress(mode, standardSize(opcode));
+            break;
+        case 0xC:
+            if((opcode & 0x00C0) == 0x00C0) // MULU, MULS
+                cycles = MUL + effectiveAddress(mode, SIZE_WORD);
+            else
+                cycles = standard(opcode, mode);
+            break;
+        case 0xE:
+            cycles = shift(opcode, mode);
+            break;
+    }
+    return static_cast<uint16_t>(cycles);
+}
+
+int CYCLES::exception(ExceptionVector vector){
+    switch(vector){
+        case VECTOR_NONE: return 0;
+        case VECTOR_BUS_ERROR:
+        case VECTOR_ADDRESS_ERROR: return 50;
+        default: return 30; // 34 with the 4 of the instruction
+    }
+}
+
+int CYCLES::mulu(uint16_t source){
+    int ones = 0;
+    for(uint32_t bits = source; bits; bits &= bits - 1){
+        ones++;
+    }
+    return 38 + 2 * ones;
+}
+
+int CYCLES::muls(uint16_t source){
+    // one per 01 or 10 pair of the source with a 0 appended
+    uint32_t pairs = ((uint32_t)source << 1) ^ source;
+    int changes = 0;
+    for(uint32_t bits = pairs & 0xFFFF; bits; bits &= bits - 1){
+        changes++;
+    }
+    return 38 + 2 * changes;
+}
+
+int CYCLES::divu(uint32_t dividend, uint16_t divisor){
+    // the microcode's restoring division, one step per quotient bit
+    if((dividend >> 16) >= divisor)
+        return 10; // overflow
+    int cycles = 38;
+    uint32_t high_divisor = (uint32_t)divisor << 16;
+    for(int i = 0; i < 15; i++){
+        bool carry = (dividend & 0x80000000) != 0;
+        dividend <<= 1;
+        if(carry){
+            dividend -= high_divisor;
+        }else{
+            cycles += 2;
+            if(dividend >= high_divisor){
+                dividend -= high_divisor;
+                cycles--;
+            }
+        }
+    }
+    return cycles * 2;
+}
+
+int CYCLES::divs(int32_t dividend, int16_t divisor){
+    int cycles = dividend < 0 ? 7 : 6;
+    uint32_t abs_dividend = dividend < 0 ? 0u - (uint32_t)dividend : (uint32_t)dividend;
+    uint32_t abs_divisor = (uint32_t)std::abs((int32_t)divisor);
+    if((abs_dividend >> 16) >= abs_divisor)
+        return (cycles + 2) * 2; // overflow
+    uint32_t quotient = abs_dividend / abs_divisor;
+    cycles += 55;
+    if(divisor >= 0)
+        cycles += dividend >= 0 ? -1 : 1;
+    for(int i = 0; i < 15; i++){
+        if(!(quotient & 0x8000))
+            cycles++;
+        quotient <<= 1;
+    }
+    return cycles * 2;
+}
@@ -0,0 +1,84 @@
+#include "elf_loader.hpp"
+#include "cpu.hpp"
+#include "elfio/elfio.hpp"
+
+
+namespace M68K {
+
+bool load_elf_image(IMemory& memory, const std::string& file_name, ElfImage& image){
+    ELFIO::elfio elf_reader;
+    if(!elf_reader.load(file_name)){
+        return false;
+    }
+
+    if(
+        (elf_reader.get_class() != ELFIO::ELFCLASS32) ||
+        (elf_reader.get_encoding() != ELFIO::ELFDATA2MSB) ||
+        (elf_reader.get_type() != ELFIO::ET_EXEC) ||
+        (elf_reader.get_machine() != ELFIO::EM_68K)
+    ){
+        return false;
+    }
+
+    image = ElfImage();
+    image.entry = (uint32_t)elf_reader.get_entry();
+
+    for(const auto& segment : elf_reader.segments){
+        if(segment->get_type() != ELFIO::PT_LOAD){
+            continue;
+        }
+        ElfSegment loaded;
+        loaded.address = (uint32_t)segment->get_virtual_address();
+        loaded.file_size = (uint32_t)segment->get_file_size();
+        loaded.memory_size = (uint32_t)segment->get_memory_size();
+        loaded.flags = (uint32_t)segment->get_flags();
+
+        if(loaded.file_size > 0){
+            memory.write_block(loaded.address, (const uint8_t*)segment->get_data(), loaded.file_size);
+        }
+        if(loaded.memory_size > loaded.file_size){
+            memory.fill(loaded.address + loaded.file_size, 0, loaded.memory_size - loaded.file_size);
+        }
+        image.segments.push_back(loaded);
+    }
+
+    for(const auto& section : elf_reader.sections){
+        if(section->get_type() != ELFIO::SHT_SYMTAB){
+            continue;
+        }
+        const ELFIO::symbol_section_accessor symbols(elf_reader, &*section);
+        for(ELFIO::Elf_Xword i = 0; i < symbols.get_symbols_num(); i++){
+            ElfSymbol symbol;
+            ELFIO::Elf64_Addr value = 0;
+            ELFIO::Elf_Xword size = 0;
+            unsigned char bind = 0, type = 0, other = 0;
+            ELFIO::Elf_Half section_index = 0;
+            if(symbols.get_symbol(i, symbol.name, value, size, bind, type, section_index, other) && !symbol.name.empty()){
+                symbol.address = (uint32_t)value;
+                symbol.size = (uint32_t)size;
+                image.symbols.push_back(std::move(symbol));
+            }
+        }
+    }
+    return true;
+}
+
+
+bool load_elf(CPUCore* cpu, const std::string& file_name){
+    ElfImage image;
+    if(!load_elf_image(cpu->state.memory, file_name, image)){
+        return false;
+    }
+
+    // the program starts like after a reset, nothing of the one before carries over
+    cpu->block_cache.clear();
+#if M68K_JIT
+    cpu->jit.clear();
+#endif
+    cpu->state.resetRunState();
+    cpu->state.registers.set(REG_USP, SIZE_LONG, MEMORY_SIZE);
+    cpu->state.registers.set(REG_PC, SIZE_LONG, image.entry);
+    return true;
+}
+
+};  // namespace M68K
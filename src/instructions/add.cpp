@@ -57,16 +57,33 @@ void Add::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t src_data = cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = src_data + dest_data;
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
+    uint64_t result = (uint64_t)src_data + dest_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
-    cpu_state.registers.set(SR_FLAG_EXTEND, IS_CARRY(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_ADD, this->data_size, src_data, dest_data);
+}
+
+namespace {
+// Add with the addressing modes and size of the opcode known at compile time
+template <AddressingMode SrcMode, AddressingMode DestMode, DataSize Size>
+class AddForm final : public Add{
+public:
+    AddForm(uint16_t opcode) : Add(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = cpu_state.getData<SrcMode, Size>(this->src_reg);
+        uint32_t dest_data = cpu_state.getDataSilent<DestMode, Size>(this->dest_reg);
+        uint64_t result = (uint64_t)src_data + dest_data;
+
+        cpu_state.setData<DestMode, Size>(this->dest_reg, (uint32_t)result);
+        cpu_state.registers.setFlags(FLAGS_ADD, Size, src_data, dest_data);
+    }
+};
 }
 
 std::string Add::disassembly(CPUState& cpu_state){
@@ -85,3 +102,21 @@ std::string Add::disassembly(CPUState& cpu_state){
 std::unique_ptr<INSTRUCTION::Instruction> Add::create(uint16_t opcode){
     return std::make_unique<Add>(opcode);
 }
+
+Instruction* Add::construct(uint16_t opcode, void* place){
+    const Add decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            if(decoded.dest_mode == ADDR_MODE_DIRECT_DATA){
+                return withMode(decoded.src_mode, [&](auto src){
+                    return constructForm<AddForm<decltype(src)::value, ADDR_MODE_DIRECT_DATA, decltype(size)::value>, Add>(place, opcode);
+                });
+            }
+            return withMode(decoded.dest_mode, [&](auto dest){
+                return constructForm<AddForm<ADDR_MODE_DIRECT_DATA, decltype(dest)::value, decltype(size)::value>, Add>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) Add(opcode);
+}
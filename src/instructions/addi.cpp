@@ -43,16 +43,13 @@ void Addi::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t src_data = cpu_state.getData(ADDR_MODE_IMMEDIATE, REG_D0, this->data_size);
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = src_data + dest_data;
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
+    uint64_t result = (uint64_t)src_data + dest_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
-    cpu_state.registers.set(SR_FLAG_EXTEND, IS_CARRY(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_ADD, this->data_size, src_data, dest_data);
 }
 
 std::string Addi::disassembly(CPUState& cpu_state){
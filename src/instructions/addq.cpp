@@ -48,20 +48,39 @@ void Addq::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t src_data = this->imm_data;
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = src_data + dest_data;
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
+    uint64_t result = (uint64_t)src_data + dest_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
     if(this->dest_mode != ADDR_MODE_DIRECT_ADDR){
-        cpu_state.registers.set(SR_FLAG_EXTEND, IS_CARRY(result, this->data_size));
-        cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-        cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-        cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-        cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+        cpu_state.registers.setFlags(FLAGS_ADD, this->data_size, src_data, dest_data);
     }
 }
 
+namespace {
+// Addq with the addressing mode and size of the opcode known at compile time
+template <AddressingMode DestMode, DataSize Size>
+class AddqForm final : public Addq{
+public:
+    AddqForm(uint16_t opcode) : Addq(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = this->imm_data;
+        uint32_t dest_data = cpu_state.getDataSilent<DestMode, Size>(this->dest_reg);
+        uint64_t result = (uint64_t)src_data + dest_data;
+
+        cpu_state.setData<DestMode, Size>(this->dest_reg, (uint32_t)result);
+        if(DestMode != ADDR_MODE_DIRECT_ADDR){
+            cpu_state.registers.setFlags(FLAGS_ADD, Size, src_data, dest_data);
+        }
+    }
+};
+}
+
 std::string Addq::disassembly(CPUState& cpu_state){
     uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
     pc += SIZE_WORD;
@@ -78,3 +97,16 @@ std::string Addq::disassembly(CPUState& cpu_state){
 std::unique_ptr<INSTRUCTION::Instruction> Addq::create(uint16_t opcode){
     return std::make_unique<Addq>(opcode);
 }
+
+Instruction* Addq::construct(uint16_t opcode, void* place){
+    const Addq decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            return withMode(decoded.dest_mode, [&](auto mode){
+                return constructForm<AddqForm<decltype(mode)::value, decltype(size)::value>, Addq>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) Addq(opcode);
+}
@@ -57,15 +57,33 @@ void And::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t src_data = cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
     uint64_t result = src_data & dest_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, false);
-    cpu_state.registers.set(SR_FLAG_CARRY, false);
+    cpu_state.registers.setFlags(FLAGS_LOGIC, this->data_size, 0, (uint32_t)result);
+}
+
+namespace {
+// And with the addressing modes and size of the opcode known at compile time
+template <AddressingMode SrcMode, AddressingMode DestMode, DataSize Size>
+class AndForm final : public And{
+public:
+    AndForm(uint16_t opcode) : And(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = cpu_state.getData<SrcMode, Size>(this->src_reg);
+        uint32_t dest_data = cpu_state.getDataSilent<DestMode, Size>(this->dest_reg);
+        uint32_t result = src_data & dest_data;
+
+        cpu_state.setData<DestMode, Size>(this->dest_reg, result);
+        cpu_state.registers.setFlags(FLAGS_LOGIC, Size, 0, result);
+    }
+};
 }
 
 std::string And::disassembly(CPUState& cpu_state){
@@ -85,3 +103,21 @@ std::string And::disassembly(CPUState& cpu_state){
 std::unique_ptr<INSTRUCTION::Instruction> And::create(uint16_t opcode){
     return std::make_unique<And>(opcode);
 }
+
+Instruction* And::construct(uint16_t opcode, void* place){
+    const And decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            if(decoded.dest_mode == ADDR_MODE_DIRECT_DATA){
+                return withMode(decoded.src_mode, [&](auto src){
+                    return constructForm<AndForm<decltype(src)::value, ADDR_MODE_DIRECT_DATA, decltype(size)::value>, And>(place, opcode);
+                });
+            }
+            return withMode(decoded.dest_mode, [&](auto dest){
+                return constructForm<AndForm<ADDR_MODE_DIRECT_DATA, decltype(dest)::value, decltype(size)::value>, And>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) And(opcode);
+}
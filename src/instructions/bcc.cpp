@@ -6,6 +6,7 @@ using namespace M68K;
 using namespace INSTRUCTION;
 
 Bcc::Bcc(uint16_t opcode) : Instruction(opcode){
+    this->is_branch = true;
     uint16_t cond_part = (opcode >> 8) & 0xF;
     
     this->condition = getCondition(cond_part);
@@ -60,6 +61,11 @@ void Bcc::execute(CPUState& cpu_state){
                 pc += displacement;
                 cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
             }
+#if M68K_ACCURATE_CYCLES
+            else{
+                cpu_state.addCycles(this->data_size == SIZE_BYTE ? -2 : 2); // 8 and 12 instead of 10
+            }
+#endif
         }
     }
 }
@@ -46,7 +46,8 @@ void BitManip::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t shift = cpu_state.getData(this->src_mode, this->src_reg, this->data_size) % this->data_bits_modulo;
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
     uint64_t result = dest_data;
 
     bool test_bit_value = (dest_data >> shift) & 0x1;
@@ -73,7 +74,7 @@ void BitManip::execute(CPUState& cpu_state){
             break;
         }
     }
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
     cpu_state.registers.set(SR_FLAG_ZERO, !test_bit_value);
 }
 
@@ -82,87 +82,86 @@ void BitShift::execute(CPUState& cpu_state){
     uint64_t addr_data = cpu_state.getDataSilent(this->addr_mode, this->addr_reg, this->data_size);
     uint64_t shift = this->imm_shift;
     uint64_t result = 0;
+    bool carry = false;
+    FlagsOperation flags = FLAGS_SHIFT;
     if(!this->is_memory && !this->is_imm){
         shift = cpu_state.getData(ADDR_MODE_DIRECT_DATA, this->shift_reg, this->data_size) % 64;
     }
+#if M68K_ACCURATE_CYCLES
+    if(!this->is_memory && (this->opcode & 0x20)){
+        // 2 cycles per bit with the count in a register
+        uint32_t count = cpu_state.registers.get(static_cast<RegisterType>(REG_D0 + ((this->opcode >> 9) & 0x7)), SIZE_LONG);
+        cpu_state.addCycles(2 * (count % 64));
+    }
+#endif
 
     switch (this->instruction_type)
     {
         case InstructionType::AS: {
             if(direction_left){
                 result = addr_data << shift;
-                cpu_state.registers.set(SR_FLAG_CARRY, (addr_data << shift) & 1);
-                cpu_state.registers.set(SR_FLAG_EXTEND, (addr_data << shift) & 1);
+                carry = ((addr_data << shift) & 1) != 0;
             }else{
                 if(IS_NEGATIVE(addr_data, this->data_size)){
                     result = addr_data >> shift | ~(~static_cast<uint64_t>(0) >> shift);
                 }else{
                     result = addr_data >> shift;
                 }
-                cpu_state.registers.set(SR_FLAG_CARRY, (addr_data >> (shift - 1)) & 1);
-                cpu_state.registers.set(SR_FLAG_EXTEND, (addr_data >> (shift - 1)) & 1);
+                carry = ((addr_data >> (shift - 1)) & 1) != 0;
             }
             break;
         }
         case InstructionType::LS: {
             if(direction_left){
                 result = addr_data << shift;
-                cpu_state.registers.set(SR_FLAG_CARRY, (addr_data << shift) & 1);
-                cpu_state.registers.set(SR_FLAG_EXTEND, (addr_data << shift) & 1);
+                carry = ((addr_data << shift) & 1) != 0;
             }else{
                 result = addr_data >> shift;
-                cpu_state.registers.set(SR_FLAG_CARRY, (addr_data >> (shift - 1)) & 1);
-                cpu_state.registers.set(SR_FLAG_EXTEND, (addr_data >> (shift - 1)) & 1);
+                carry = ((addr_data >> (shift - 1)) & 1) != 0;
             }
             break;
         }
         case InstructionType::ROX: {
-            uint64_t carry = cpu_state.registers.get(SR_FLAG_CARRY) ? 1 : 0;
+            uint64_t carry_in = cpu_state.registers.get(SR_FLAG_CARRY) ? 1 : 0;
             if(direction_left){
                 switch(this->data_size){
                     case SIZE_BYTE:{
-                        result = addr_data | (carry << 8);
+                        result = addr_data | (carry_in << 8);
                         result = ROL_9(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result));
+                        carry = result != 0;
                         break;
                     }
                     case SIZE_WORD: {
-                        result = addr_data | (carry << 16);
+                        result = addr_data | (carry_in << 16);
                         result = ROL_17(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result >> 8));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result >> 8));
+                        carry = (result >> 8) != 0;
                         break;
                     }
                     case SIZE_LONG: {
-                        result = addr_data | (carry << 32);
+                        result = addr_data | (carry_in << 32);
                         result = ROL_33(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result >> 24));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result >> 24));
+                        carry = (result >> 24) != 0;
                         break;
                     }
                 }
             }else{
                 switch(this->data_size){
                     case SIZE_BYTE:{
-                        result = result | (carry << 8);
+                        result = result | (carry_in << 8);
                         result = ROR_9(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result));
+                        carry = result != 0;
                         break;
                     }
                     case SIZE_WORD: {
-                        result = result | (carry << 16);
+                        result = result | (carry_in << 16);
                         result = ROR_17(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result >> 8));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result >> 8));
+                        carry = (result >> 8) != 0;
                         break;
                     }
                     case SIZE_LONG: {
-                        result = result | (carry << 32);
+                        result = result | (carry_in << 32);
                         result = ROR_33(result, shift);
-                        cpu_state.registers.set(SR_FLAG_CARRY, (result >> 24));
-                        cpu_state.registers.set(SR_FLAG_EXTEND, (result >> 24));
+                        carry = (result >> 24) != 0;
                         break;
                     }
                 }
@@ -173,12 +172,13 @@ void BitShift::execute(CPUState& cpu_state){
             break;
         }
         case InstructionType::RO: {
+            flags = FLAGS_ROTATE;
             if(direction_left){
                 result = ROL(addr_data, shift, this->data_size);
-                cpu_state.registers.set(SR_FLAG_CARRY, addr_data >> (8 - shift));
+                carry = (addr_data >> (8 - shift)) != 0;
             }else{
                 result = ROR(addr_data, shift, this->data_size);
-                cpu_state.registers.set(SR_FLAG_CARRY, addr_data << (9 - shift));
+                carry = (addr_data << (9 - shift)) != 0;
             }
             // cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
             // cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
@@ -187,9 +187,7 @@ void BitShift::execute(CPUState& cpu_state){
         }
     }
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, false);   
+    cpu_state.registers.setFlags(flags, this->data_size, carry ? 1 : 0, (uint32_t)result);
 }
 
 std::string BitShift::disassembly(CPUState& cpu_state){
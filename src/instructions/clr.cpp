@@ -44,10 +44,7 @@ void Clr::execute(CPUState& cpu_state){
 
     cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, 0);
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, false);
-    cpu_state.registers.set(SR_FLAG_ZERO, true);
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, false);
-    cpu_state.registers.set(SR_FLAG_CARRY, false);
+    cpu_state.registers.setFlags(FLAGS_LOGIC, this->data_size, 0, 0);
 }
 
 std::string Clr::disassembly(CPUState& cpu_state){
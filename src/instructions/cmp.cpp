@@ -44,12 +44,26 @@ void Cmp::execute(CPUState& cpu_state){
 
     uint32_t src_data = cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
     uint32_t dest_data = cpu_state.getData(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = dest_data - src_data;
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_CMP, this->data_size, src_data, dest_data);
+}
+
+namespace {
+// Cmp with the addressing modes and size of the opcode known at compile time
+template <AddressingMode SrcMode, AddressingMode DestMode, DataSize Size>
+class CmpForm final : public Cmp{
+public:
+    CmpForm(uint16_t opcode) : Cmp(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = cpu_state.getData<SrcMode, Size>(this->src_reg);
+        uint32_t dest_data = cpu_state.getData<DestMode, Size>(this->dest_reg);
+
+        cpu_state.registers.setFlags(FLAGS_CMP, Size, src_data, dest_data);
+    }
+};
 }
 
 std::string Cmp::disassembly(CPUState& cpu_state){
@@ -68,4 +82,17 @@ std::string Cmp::disassembly(CPUState& cpu_state){
 
 std::unique_ptr<INSTRUCTION::Instruction> Cmp::create(uint16_t opcode){
     return std::make_unique<Cmp>(opcode);
-}
\ No newline at end of file
+}
+
+Instruction* Cmp::construct(uint16_t opcode, void* place){
+    const Cmp decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            return withMode(decoded.src_mode, [&](auto src){
+                return constructForm<CmpForm<decltype(src)::value, ADDR_MODE_DIRECT_DATA, decltype(size)::value>, Cmp>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) Cmp(opcode);
+}
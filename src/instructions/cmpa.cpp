@@ -43,12 +43,8 @@ void Cmpa::execute(CPUState& cpu_state){
         src_data = static_cast<int32_t>(static_cast<int16_t>(src_data));
     };
     uint32_t dest_data = cpu_state.getData(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = dest_data - src_data;
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_CMP, this->data_size, src_data, dest_data);
 }
 
 std::string Cmpa::disassembly(CPUState& cpu_state){
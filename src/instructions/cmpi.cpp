@@ -44,12 +44,8 @@ void Cmpi::execute(CPUState& cpu_state){
 
     uint32_t src_data = cpu_state.getData(ADDR_MODE_IMMEDIATE, REG_D0, this->data_size);
     uint32_t dest_data = cpu_state.getData(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = dest_data - src_data;
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_CMP, this->data_size, src_data, dest_data);
 }
 
 std::string Cmpi::disassembly(CPUState& cpu_state){
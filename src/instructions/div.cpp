@@ -1,4 +1,5 @@
 #include "instructions/div.hpp"
+#include "cycles.hpp"
 #include "helpers.hpp"
 #include <stdexcept>
 
@@ -27,6 +28,21 @@ void Div::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint16_t src_data = (uint16_t)cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
+#if M68K_ACCURATE_CYCLES
+    {
+        // a zero divide takes 38 cycles with the exception processing
+        uint32_t dividend = cpu_state.registers.get(this->dest_reg, SIZE_LONG);
+        int exact = src_data == 0 ? 38 - CYCLES::exception(VECTOR_ZERO_DIVIDE)
+                  : this->is_signed ? CYCLES::divs((int32_t)dividend, (int16_t)src_data)
+                  : CYCLES::divu(dividend, src_data);
+        cpu_state.addCycles(exact - (this->is_signed ? CYCLES::DIVS : CYCLES::DIVU));
+    }
+#endif
+    if(src_data == 0){
+        // the handler returns to the next instruction, the destination is left alone
+        cpu_state.raiseException(VECTOR_ZERO_DIVIDE);
+        return;
+    }
     uint16_t dest_data = (uint16_t)cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
     uint32_t result;
 
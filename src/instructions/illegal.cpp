@@ -1,15 +1,16 @@
 #include "instructions/illegal.hpp"
-#include <stdexcept>
 
 using namespace M68K;
 using namespace INSTRUCTION;
 
 void Illegal::execute(CPUState& cpu_state){
-    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
-    pc += SIZE_WORD;
-    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
-
-    throw std::invalid_argument("Invalid opcode");
+    // invalid opcodes share one instance per line, the line A and F emulator traps have their own.
+    // The PC stays at the instruction, the handler returns to it.
+    switch(this->opcode >> 12){
+        case 0xA: cpu_state.raiseException(VECTOR_LINE_A); break;
+        case 0xF: cpu_state.raiseException(VECTOR_LINE_F); break;
+        default: cpu_state.raiseException(VECTOR_ILLEGAL_INSTRUCTION); break;
+    }
 }
 
 std::string Illegal::disassembly(CPUState& cpu_state){
@@ -6,6 +6,7 @@ using namespace M68K;
 using namespace INSTRUCTION;
 
 Jsr::Jsr(uint16_t opcode) : Instruction(opcode){
+    this->is_branch = true;
     uint16_t ea_mode_part = (opcode >> 3) & 0x7;
     uint16_t ea_reg_part = (opcode >> 0) & 0x7;
 
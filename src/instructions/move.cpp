@@ -75,13 +75,28 @@ void Move::execute(CPUState& cpu_state){
         cpu_state.setData(this->dest_mode, this->dest_reg, SIZE_LONG, src_data);
     }else{
         cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, src_data);
-        cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(src_data, this->data_size));
-        cpu_state.registers.set(SR_FLAG_ZERO, src_data == 0);
-        cpu_state.registers.set(SR_FLAG_OVERFLOW, false);
-        cpu_state.registers.set(SR_FLAG_CARRY, false);
+        cpu_state.registers.setFlags(FLAGS_LOGIC, this->data_size, 0, src_data);
     }
 }
 
+namespace {
+// Move with the addressing modes and size of the opcode known at compile time
+template <AddressingMode SrcMode, AddressingMode DestMode, DataSize Size>
+class MoveForm final : public Move{
+public:
+    MoveForm(uint16_t opcode) : Move(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = cpu_state.getData<SrcMode, Size>(this->src_reg);
+
+        cpu_state.setData<DestMode, Size>(this->dest_reg, src_data);
+        cpu_state.registers.setFlags(FLAGS_LOGIC, Size, 0, src_data);
+    }
+};
+}
+
 std::string Move::disassembly(CPUState& cpu_state){
     uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
     pc += SIZE_WORD;
@@ -97,4 +112,19 @@ std::string Move::disassembly(CPUState& cpu_state){
 
 std::unique_ptr<INSTRUCTION::Instruction> Move::create(uint16_t opcode){
     return std::make_unique<Move>(opcode);
-}
\ No newline at end of file
+}
+
+Instruction* Move::construct(uint16_t opcode, void* place){
+    const Move decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid && !decoded.is_movea){
+        form = withSize(decoded.data_size, [&](auto size){
+            return withMode(decoded.src_mode, [&](auto src){
+                return withMode(decoded.dest_mode, [&](auto dest){
+                    return constructForm<MoveForm<decltype(src)::value, decltype(dest)::value, decltype(size)::value>, Move>(place, opcode);
+                });
+            });
+        });
+    }
+    return form ? form : new (place) Move(opcode);
+}
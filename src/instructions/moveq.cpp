@@ -19,12 +19,10 @@ void Moveq::execute(CPUState& cpu_state){
     pc += SIZE_WORD;
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, this->imm_data);
+    uint32_t data = static_cast<uint32_t>(static_cast<int32_t>(static_cast<int8_t>(this->imm_data)));
+    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, data);
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(this->imm_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, this->imm_data == 0);
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, false);
-    cpu_state.registers.set(SR_FLAG_CARRY, false);
+    cpu_state.registers.setFlags(FLAGS_LOGIC, this->data_size, 0, data);
 }
 
 std::string Moveq::disassembly(CPUState& cpu_state){
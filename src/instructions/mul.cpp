@@ -1,4 +1,5 @@
 #include "instructions/mul.hpp"
+#include "cycles.hpp"
 #include "helpers.hpp"
 #include <stdexcept>
 
@@ -29,6 +30,9 @@ void Mul::execute(CPUState& cpu_state){
     uint16_t src_data = (uint16_t)cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
     uint16_t dest_data = (uint16_t)cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
     uint32_t result;
+#if M68K_ACCURATE_CYCLES
+    cpu_state.addCycles((this->is_signed ? CYCLES::muls(src_data) : CYCLES::mulu(src_data)) - CYCLES::MUL);
+#endif
 
     if(this->is_signed){
         result = static_cast<uint32_t>(static_cast<int16_t>(src_data) * static_cast<int16_t>(dest_data));
@@ -0,0 +1,38 @@
+#include "instructions/rte.hpp"
+#include "helpers.hpp"
+
+using namespace M68K;
+using namespace INSTRUCTION;
+
+Rte::Rte(uint16_t opcode) : Instruction(opcode){
+    this->is_branch = true;
+}
+
+void Rte::execute(CPUState& cpu_state){
+    if(!cpu_state.registers.sr.supervisor){
+        cpu_state.addCycles(4 - (int)this->cycles);
+        cpu_state.raiseException(VECTOR_PRIVILEGE_VIOLATION);
+        return;
+    }
+
+    // short frame only, handlers of bus and address errors drop the extra 8 bytes first
+    uint32_t sr = cpu_state.stackPop(SIZE_WORD);
+    uint32_t return_addr = cpu_state.stackPop(SIZE_LONG);
+    if(cpu_state.pendingException() != VECTOR_NONE)
+        return;
+
+    cpu_state.registers.materializeFlags();
+    cpu_state.registers.set(REG_SR, SIZE_WORD, sr & 0xA71F);
+    cpu_state.registers.set(REG_PC, SIZE_LONG, return_addr);
+}
+
+std::string Rte::disassembly(CPUState& cpu_state){
+    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
+    pc += SIZE_WORD;
+    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
+    return "rte";
+}
+
+std::unique_ptr<INSTRUCTION::Instruction> Rte::create(uint16_t opcode){
+    return std::make_unique<Rte>(opcode);
+}
@@ -6,7 +6,7 @@ using namespace M68K;
 using namespace INSTRUCTION;
 
 Rts::Rts(uint16_t opcode) : Instruction(opcode){
-    ;
+    this->is_branch = true;
 }
 
 void Rts::execute(CPUState& cpu_state){
@@ -27,6 +27,10 @@ void Scc::execute(CPUState& cpu_state){
 
     bool cond_result = cpu_state.checkCondition(this->condition);
     if(cond_result){
+#if M68K_ACCURATE_CYCLES
+        if(this->dest_mode == ADDR_MODE_DIRECT_DATA)
+            cpu_state.addCycles(2);
+#endif
         cpu_state.setData(this->dest_mode, this->dest_reg, SIZE_BYTE, 0xFF);
     }else{
         cpu_state.setData(this->dest_mode, this->dest_reg, SIZE_BYTE, 0x00);
@@ -0,0 +1,44 @@
+#include "instructions/stop.hpp"
+#include "helpers.hpp"
+
+using namespace M68K;
+using namespace INSTRUCTION;
+
+Stop::Stop(uint16_t opcode) : Instruction(opcode){
+    this->is_branch = true; // the CPU waits after it, nothing of its block may follow
+}
+
+void Stop::execute(CPUState& cpu_state){
+    if(!cpu_state.registers.sr.supervisor){
+        cpu_state.raiseException(VECTOR_PRIVILEGE_VIOLATION);
+        return;
+    }
+
+    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
+    pc += SIZE_WORD;
+    uint32_t sr = cpu_state.readMemory(pc, SIZE_WORD);
+    pc += SIZE_WORD;
+    if(cpu_state.pendingException() != VECTOR_NONE)
+        return;
+
+    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
+    cpu_state.registers.materializeFlags();
+    cpu_state.registers.set(REG_SR, SIZE_WORD, sr & 0xA71F);
+    cpu_state.stopped = true;
+}
+
+std::string Stop::disassembly(CPUState& cpu_state){
+    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
+    pc += SIZE_WORD;
+    uint32_t sr = cpu_state.readMemory(pc, SIZE_WORD);
+    pc += SIZE_WORD;
+    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
+
+    std::ostringstream output;
+    output << "stop #$" << std::hex << sr;
+    return output.str();
+}
+
+std::unique_ptr<INSTRUCTION::Instruction> Stop::create(uint16_t opcode){
+    return std::make_unique<Stop>(opcode);
+}
@@ -57,16 +57,33 @@ void Sub::execute(CPUState& cpu_state){
     cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
 
     uint32_t src_data = cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = dest_data - src_data;
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
+    uint64_t result = (uint64_t)dest_data - src_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
-    cpu_state.registers.set(SR_FLAG_EXTEND, IS_CARRY(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
+    cpu_state.registers.setFlags(FLAGS_SUB, this->data_size, src_data, dest_data);
+}
+
+namespace {
+// Sub with the addressing modes and size of the opcode known at compile time
+template <AddressingMode SrcMode, AddressingMode DestMode, DataSize Size>
+class SubForm final : public Sub{
+public:
+    SubForm(uint16_t opcode) : Sub(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t src_data = cpu_state.getData<SrcMode, Size>(this->src_reg);
+        uint32_t dest_data = cpu_state.getDataSilent<DestMode, Size>(this->dest_reg);
+        uint64_t result = (uint64_t)dest_data - src_data;
+
+        cpu_state.setData<DestMode, Size>(this->dest_reg, (uint32_t)result);
+        cpu_state.registers.setFlags(FLAGS_SUB, Size, src_data, dest_data);
+    }
+};
 }
 
 std::string Sub::disassembly(CPUState& cpu_state){
@@ -85,3 +102,21 @@ std::string Sub::disassembly(CPUState& cpu_state){
 std::unique_ptr<INSTRUCTION::Instruction> Sub::create(uint16_t opcode){
     return std::make_unique<Sub>(opcode);
 }
+
+Instruction* Sub::construct(uint16_t opcode, void* place){
+    const Sub decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            if(decoded.dest_mode == ADDR_MODE_DIRECT_DATA){
+                return withMode(decoded.src_mode, [&](auto src){
+                    return constructForm<SubForm<decltype(src)::value, ADDR_MODE_DIRECT_DATA, decltype(size)::value>, Sub>(place, opcode);
+                });
+            }
+            return withMode(decoded.dest_mode, [&](auto dest){
+                return constructForm<SubForm<ADDR_MODE_DIRECT_DATA, decltype(dest)::value, decltype(size)::value>, Sub>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) Sub(opcode);
+}
@@ -45,10 +45,11 @@ void Subx::execute(CPUState& cpu_state){
 
     uint32_t extend_data = cpu_state.registers.get(SR_FLAG_EXTEND) ? 1 : 0;
     uint32_t src_data = cpu_state.getData(this->src_mode, this->src_reg, this->data_size);
-    uint32_t dest_data = cpu_state.getDataSilent(this->dest_mode, this->dest_reg, this->data_size);
-    uint64_t result = dest_data - src_data - extend_data;
+    EffectiveAddress dest = cpu_state.resolveEA(this->dest_mode, this->dest_reg, this->data_size);
+    uint32_t dest_data = cpu_state.getData(dest, this->data_size);
+    uint64_t result = (uint64_t)dest_data - src_data - extend_data;
 
-    cpu_state.setData(this->dest_mode, this->dest_reg, this->data_size, (uint32_t)result);
+    cpu_state.setData(dest, this->data_size, (uint32_t)result);
 
     if(!IS_ZERO(result, this->data_size)){ // change only if non zero
         cpu_state.registers.set(SR_FLAG_ZERO, false); 
@@ -56,7 +57,9 @@ void Subx::execute(CPUState& cpu_state){
 
     cpu_state.registers.set(SR_FLAG_EXTEND, IS_CARRY(result, this->data_size));
     cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(result, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_OVERFLOW(src_data, dest_data, this->data_size));
+    // overflow of dest - src - X, as IS_OVERFLOW_SUB() with the extend bit
+    uint32_t overflow = (src_data ^ dest_data) & (dest_data ^ (uint32_t)result);
+    cpu_state.registers.set(SR_FLAG_OVERFLOW, IS_NEGATIVE(overflow, this->data_size));
     cpu_state.registers.set(SR_FLAG_CARRY, IS_CARRY(result, this->data_size));
 }
 
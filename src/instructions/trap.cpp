@@ -0,0 +1,32 @@
+#include "instructions/trap.hpp"
+#include "helpers.hpp"
+
+using namespace M68K;
+using namespace INSTRUCTION;
+
+Trap::Trap(uint16_t opcode) : Instruction(opcode){
+    this->vector = (opcode >> 0) & 0xF;
+    this->is_branch = true;
+}
+
+void Trap::execute(CPUState& cpu_state){
+    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
+    pc += SIZE_WORD;
+    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
+
+    cpu_state.raiseException(static_cast<ExceptionVector>(VECTOR_TRAP_0 + this->vector));
+}
+
+std::string Trap::disassembly(CPUState& cpu_state){
+    uint32_t pc = cpu_state.registers.get(REG_PC, SIZE_LONG);
+    pc += SIZE_WORD;
+    cpu_state.registers.set(REG_PC, SIZE_LONG, pc);
+
+    std::ostringstream output;
+    output << "trap #" << this->vector;
+    return output.str();
+}
+
+std::unique_ptr<INSTRUCTION::Instruction> Trap::create(uint16_t opcode){
+    return std::make_unique<Trap>(opcode);
+}
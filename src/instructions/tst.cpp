@@ -39,10 +39,23 @@ void Tst::execute(CPUState& cpu_state){
 
     uint32_t ea_data = cpu_state.getData(this->ea_mode, this->ea_reg, this->data_size);
 
-    cpu_state.registers.set(SR_FLAG_NEGATIVE, IS_NEGATIVE(ea_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_ZERO, IS_ZERO(ea_data, this->data_size));
-    cpu_state.registers.set(SR_FLAG_OVERFLOW, false);
-    cpu_state.registers.set(SR_FLAG_CARRY, false);
+    cpu_state.registers.setFlags(FLAGS_LOGIC, this->data_size, 0, ea_data);
+}
+
+namespace {
+// Tst with the addressing mode and size of the opcode known at compile time
+template <AddressingMode Mode, DataSize Size>
+class TstForm final : public Tst{
+public:
+    TstForm(uint16_t opcode) : Tst(opcode){}
+
+    void execute(CPUState& cpu_state) override{
+        cpu_state.registers.pc += SIZE_WORD;
+
+        uint32_t ea_data = cpu_state.getData<Mode, Size>(this->ea_reg);
+        cpu_state.registers.setFlags(FLAGS_LOGIC, Size, 0, ea_data);
+    }
+};
 }
 
 std::string Tst::disassembly(CPUState& cpu_state){
@@ -57,4 +70,17 @@ std::string Tst::disassembly(CPUState& cpu_state){
 
 std::unique_ptr<INSTRUCTION::Instruction> Tst::create(uint16_t opcode){
     return std::make_unique<Tst>(opcode);
-}
\ No newline at end of file
+}
+
+Instruction* Tst::construct(uint16_t opcode, void* place){
+    const Tst decoded(opcode);
+    Instruction* form = nullptr;
+    if(decoded.is_valid){
+        form = withSize(decoded.data_size, [&](auto size){
+            return withMode(decoded.ea_mode, [&](auto mode){
+                return constructForm<TstForm<decltype(mode)::value, decltype(size)::value>, Tst>(place, opcode);
+            });
+        });
+    }
+    return form ? form : new (place) Tst(opcode);
+}
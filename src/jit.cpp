@@ -0,0 +1,1231 @@
+#include "jit.hpp"
+
+#if M68K_JIT
+
+#include "helpers.hpp"
+#include "instructions/add.hpp"
+#include "instructions/adda.hpp"
+#include "instructions/addq.hpp"
+#include "instructions/and.hpp"
+#include "instructions/bcc.hpp"
+#include "instructions/clr.hpp"
+#include "instructions/cmp.hpp"
+#include "instructions/cmpa.hpp"
+#include "instructions/eor.hpp"
+#include "instructions/lea.hpp"
+#include "instructions/move.hpp"
+#include "instructions/moveq.hpp"
+#include "instructions/or.hpp"
+#include "instructions/sub.hpp"
+#include "instructions/suba.hpp"
+#include "instructions/subq.hpp"
+#include "instructions/tst.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace M68K;
+using namespace INSTRUCTION;
+
+namespace {
+
+enum HostReg : uint8_t { RAX = 0, RCX, RDX, RBX, RSP, RBP, RSI, RDI, R8, R9, R10, R11, R12, R13, R14, R15 };
+
+enum HostCond : uint8_t {
+    HC_O = 0x0, HC_NO = 0x1, HC_B = 0x2, HC_AE = 0x3, HC_E = 0x4, HC_NE = 0x5, HC_BE = 0x6, HC_A = 0x7,
+    HC_S = 0x8, HC_NS = 0x9, HC_L = 0xC, HC_GE = 0xD, HC_LE = 0xE, HC_G = 0xF,
+};
+
+// ModRM extension of the 0x80/0x81 group, (op << 3) is the opcode of the register forms
+enum HostAlu : uint8_t { ALU_ADD = 0, ALU_OR = 1, ALU_AND = 4, ALU_SUB = 5, ALU_XOR = 6, ALU_CMP = 7 };
+
+#if defined(_WIN32)
+const HostReg ARG0 = RCX, ARG1 = RDX, ARG2 = R8, ARG3 = R9;
+const int32_t SHADOW_SPACE = 32;
+#else
+const HostReg ARG0 = RDI, ARG1 = RSI, ARG2 = RDX, ARG3 = RCX;
+const int32_t SHADOW_SPACE = 0;
+#endif
+
+const int32_t SLOT_CONTEXT = SHADOW_SPACE + 0;
+const int32_t SLOT_ADDRESS = SHADOW_SPACE + 8;     // read-modify-write target
+const int32_t SLOT_CONDITION = SHADOW_SPACE + 16;  // Bcc condition computed by the previous instruction
+const int32_t SLOT_SR = SHADOW_SPACE + 24;         // SR before the flags of a write, restored if it faults
+const int32_t FRAME_SIZE = SHADOW_SPACE + 40;      // rsp stays 16 byte aligned after the pushes below
+
+const HostReg SAVED_REGS[] = {RBX, RBP, R12, R13, R14, R15, RSI, RDI};
+const HostReg CACHE_REGS[] = {RBX, RBP, R12, R13, R14};  // guest registers, r15 holds the register file
+const int CACHE_SIZE = 5;
+
+const int32_t OFFSET_PC = REG_PC * 4;
+const int32_t OFFSET_SR = REG_SR * 4;
+
+const uint8_t CCR_NZVC = SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY;
+const uint8_t CCR_ALL = CCR_NZVC | SR_FLAG_EXTEND;
+
+
+// Helpers called from native code, nothing may unwind through it. Memory accesses report
+// faults as guest exceptions, which exit the block, and run() enters their handler.
+uint64_t jitRead(JitContext* context, uint32_t address, uint32_t size) noexcept {
+    uint32_t data = context->state->readMemory(address, static_cast<DataSize>(size));
+    return context->state->pendingException() != VECTOR_NONE ? 1ull << 32 : data;
+}
+
+uint32_t jitWrite(JitContext* context, uint32_t address, uint32_t size, uint32_t data) noexcept {
+    context->state->writeMemory(address, static_cast<DataSize>(size), data);
+    return context->state->pendingException() != VECTOR_NONE ? 1 : 0;
+}
+
+uint32_t jitExecute(JitContext* context, Instruction* instruction) noexcept {
+    CPUState& state = *context->state;
+    Registers before = state.registers;
+    uint32_t faulted = 0;
+    instruction->execute(state);
+    if (state.pendingException() != VECTOR_NONE) {
+        state.abortOnFault(before);  // back at the instruction, its frame is built from that PC
+        faulted = 1;
+    }
+    state.registers.materializeFlags();
+    return faulted;
+}
+
+uint32_t jitCondition(JitContext* context, uint32_t condition) noexcept {
+    return context->state->checkCondition(static_cast<Condition>(condition)) ? 1 : 0;
+}
+
+
+struct Operand {  // x86 r/m operand
+    bool memory;
+    HostReg reg;  // register or base
+    int32_t disp;
+};
+
+Operand reg(HostReg r) {
+    Operand o = {false, r, 0};
+    return o;
+}
+
+Operand mem(HostReg base, int32_t disp) {
+    Operand o = {true, base, disp};
+    return o;
+}
+
+
+class Emitter {
+public:
+    std::vector<uint8_t> bytes;
+
+    std::size_t position() const {
+        return bytes.size();
+    }
+
+    void u8(uint32_t v) {
+        bytes.push_back(static_cast<uint8_t>(v));
+    }
+    void u16(uint32_t v) {
+        u8(v);
+        u8(v >> 8);
+    }
+    void u32(uint32_t v) {
+        u16(v);
+        u16(v >> 16);
+    }
+    void u64(uint64_t v) {
+        u32(static_cast<uint32_t>(v));
+        u32(static_cast<uint32_t>(v >> 32));
+    }
+
+    // operand size prefix and REX, reg_field is a register when byte_reg is set and an opcode extension otherwise
+    void prefix(int size, bool wide, int reg_field, bool byte_reg, const Operand& rm) {
+        if (size == 2)
+            u8(0x66);
+        uint8_t rex = 0x40;
+        if (wide)
+            rex |= 0x08;
+        if (reg_field >= 8)
+            rex |= 0x04;
+        if (rm.reg >= 8)
+            rex |= 0x01;
+        // spl, bpl, sil and dil need a REX prefix
+        bool force = size == 1 && ((byte_reg && reg_field >= 4 && reg_field < 8) ||
+                                   (!rm.memory && rm.reg >= 4 && rm.reg < 8));
+        if (rex != 0x40 || force)
+            u8(rex);
+    }
+
+    void modrm(int reg_field, const Operand& rm) {
+        uint8_t r = static_cast<uint8_t>((reg_field & 7) << 3);
+        if (!rm.memory) {
+            u8(0xC0 | r | (rm.reg & 7));
+            return;
+        }
+        bool short_disp = rm.disp >= -128 && rm.disp <= 127;
+        u8((short_disp ? 0x40 : 0x80) | r | (rm.reg & 7));
+        if ((rm.reg & 7) == RSP)
+            u8(0x24);
+        if (short_disp)
+            u8(static_cast<uint32_t>(rm.disp));
+        else
+            u32(static_cast<uint32_t>(rm.disp));
+    }
+
+    void immediate(int size, uint32_t imm) {
+        if (size == 1)
+            u8(imm);
+        else if (size == 2)
+            u16(imm);
+        else
+            u32(imm);
+    }
+
+    // op r/m, r
+    void alu(HostAlu op, int size, const Operand& dst, HostReg src) {
+        prefix(size, false, src, true, dst);
+        u8((op << 3) | (size == 1 ? 0x00 : 0x01));
+        modrm(src, dst);
+    }
+    // op r/m, imm
+    void aluImm(HostAlu op, int size, const Operand& dst, uint32_t imm) {
+        prefix(size, false, op, false, dst);
+        u8(size == 1 ? 0x80 : 0x81);
+        modrm(op, dst);
+        immediate(size, imm);
+    }
+    void aluImm64(HostAlu op, HostReg dst, uint32_t imm) {
+        prefix(4, true, op, false, reg(dst));
+        u8(0x81);
+        modrm(op, reg(dst));
+        u32(imm);
+    }
+
+    void mov(int size, const Operand& dst, HostReg src) {
+        prefix(size, false, src, true, dst);
+        u8(size == 1 ? 0x88 : 0x89);
+        modrm(src, dst);
+    }
+    void movLoad(int size, HostReg dst, const Operand& src) {
+        prefix(size, false, dst, true, src);
+        u8(size == 1 ? 0x8A : 0x8B);
+        modrm(dst, src);
+    }
+    void movImm(int size, const Operand& dst, uint32_t imm) {
+        prefix(size, false, 0, false, dst);
+        u8(size == 1 ? 0xC6 : 0xC7);
+        modrm(0, dst);
+        immediate(size, imm);
+    }
+    void movImm32(HostReg dst, uint32_t imm) {
+        if (dst >= 8)
+            u8(0x41);
+        u8(0xB8 + (dst & 7));
+        u32(imm);
+    }
+    void movImm64(HostReg dst, uint64_t imm) {
+        u8(0x48 | (dst >= 8 ? 0x01 : 0x00));
+        u8(0xB8 + (dst & 7));
+        u64(imm);
+    }
+    void load64(HostReg dst, const Operand& src) {
+        prefix(4, true, dst, false, src);
+        u8(0x8B);
+        modrm(dst, src);
+    }
+    void store64(const Operand& dst, HostReg src) {
+        prefix(4, true, src, false, dst);
+        u8(0x89);
+        modrm(src, dst);
+    }
+    void movzx8(HostReg dst, HostReg src) {
+        prefix(1, false, dst, false, reg(src));
+        u8(0x0F);
+        u8(0xB6);
+        modrm(dst, reg(src));
+    }
+    void movsx16(HostReg dst, HostReg src) {
+        prefix(4, false, dst, false, reg(src));
+        u8(0x0F);
+        u8(0xBF);
+        modrm(dst, reg(src));
+    }
+
+    void test(int size, const Operand& a, HostReg b) {
+        prefix(size, false, b, true, a);
+        u8(size == 1 ? 0x84 : 0x85);
+        modrm(b, a);
+    }
+    void testImm(const Operand& a, uint32_t imm) {
+        prefix(4, false, 0, false, a);
+        u8(0xF7);
+        modrm(0, a);
+        u32(imm);
+    }
+    void setcc(HostCond cc, const Operand& dst) {
+        prefix(1, false, 0, false, dst);
+        u8(0x0F);
+        u8(0x90 | cc);
+        modrm(0, dst);
+    }
+    void shlImm(HostReg r, uint8_t count) {
+        prefix(4, false, 4, false, reg(r));
+        u8(0xC1);
+        modrm(4, reg(r));
+        u8(count);
+    }
+    void shr64Imm(HostReg r, uint8_t count) {
+        prefix(4, true, 5, false, reg(r));
+        u8(0xC1);
+        modrm(5, reg(r));
+        u8(count);
+    }
+
+    void push(HostReg r) {
+        if (r >= 8)
+            u8(0x41);
+        u8(0x50 + (r & 7));
+    }
+    void pop(HostReg r) {
+        if (r >= 8)
+            u8(0x41);
+        u8(0x58 + (r & 7));
+    }
+    void call(HostReg r) {
+        prefix(4, false, 2, false, reg(r));
+        u8(0xFF);
+        modrm(2, reg(r));
+    }
+    void ret() {
+        u8(0xC3);
+    }
+
+    // returns the position right after the rel32 field, see bind()
+    std::size_t jcc(HostCond cc) {
+        u8(0x0F);
+        u8(0x80 | cc);
+        u32(0);
+        return position();
+    }
+    void bind(std::size_t jump, std::size_t target) {
+        int32_t rel = static_cast<int32_t>(target - jump);
+        std::memcpy(&bytes[jump - 4], &rel, sizeof(rel));
+    }
+};  // class Emitter
+//////////////////////////////////////////////////////////////////////////
+
+
+
+struct Ea {
+    enum Kind { NONE, DREG, AREG, INDIRECT, POSTINC, PREDEC, DISP, ABSOLUTE, IMMEDIATE };
+
+    Kind kind = NONE;
+    int reg = 0;         // guest register index, address registers are 8..15
+    uint32_t value = 0;  // displacement, absolute address or immediate data
+
+    bool isRegister() const {
+        return kind == DREG || kind == AREG;
+    }
+    bool isMemory() const {
+        return kind >= INDIRECT && kind <= ABSOLUTE;
+    }
+    bool usesRegister() const {
+        return kind >= DREG && kind <= DISP;
+    }
+};
+
+
+struct Op {
+    enum Kind { FALLBACK, MOVE, MOVEA, MOVEQ, ALU, ALU_ADDR, QUICK, TST, CLR, LEA, BRANCH };
+
+    Kind kind = FALLBACK;
+    HostAlu alu = ALU_ADD;
+    int size = SIZE_LONG;
+    Ea src, dst;
+    uint32_t imm = 0;
+    Condition condition = COND_TRUE;
+    uint32_t pc = 0;
+    uint32_t next_pc = 0;
+    uint32_t target = 0;
+
+    uint8_t defs = 0;  // CCR bits written
+    uint8_t uses = 0;  // CCR bits that have to be in SR before the op
+    uint8_t live = 0;  // defs read later, these get materialized
+    bool feeds_branch = false;      // sets the condition of the Bcc that follows
+    bool condition_saved = false;   // Bcc, condition was stored by the previous op
+};
+
+
+int standardSize(uint16_t bits) {
+    switch (bits & 0x3) {
+        case 0x0: return SIZE_BYTE;
+        case 0x1: return SIZE_WORD;
+        case 0x2: return SIZE_LONG;
+        default: return 0;
+    }
+}
+
+HostCond hostCondition(Condition cond) {
+    switch (cond) {
+        case COND_HIGHER: return HC_A;
+        case COND_LOWER_SAME: return HC_BE;
+        case COND_CARRY_CLEAR: return HC_AE;
+        case COND_CARRY_SET: return HC_B;
+        case COND_NOT_EQUAL: return HC_NE;
+        case COND_EQUAL: return HC_E;
+        case COND_OVERFLOW_CLEAR: return HC_NO;
+        case COND_OVERFLOW_SET: return HC_O;
+        case COND_PLUS: return HC_NS;
+        case COND_MINUS: return HC_S;
+        case COND_GREATER_EQUAL: return HC_GE;
+        case COND_LESS_THAN: return HC_L;
+        case COND_GREATER_THAN: return HC_G;
+        case COND_LESS_EQUAL: return HC_LE;
+        default: return HC_E;
+    }
+}
+
+
+class Translator {
+public:
+    Translator(BasicBlock& block, CPUState& state) : block(block), state(state) {
+    }
+
+    bool translate(std::vector<uint8_t>& output);
+
+private:
+    // A faulting access aborts its instruction, the exit undoes what the instruction did before it
+    struct Exit {
+        std::size_t jump;
+        uint32_t dirty;
+        bool set_pc;
+        uint32_t pc;
+        uint32_t count;
+        bool restore_sr = false;  // from SLOT_SR
+        Ea undo;                  // (An)+ or -(An) source of a move, updated before the write
+        int undo_size = 0;
+    };
+
+    BasicBlock& block;
+    CPUState& state;
+    std::vector<Op> ops;
+    Emitter a;
+    std::vector<Exit> exits;  // out of line exits, emitted after the block body
+    int host_of[16];          // CACHE_REGS index of a guest register or -1
+    uint32_t dirty = 0;       // cached guest registers newer than the register file
+
+    uint16_t extensionWord(uint32_t& cursor);
+    bool decodeEa(uint16_t mode, uint16_t reg, int size, bool alterable, uint32_t& cursor, Ea& ea);
+    Op decode(const BlockEntry& entry);
+    void analyze();
+    void allocate();
+
+    Operand guest(int index) const;
+    void modified(int index);
+    void writeBack(uint32_t mask);
+    void reload();
+    void epilogue();
+    void exit(uint32_t dirty_mask, bool set_pc, uint32_t pc, uint32_t count);
+    void exitIf(HostCond cc, bool set_pc, uint32_t pc, uint32_t count);
+    void callHelper(const void* function);
+
+    void address(const Ea& ea, int size, HostReg dst);
+    void updateAddressReg(const Ea& ea, int size);
+    void undoAddressReg(const Ea& ea, int size);
+    void read(const Ea& ea, int size, std::size_t index, bool keep_address);
+    void write(const Ea* ea, int size, HostReg data, std::size_t index);
+    void load(const Ea& ea, int size, HostReg dst, std::size_t index);
+    void flags(const Op& op);
+
+    void emit(std::size_t index);
+    void emitReadModifyWrite(const Op& op, std::size_t index);
+    void emitBranch(const Op& op);
+    void emitFallback(std::size_t index);
+};
+
+
+uint16_t Translator::extensionWord(uint32_t& cursor) {
+    uint16_t word = static_cast<uint16_t>(this->state.memory.get(cursor, SIZE_WORD));
+    cursor += SIZE_WORD;
+    return word;
+}
+
+
+bool Translator::decodeEa(uint16_t mode, uint16_t reg, int size, bool alterable, uint32_t& cursor, Ea& ea) {
+    ea.reg = reg;
+    switch (mode) {
+        case 0: ea.kind = Ea::DREG; return true;
+        case 1: ea.kind = Ea::AREG; ea.reg = reg + 8; return true;
+        case 2: ea.kind = Ea::INDIRECT; ea.reg = reg + 8; return true;
+        case 3:
+        case 4: {
+            // byte access through A7 keeps the stack word aligned, left to the interpreter
+            if (reg == 7 && size == SIZE_BYTE)
+                return false;
+            ea.kind = mode == 3 ? Ea::POSTINC : Ea::PREDEC;
+            ea.reg = reg + 8;
+            return true;
+        }
+        case 5: {
+            ea.kind = Ea::DISP;
+            ea.reg = reg + 8;
+            ea.value = static_cast<uint32_t>(static_cast<int32_t>(static_cast<int16_t>(extensionWord(cursor))));
+            return true;
+        }
+        case 7: {
+            switch (reg) {
+                case 1: {  // abs.l
+                    uint32_t high = extensionWord(cursor);
+                    ea.kind = Ea::ABSOLUTE;
+                    ea.value = (high << 16) | extensionWord(cursor);
+                    return true;
+                }
+                case 2: {  // (d16,PC)
+                    if (alterable)
+                        return false;
+                    uint32_t base = cursor;
+                    ea.kind = Ea::ABSOLUTE;
+                    ea.value = base + static_cast<int16_t>(extensionWord(cursor));
+                    return true;
+                }
+                case 4: {  // #imm
+                    if (alterable)
+                        return false;
+                    ea.kind = Ea::IMMEDIATE;
+                    if (size == SIZE_LONG) {
+                        uint32_t high = extensionWord(cursor);
+                        ea.value = (high << 16) | extensionWord(cursor);
+                    } else {
+                        ea.value = extensionWord(cursor);
+                        if (size == SIZE_BYTE)
+                            ea.value = MASK_8(ea.value);
+                    }
+                    return true;
+                }
+                default: return false;  // abs.w and (d8,PC,Xn)
+            }
+        }
+        default: return false;  // (d8,An,Xn)
+    }
+}
+
+
+Op Translator::decode(const BlockEntry& entry) {
+    Op op;
+    op.pc = entry.pc;
+    Instruction* instruction = entry.instruction;
+    if (!instruction->is_valid)
+        return op;
+
+    uint16_t opcode = static_cast<uint16_t>(this->state.memory.get(entry.pc, SIZE_WORD));
+    uint16_t data_reg = (opcode >> 9) & 0x7;
+    uint16_t ea_mode = (opcode >> 3) & 0x7;
+    uint16_t ea_reg = opcode & 0x7;
+    uint32_t cursor = entry.pc + SIZE_WORD;
+    bool ok = false;
+
+    if (dynamic_cast<Moveq*>(instruction)) {
+        op.kind = Op::MOVEQ;
+        op.dst.kind = Ea::DREG;
+        op.dst.reg = data_reg;
+        op.imm = static_cast<uint32_t>(static_cast<int32_t>(static_cast<int8_t>(opcode & 0xFF)));
+        op.defs = CCR_NZVC;
+        ok = true;
+    } else if (dynamic_cast<Move*>(instruction)) {
+        uint16_t size_part = (opcode >> 12) & 0x3;
+        op.size = size_part == 1 ? SIZE_BYTE : (size_part == 3 ? SIZE_WORD : SIZE_LONG);
+        ok = decodeEa(ea_mode, ea_reg, op.size, false, cursor, op.src) &&
+             decodeEa((opcode >> 6) & 0x7, data_reg, op.size, true, cursor, op.dst);
+        if (op.dst.kind == Ea::AREG) {
+            op.kind = Op::MOVEA;
+            ok = ok && op.size != SIZE_BYTE;
+        } else {
+            op.kind = Op::MOVE;
+            op.defs = CCR_NZVC;
+        }
+    } else if (dynamic_cast<Add*>(instruction) || dynamic_cast<Sub*>(instruction) ||
+               dynamic_cast<And*>(instruction) || dynamic_cast<Or*>(instruction)) {
+        bool arithmetic = dynamic_cast<Add*>(instruction) || dynamic_cast<Sub*>(instruction);
+        op.kind = Op::ALU;
+        op.alu = dynamic_cast<Add*>(instruction) ? ALU_ADD
+               : dynamic_cast<Sub*>(instruction) ? ALU_SUB
+               : dynamic_cast<And*>(instruction) ? ALU_AND : ALU_OR;
+        op.size = standardSize(opcode >> 6);
+        op.defs = arithmetic ? CCR_ALL : CCR_NZVC;
+        if (opcode & 0x0100) {
+            // Dn,<ea>, register forms of this encoding are ADDX, SUBX, ABCD, SBCD and EXG
+            op.src.kind = Ea::DREG;
+            op.src.reg = data_reg;
+            ok = ea_mode >= 2 && decodeEa(ea_mode, ea_reg, op.size, true, cursor, op.dst);
+        } else {
+            op.dst.kind = Ea::DREG;
+            op.dst.reg = data_reg;
+            ok = decodeEa(ea_mode, ea_reg, op.size, false, cursor, op.src);
+        }
+    } else if (dynamic_cast<Eor*>(instruction)) {
+        op.kind = Op::ALU;
+        op.alu = ALU_XOR;
+        op.size = standardSize(opcode >> 6);
+        op.defs = CCR_NZVC;
+        op.src.kind = Ea::DREG;
+        op.src.reg = data_reg;
+        ok = ea_mode != 1 && decodeEa(ea_mode, ea_reg, op.size, true, cursor, op.dst);
+    } else if (dynamic_cast<Cmp*>(instruction)) {
+        op.kind = Op::ALU;
+        op.alu = ALU_CMP;
+        op.size = standardSize(opcode >> 6);
+        op.defs = CCR_NZVC;
+        op.dst.kind = Ea::DREG;
+        op.dst.reg = data_reg;
+        ok = decodeEa(ea_mode, ea_reg, op.size, false, cursor, op.src);
+    } else if (dynamic_cast<Adda*>(instruction) || dynamic_cast<Suba*>(instruction) ||
+               dynamic_cast<Cmpa*>(instruction)) {
+        // word forms are left to the interpreter
+        op.kind = Op::ALU_ADDR;
+        op.alu = dynamic_cast<Adda*>(instruction) ? ALU_ADD : dynamic_cast<Suba*>(instruction) ? ALU_SUB : ALU_CMP;
+        op.size = SIZE_LONG;
+        op.defs = op.alu == ALU_CMP ? CCR_NZVC : 0;
+        op.dst.kind = Ea::AREG;
+        op.dst.reg = data_reg + 8;
+        ok = (opcode & 0x0100) && decodeEa(ea_mode, ea_reg, op.size, false, cursor, op.src);
+    } else if (dynamic_cast<Addq*>(instruction) || dynamic_cast<Subq*>(instruction)) {
+        op.kind = Op::QUICK;
+        op.alu = dynamic_cast<Addq*>(instruction) ? ALU_ADD : ALU_SUB;
+        op.size = standardSize(opcode >> 6);
+        op.imm = data_reg ? data_reg : 8;
+        op.src.kind = Ea::IMMEDIATE;
+        op.src.value = op.imm;
+        ok = decodeEa(ea_mode, ea_reg, op.size, true, cursor, op.dst);
+        if (op.dst.kind == Ea::AREG) {
+            ok = ok && op.size == SIZE_LONG;
+        } else {
+            op.defs = CCR_ALL;
+        }
+    } else if (dynamic_cast<Tst*>(instruction)) {
+        op.kind = Op::TST;
+        op.size = standardSize(opcode >> 6);
+        op.defs = CCR_NZVC;
+        ok = decodeEa(ea_mode, ea_reg, op.size, false, cursor, op.src);
+    } else if (dynamic_cast<Clr*>(instruction)) {
+        op.kind = Op::CLR;
+        op.size = standardSize(opcode >> 6);
+        op.defs = CCR_NZVC;
+        ok = ea_mode != 1 && decodeEa(ea_mode, ea_reg, op.size, true, cursor, op.dst);
+    } else if (dynamic_cast<Lea*>(instruction)) {
+        op.kind = Op::LEA;
+        op.dst.kind = Ea::AREG;
+        op.dst.reg = data_reg + 8;
+        ok = decodeEa(ea_mode, ea_reg, SIZE_LONG, false, cursor, op.src) &&
+             (op.src.kind == Ea::INDIRECT || op.src.kind == Ea::DISP || op.src.kind == Ea::ABSOLUTE);
+    } else if (dynamic_cast<Bcc*>(instruction)) {
+        // BSR and 32 bit displacements are left to the interpreter
+        op.kind = Op::BRANCH;
+        op.condition = static_cast<Condition>((opcode >> 8) & 0xF);
+        uint16_t displacement = opcode & 0xFF;
+        int32_t offset = static_cast<int8_t>(displacement);
+        if (displacement == 0x00)
+            offset = static_cast<int16_t>(extensionWord(cursor));
+        op.target = entry.pc + SIZE_WORD + static_cast<uint32_t>(offset);
+        op.next_pc = cursor;
+        op.uses = CCR_ALL;
+        ok = op.condition != COND_FALSE && displacement != 0xFF;
+#if M68K_ACCURATE_CYCLES
+        // block cycles count a branch as taken, the interpreter corrects the ones that are not
+        ok = ok && op.condition == COND_TRUE;
+#endif
+    }
+
+    if (!ok || op.size == 0) {
+        Op fallback;
+        fallback.pc = entry.pc;
+        fallback.uses = CCR_ALL;
+        return fallback;
+    }
+    if (op.kind != Op::BRANCH) {
+        // the decoding has to agree with the recorded length
+        if (cursor != entry.pc + entry.length) {
+            Op fallback;
+            fallback.pc = entry.pc;
+            fallback.uses = CCR_ALL;
+            return fallback;
+        }
+        op.next_pc = cursor;
+    }
+    // a memory fault exposes SR, so it has to be up to date before any access
+    if (op.src.isMemory() || op.dst.isMemory())
+        op.uses = CCR_ALL;
+    return op;
+}
+
+
+// Backward liveness of the CCR bits, everything is live at the block exit.
+void Translator::analyze() {
+    uint8_t live = CCR_ALL;
+    for (std::size_t i = this->ops.size(); i-- > 0;) {
+        Op& op = this->ops[i];
+        op.live = op.defs & live;
+        live = static_cast<uint8_t>((live & ~op.defs) | op.uses);
+    }
+
+    std::size_t n = this->ops.size();
+    if (n >= 2) {
+        Op& setter = this->ops[n - 2];
+        Op& branch = this->ops[n - 1];
+        if (branch.kind == Op::BRANCH && branch.condition != COND_TRUE && setter.kind != Op::FALLBACK &&
+            (setter.defs & CCR_NZVC) == CCR_NZVC) {
+            setter.feeds_branch = true;
+            branch.condition_saved = true;
+        }
+    }
+}
+
+
+// The most used guest registers are kept in callee saved host registers.
+void Translator::allocate() {
+    int uses[16] = {};
+    for (const Op& op : this->ops) {
+        if (op.kind == Op::FALLBACK)
+            continue;
+        if (op.src.usesRegister())
+            uses[op.src.reg]++;
+        if (op.dst.usesRegister())
+            uses[op.dst.reg]++;
+    }
+
+    int order[16];
+    for (int i = 0; i < 16; i++) {
+        order[i] = i;
+        this->host_of[i] = -1;
+    }
+    std::stable_sort(order, order + 16, [&uses](int l, int r) { return uses[l] > uses[r]; });
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        if (uses[order[i]] < 2)
+            break;
+        this->host_of[order[i]] = i;
+    }
+}
+
+
+Operand Translator::guest(int index) const {
+    int host = this->host_of[index];
+    return host >= 0 ? reg(CACHE_REGS[host]) : mem(R15, index * 4);
+}
+
+void Translator::modified(int index) {
+    if (this->host_of[index] >= 0)
+        this->dirty |= 1u << index;
+}
+
+void Translator::writeBack(uint32_t mask) {
+    for (int i = 0; i < 16; i++) {
+        if (mask & (1u << i))
+            a.mov(SIZE_LONG, mem(R15, i * 4), CACHE_REGS[this->host_of[i]]);
+    }
+}
+
+void Translator::reload() {
+    for (int i = 0; i < 16; i++) {
+        if (this->host_of[i] >= 0)
+            a.movLoad(SIZE_LONG, CACHE_REGS[this->host_of[i]], mem(R15, i * 4));
+    }
+}
+
+void Translator::epilogue() {
+    a.aluImm64(ALU_ADD, RSP, FRAME_SIZE);
+    for (std::size_t i = sizeof(SAVED_REGS) / sizeof(SAVED_REGS[0]); i-- > 0;)
+        a.pop(SAVED_REGS[i]);
+    a.ret();
+}
+
+void Translator::exit(uint32_t dirty_mask, bool set_pc, uint32_t pc, uint32_t count) {
+    writeBack(dirty_mask);
+    if (set_pc)
+        a.movImm(SIZE_LONG, mem(R15, OFFSET_PC), pc);
+    a.movImm32(RAX, count);
+    epilogue();
+}
+
+void Translator::exitIf(HostCond cc, bool set_pc, uint32_t pc, uint32_t count) {
+    Exit e = {a.jcc(cc), this->dirty, set_pc, pc, count};
+    this->exits.push_back(e);
+}
+
+void Translator::callHelper(const void* function) {
+    a.movImm64(RAX, reinterpret_cast<uintptr_t>(function));
+    a.call(RAX);
+}
+
+
+void Translator::address(const Ea& ea, int size, HostReg dst) {
+    switch (ea.kind) {
+        case Ea::INDIRECT:
+        case Ea::POSTINC: {
+            a.movLoad(SIZE_LONG, dst, guest(ea.reg));
+            break;
+        }
+        case Ea::PREDEC: {
+            a.movLoad(SIZE_LONG, dst, guest(ea.reg));
+            a.aluImm(ALU_SUB, SIZE_LONG, reg(dst), static_cast<uint32_t>(size));
+            break;
+        }
+        case Ea::DISP: {
+            a.movLoad(SIZE_LONG, dst, guest(ea.reg));
+            if (ea.value)
+                a.aluImm(ALU_ADD, SIZE_LONG, reg(dst), ea.value);
+            break;
+        }
+        case Ea::ABSOLUTE: {
+            a.movImm32(dst, ea.value);
+            break;
+        }
+        default: break;
+    }
+}
+
+void Translator::updateAddressReg(const Ea& ea, int size) {
+    if (ea.kind != Ea::POSTINC && ea.kind != Ea::PREDEC)
+        return;
+    a.aluImm(ea.kind == Ea::POSTINC ? ALU_ADD : ALU_SUB, SIZE_LONG, guest(ea.reg), static_cast<uint32_t>(size));
+    modified(ea.reg);
+}
+
+void Translator::undoAddressReg(const Ea& ea, int size) {
+    if (ea.kind != Ea::POSTINC && ea.kind != Ea::PREDEC)
+        return;
+    a.aluImm(ea.kind == Ea::POSTINC ? ALU_SUB : ALU_ADD, SIZE_LONG, guest(ea.reg), static_cast<uint32_t>(size));
+}
+
+// memory to eax, the address register update is left to the caller
+void Translator::read(const Ea& ea, int size, std::size_t index, bool keep_address) {
+    address(ea, size, ARG1);
+    if (keep_address)
+        a.mov(SIZE_LONG, mem(RSP, SLOT_ADDRESS), ARG1);
+    a.movImm32(ARG2, static_cast<uint32_t>(size));
+    a.load64(ARG0, mem(RSP, SLOT_CONTEXT));
+    callHelper(reinterpret_cast<const void*>(&jitRead));
+    a.store64(reg(RDX), RAX);
+    a.shr64Imm(RDX, 32);
+    exitIf(HC_NE, true, this->ops[index].pc, static_cast<uint32_t>(index));
+}
+
+// data to memory, the address comes from SLOT_ADDRESS when ea is null
+void Translator::write(const Ea* ea, int size, HostReg data, std::size_t index) {
+    if (data != ARG3)
+        a.mov(SIZE_LONG, reg(ARG3), data);
+    if (ea)
+        address(*ea, size, ARG1);
+    else
+        a.movLoad(SIZE_LONG, ARG1, mem(RSP, SLOT_ADDRESS));
+    a.movImm32(ARG2, static_cast<uint32_t>(size));
+    a.load64(ARG0, mem(RSP, SLOT_CONTEXT));
+    callHelper(reinterpret_cast<const void*>(&jitWrite));
+    a.test(SIZE_LONG, reg(RAX), RAX);
+    const Op& op = this->ops[index];
+    exitIf(HC_NE, true, op.pc, static_cast<uint32_t>(index));
+    Exit& fault = this->exits.back();
+    fault.restore_sr = op.live != 0;
+    fault.undo = op.src;
+    fault.undo_size = op.size;
+}
+
+void Translator::load(const Ea& ea, int size, HostReg dst, std::size_t index) {
+    if (ea.isRegister()) {
+        a.movLoad(SIZE_LONG, dst, guest(ea.reg));
+    } else if (ea.kind == Ea::IMMEDIATE) {
+        a.movImm32(dst, ea.value);
+    } else {
+        read(ea, size, index, false);
+        a.mov(SIZE_LONG, reg(dst), RAX);
+        updateAddressReg(ea, size);
+    }
+}
+
+// x86 flags of the op to SR, only the live bits
+void Translator::flags(const Op& op) {
+    if (op.feeds_branch)
+        a.setcc(hostCondition(this->ops.back().condition), mem(RSP, SLOT_CONDITION));
+
+    uint8_t need = op.live;
+    if (!need)
+        return;
+    if (need & (SR_FLAG_CARRY | SR_FLAG_EXTEND))
+        a.setcc(HC_B, reg(RDX));
+    if (need & SR_FLAG_OVERFLOW)
+        a.setcc(HC_O, reg(R8));
+    if (need & SR_FLAG_ZERO)
+        a.setcc(HC_E, reg(R9));
+    if (need & SR_FLAG_NEGATIVE)
+        a.setcc(HC_S, reg(R10));
+
+    a.movLoad(SIZE_LONG, R11, mem(R15, OFFSET_SR));
+    if (op.dst.isMemory())
+        a.mov(SIZE_LONG, mem(RSP, SLOT_SR), R11);
+    a.aluImm(ALU_AND, SIZE_LONG, reg(R11), ~static_cast<uint32_t>(need));
+    if (need & (SR_FLAG_CARRY | SR_FLAG_EXTEND)) {
+        a.movzx8(RDX, RDX);
+        if (need & SR_FLAG_CARRY)
+            a.alu(ALU_OR, SIZE_LONG, reg(R11), RDX);
+        if (need & SR_FLAG_EXTEND) {
+            a.shlImm(RDX, 4);
+            a.alu(ALU_OR, SIZE_LONG, reg(R11), RDX);
+        }
+    }
+    if (need & SR_FLAG_OVERFLOW) {
+        a.movzx8(R8, R8);
+        a.shlImm(R8, 1);
+        a.alu(ALU_OR, SIZE_LONG, reg(R11), R8);
+    }
+    if (need & SR_FLAG_ZERO) {
+        a.movzx8(R9, R9);
+        a.shlImm(R9, 2);
+        a.alu(ALU_OR, SIZE_LONG, reg(R11), R9);
+    }
+    if (need & SR_FLAG_NEGATIVE) {
+        a.movzx8(R10, R10);
+        a.shlImm(R10, 3);
+        a.alu(ALU_OR, SIZE_LONG, reg(R11), R10);
+    }
+    a.mov(SIZE_LONG, mem(R15, OFFSET_SR), R11);
+}
+
+
+void Translator::emitReadModifyWrite(const Op& op, std::size_t index) {
+    read(op.dst, op.size, index, true);
+    if (op.src.kind == Ea::IMMEDIATE)
+        a.movImm32(RCX, op.src.value);
+    else
+        a.movLoad(SIZE_LONG, RCX, guest(op.src.reg));
+    a.alu(op.alu, op.size, reg(RAX), RCX);
+    flags(op);
+    write(nullptr, op.size, RAX, index);
+    updateAddressReg(op.dst, op.size);
+}
+
+
+void Translator::emitBranch(const Op& op) {
+    uint32_t count = static_cast<uint32_t>(this->ops.size());
+    if (op.condition == COND_TRUE) {
+        exit(this->dirty, true, op.target, count);
+        return;
+    }
+
+    if (op.condition_saved) {
+        a.aluImm(ALU_CMP, SIZE_BYTE, mem(RSP, SLOT_CONDITION), 0);
+    } else {
+        a.movImm32(ARG1, op.condition);
+        a.load64(ARG0, mem(RSP, SLOT_CONTEXT));
+        callHelper(reinterpret_cast<const void*>(&jitCondition));
+        a.test(SIZE_LONG, reg(RAX), RAX);
+    }
+    std::size_t taken = a.jcc(HC_NE);
+    exit(this->dirty, true, op.next_pc, count);
+    a.bind(taken, a.position());
+    exit(this->dirty, true, op.target, count);
+}
+
+
+void Translator::emitFallback(std::size_t index) {
+    const BlockEntry& entry = this->block.entries[index];
+    writeBack(this->dirty);
+    this->dirty = 0;
+
+    a.movImm(SIZE_LONG, mem(R15, OFFSET_PC), entry.pc);
+    a.movImm64(ARG1, reinterpret_cast<uintptr_t>(entry.instruction));
+    a.load64(ARG0, mem(RSP, SLOT_CONTEXT));
+    callHelper(reinterpret_cast<const void*>(&jitExecute));
+    a.test(SIZE_LONG, reg(RAX), RAX);
+    exitIf(HC_NE, false, 0, static_cast<uint32_t>(index));
+    reload();
+
+    uint32_t count = static_cast<uint32_t>(index + 1);
+    if (index + 1 == this->ops.size()) {
+        exit(0, false, 0, count);
+        return;
+    }
+    // the instruction may have entered supervisor mode or jumped
+    a.testImm(mem(R15, OFFSET_SR), SR_FLAG_SUPERVISOR);
+    exitIf(HC_NE, false, 0, count);
+    a.aluImm(ALU_CMP, SIZE_LONG, mem(R15, OFFSET_PC), entry.pc + entry.length);
+    exitIf(HC_NE, false, 0, count);
+}
+
+
+void Translator::emit(std::size_t index) {
+    const Op& op = this->ops[index];
+    bool flags_needed = op.live || op.feeds_branch;
+
+    switch (op.kind) {
+        case Op::MOVEQ: {
+            a.movImm32(RCX, op.imm);
+            a.mov(SIZE_LONG, guest(op.dst.reg), RCX);
+            modified(op.dst.reg);
+            if (flags_needed)
+                a.test(SIZE_LONG, reg(RCX), RCX);
+            flags(op);
+            break;
+        }
+        case Op::MOVE: {
+            load(op.src, op.size, RCX, index);
+            if (flags_needed)
+                a.test(op.size, reg(RCX), RCX);
+            flags(op);
+            if (op.dst.isRegister()) {
+                a.mov(op.size, guest(op.dst.reg), RCX);
+                modified(op.dst.reg);
+            } else {
+                write(&op.dst, op.size, RCX, index);
+                updateAddressReg(op.dst, op.size);
+            }
+            break;
+        }
+        case Op::MOVEA: {
+            load(op.src, op.size, RCX, index);
+            if (op.size == SIZE_WORD)
+                a.movsx16(RCX, RCX);
+            a.mov(SIZE_LONG, guest(op.dst.reg), RCX);
+            modified(op.dst.reg);
+            break;
+        }
+        case Op::ALU:
+        case Op::ALU_ADDR: {
+            if (op.dst.isMemory()) {
+                emitReadModifyWrite(op, index);
+                break;
+            }
+            load(op.src, op.size, RCX, index);
+            a.alu(op.alu, op.size, guest(op.dst.reg), RCX);
+            if (op.alu != ALU_CMP)
+                modified(op.dst.reg);
+            flags(op);
+            break;
+        }
+        case Op::QUICK: {
+            if (op.dst.isMemory()) {
+                emitReadModifyWrite(op, index);
+                break;
+            }
+            a.aluImm(op.alu, op.size, guest(op.dst.reg), op.imm);
+            modified(op.dst.reg);
+            flags(op);
+            break;
+        }
+        case Op::TST: {
+            load(op.src, op.size, RCX, index);
+            a.test(op.size, reg(RCX), RCX);
+            flags(op);
+            break;
+        }
+        case Op::CLR: {
+            a.alu(ALU_XOR, SIZE_LONG, reg(RCX), RCX);
+            flags(op);
+            if (op.dst.isRegister()) {
+                a.mov(op.size, guest(op.dst.reg), RCX);
+                modified(op.dst.reg);
+            } else {
+                write(&op.dst, op.size, RCX, index);
+                updateAddressReg(op.dst, op.size);
+            }
+            break;
+        }
+        case Op::LEA: {
+            address(op.src, SIZE_LONG, RCX);
+            a.mov(SIZE_LONG, guest(op.dst.reg), RCX);
+            modified(op.dst.reg);
+            break;
+        }
+        case Op::BRANCH: {
+            emitBranch(op);
+            break;
+        }
+        case Op::FALLBACK: {
+            emitFallback(index);
+            break;
+        }
+    }
+}
+
+
+bool Translator::translate(std::vector<uint8_t>& output) {
+    bool any_native = false;
+    for (const BlockEntry& entry : this->block.entries) {
+        this->ops.push_back(decode(entry));
+        any_native = any_native || this->ops.back().kind != Op::FALLBACK;
+    }
+    if (!any_native)
+        return false;
+    analyze();
+    allocate();
+
+    for (HostReg r : SAVED_REGS)
+        a.push(r);
+    a.aluImm64(ALU_SUB, RSP, FRAME_SIZE);
+    a.store64(mem(RSP, SLOT_CONTEXT), ARG0);
+    a.store64(reg(R15), ARG1);
+    reload();
+
+    for (std::size_t i = 0; i < this->ops.size(); i++)
+        emit(i);
+
+    const Op& last = this->ops.back();
+    if (last.kind != Op::BRANCH && last.kind != Op::FALLBACK)
+        exit(this->dirty, true, last.next_pc, static_cast<uint32_t>(this->ops.size()));
+
+    for (const Exit& e : this->exits) {
+        a.bind(e.jump, a.position());
+        if (e.undo_size)
+            undoAddressReg(e.undo, e.undo_size);
+        if (e.restore_sr) {
+            a.movLoad(SIZE_LONG, R11, mem(RSP, SLOT_SR));
+            a.mov(SIZE_LONG, mem(R15, OFFSET_SR), R11);
+        }
+        exit(e.dirty, e.set_pc, e.pc, e.count);
+    }
+
+    output.swap(a.bytes);
+    return true;
+}
+
+}  // namespace
+
+
+namespace M68K {
+
+struct JitCompiler::CodeBuffer {
+    static const std::size_t PAGE_SIZE = 4096;
+
+    uint8_t* code = nullptr;  // mapped on the first write
+    bool map_failed = false;
+    std::size_t used = 0;
+    bool full = false;
+    uint64_t generation = 0;  // counts the resets, the code of older generations is gone
+
+    CodeBuffer() = default;
+    CodeBuffer(const CodeBuffer&) = delete;
+    CodeBuffer& operator=(const CodeBuffer&) = delete;
+
+    ~CodeBuffer() {
+        if (!this->code)
+            return;
+#if defined(_WIN32)
+        VirtualFree(this->code, 0, MEM_RELEASE);
+#else
+        munmap(this->code, CODE_SIZE);
+#endif
+    }
+
+    static const std::shared_ptr<CodeBuffer>& local() {
+        static thread_local std::shared_ptr<CodeBuffer> buffer = std::make_shared<CodeBuffer>();
+        return buffer;
+    }
+
+    // without executable memory the interpreter keeps running everything
+    bool map() {
+        if (this->code || this->map_failed)
+            return this->code != nullptr;
+#if defined(_WIN32)
+        this->code = static_cast<uint8_t*>(VirtualAlloc(nullptr, CODE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READ));
+#else
+        void* memory = mmap(nullptr, CODE_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        this->code = memory == MAP_FAILED ? nullptr : static_cast<uint8_t*>(memory);
+#endif
+        this->map_failed = !this->code;
+        return this->code != nullptr;
+    }
+
+    // Copies code to at with the pages it covers writable, then makes them executable again.
+    // Only the thread of the buffer runs its code, nothing executes here meanwhile.
+    bool write(uint8_t* at, const std::vector<uint8_t>& bytes) {
+        uint8_t* begin = this->code + (static_cast<std::size_t>(at - this->code) & ~(PAGE_SIZE - 1));
+        std::size_t size = (static_cast<std::size_t>(at - begin) + bytes.size() + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1);
+#if defined(_WIN32)
+        DWORD old_protection;
+        if (!VirtualProtect(begin, size, PAGE_READWRITE, &old_protection))
+            return false;
+        std::memcpy(at, bytes.data(), bytes.size());
+        bool executable = VirtualProtect(begin, size, PAGE_EXECUTE_READ, &old_protection) != 0;
+        FlushInstructionCache(GetCurrentProcess(), at, bytes.size());
+        return executable;
+#else
+        if (mprotect(begin, size, PROT_READ | PROT_WRITE) != 0)
+            return false;
+        std::memcpy(at, bytes.data(), bytes.size());
+        return mprotect(begin, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+    }
+
+    void reset() {
+        this->used = 0;
+        this->full = false;
+        this->generation++;
+    }
+};
+
+
+bool JitCompiler::attach() {
+    const std::shared_ptr<CodeBuffer>& local = CodeBuffer::local();
+    if (this->buffer == local)
+        return false;
+    bool compiled = this->buffer != nullptr;
+    this->buffer = local;
+    this->generation = local->generation;
+    return compiled;
+}
+
+
+bool JitCompiler::compile(BasicBlock& block, CPUState& state) {
+    if (!this->buffer)
+        this->attach();
+    CodeBuffer& code = *this->buffer;
+    if (code.full || this->generation != code.generation || !code.map())
+        return false;
+
+    std::vector<uint8_t> buffer;
+    if (!Translator(block, state).translate(buffer))
+        return false;
+
+    if (code.used + buffer.size() > CODE_SIZE) {
+        code.full = true;
+        return false;
+    }
+    uint8_t* entry = code.code + code.used;
+    if (!code.write(entry, buffer))
+        return false;
+    code.used += (buffer.size() + 15) & ~static_cast<std::size_t>(15);
+    block.native = reinterpret_cast<JitFunction>(entry);
+    return true;
+}
+
+
+bool JitCompiler::exhausted() const {
+    return this->buffer && (this->buffer->full || this->generation != this->buffer->generation);
+}
+
+
+void JitCompiler::clear() {
+    if (!this->buffer)
+        return;
+    if (this->buffer != CodeBuffer::local()) {
+        // the buffer of another thread is left to it, attach() takes the one of this thread
+        this->buffer = nullptr;
+        return;
+    }
+    if (this->buffer->full)
+        this->buffer->reset();
+    this->generation = this->buffer->generation;
+}
+
+}  // namespace M68K
+
+#endif  // M68K_JIT
@@ -0,0 +1,413 @@
+#include "lockstep.hpp"
+#include "instructions/add.hpp"
+#include "instructions/addq.hpp"
+#include "instructions/and.hpp"
+#include "instructions/bcc.hpp"
+#include "instructions/clr.hpp"
+#include "instructions/cmp.hpp"
+#include "instructions/eor.hpp"
+#include "instructions/move.hpp"
+#include "instructions/moveq.hpp"
+#include "instructions/or.hpp"
+#include "instructions/sub.hpp"
+#include "instructions/subq.hpp"
+#include "instructions/tst.hpp"
+
+#include <algorithm>
+
+
+namespace M68K {
+
+using namespace INSTRUCTION;
+
+namespace {
+
+// M68K_LOCKSTEP_AVX2 builds only the loops of the kernels for AVX2, the rest of the engine runs
+// on any x86-64. MSVC has no such attribute and builds them for its default architecture.
+#if M68K_LOCKSTEP_AVX2 && defined(__GNUC__)
+#define LOCKSTEP_KERNEL __attribute__((target("avx2")))
+#else
+#define LOCKSTEP_KERNEL
+#endif
+
+enum Alu { ALU_MOVE, ALU_ADD, ALU_SUB, ALU_CMP, ALU_AND, ALU_OR, ALU_XOR };
+
+// The kernels below run over all lanes and keep the old values where mask is 0. They are
+// branch-free per lane so that the loops vectorize, see Registers::computeFlags() for the flags.
+template <DataSize Size>
+struct SizeBits {
+    static const uint32_t SHIFT = Size * 8 - 1;
+    static const uint32_t MASK = Size == SIZE_LONG ? 0xFFFFFFFFu : (1u << (Size * 8)) - 1;
+};
+
+template <Alu Op, DataSize Size>
+LOCKSTEP_KERNEL void aluKernel(std::size_t count, const uint32_t* mask, const uint32_t* src, uint32_t* dest, uint32_t* sr) {
+    typedef SizeBits<Size> Bits;
+    const uint32_t written = (Op == ALU_CMP) ? 0 : Bits::MASK;
+    const uint32_t defined = (Op == ALU_ADD || Op == ALU_SUB)
+        ? (SR_FLAG_EXTEND | SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY)
+        : (SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY);
+
+    for (std::size_t i = 0; i < count; i++) {
+        uint32_t s = src[i] & Bits::MASK;
+        uint32_t d = dest[i] & Bits::MASK;
+        uint32_t r = 0;
+        uint32_t carry = 0;
+        uint32_t overflow = 0;
+        switch (Op) {
+            case ALU_MOVE: r = s; break;
+            case ALU_ADD:
+                r = d + s;
+                carry = (s & d) | ((s | d) & ~r);
+                overflow = ~(s ^ d) & (s ^ r);
+                break;
+            case ALU_SUB:
+            case ALU_CMP:
+                r = d - s;
+                carry = (s & ~d) | (r & ~d) | (s & r);
+                overflow = (s ^ d) & (d ^ r);
+                break;
+            case ALU_AND: r = d & s; break;
+            case ALU_OR: r = d | s; break;
+            case ALU_XOR: r = d ^ s; break;
+        }
+        r &= Bits::MASK;
+        uint32_t c = (carry >> Bits::SHIFT) & 1;
+        uint32_t flags = c | (((overflow >> Bits::SHIFT) & 1) << 1) | ((r == 0) ? (uint32_t)SR_FLAG_ZERO : 0u) |
+                         ((r >> Bits::SHIFT) << 3);
+        if (Op == ALU_ADD || Op == ALU_SUB) {
+            flags |= c << 4;
+        }
+
+        uint32_t m = mask[i];
+        dest[i] = (dest[i] & ~(m & written)) | (r & m & written);
+        sr[i] = (sr[i] & ~(m & defined)) | (flags & m);
+    }
+}
+
+template <Alu Op>
+void aluKernel(DataSize size, std::size_t count, const uint32_t* mask, const uint32_t* src, uint32_t* dest, uint32_t* sr) {
+    switch (size) {
+        case SIZE_BYTE: aluKernel<Op, SIZE_BYTE>(count, mask, src, dest, sr); break;
+        case SIZE_WORD: aluKernel<Op, SIZE_WORD>(count, mask, src, dest, sr); break;
+        case SIZE_LONG: aluKernel<Op, SIZE_LONG>(count, mask, src, dest, sr); break;
+    }
+}
+
+void aluKernel(Alu op, DataSize size, std::size_t count, const uint32_t* mask, const uint32_t* src, uint32_t* dest, uint32_t* sr) {
+    switch (op) {
+        case ALU_MOVE: aluKernel<ALU_MOVE>(size, count, mask, src, dest, sr); break;
+        case ALU_ADD: aluKernel<ALU_ADD>(size, count, mask, src, dest, sr); break;
+        case ALU_SUB: aluKernel<ALU_SUB>(size, count, mask, src, dest, sr); break;
+        case ALU_CMP: aluKernel<ALU_CMP>(size, count, mask, src, dest, sr); break;
+        case ALU_AND: aluKernel<ALU_AND>(size, count, mask, src, dest, sr); break;
+        case ALU_OR: aluKernel<ALU_OR>(size, count, mask, src, dest, sr); break;
+        case ALU_XOR: aluKernel<ALU_XOR>(size, count, mask, src, dest, sr); break;
+    }
+}
+
+
+// ~0 if the condition holds for the flags in sr, see CPUState::checkCondition()
+template <Condition Cond>
+uint32_t conditionMask(uint32_t sr) {
+    uint32_t c = sr & 1, v = (sr >> 1) & 1, z = (sr >> 2) & 1, n = (sr >> 3) & 1;
+    uint32_t holds = 0;
+    switch (Cond) {
+        case COND_TRUE: holds = 1; break;
+        case COND_FALSE: holds = 0; break;
+        case COND_HIGHER: holds = (c | z) ^ 1; break;
+        case COND_LOWER_SAME: holds = c | z; break;
+        case COND_CARRY_CLEAR: holds = c ^ 1; break;
+        case COND_CARRY_SET: holds = c; break;
+        case COND_NOT_EQUAL: holds = z ^ 1; break;
+        case COND_EQUAL: holds = z; break;
+        case COND_OVERFLOW_CLEAR: holds = v ^ 1; break;
+        case COND_OVERFLOW_SET: holds = v; break;
+        case COND_PLUS: holds = n ^ 1; break;
+        case COND_MINUS: holds = n; break;
+        case COND_GREATER_EQUAL: holds = (n ^ v) ^ 1; break;
+        case COND_LESS_THAN: holds = n ^ v; break;
+        case COND_GREATER_THAN: holds = ((n ^ v) | z) ^ 1; break;
+        case COND_LESS_EQUAL: holds = (n ^ v) | z; break;
+    }
+    return 0u - holds;
+}
+
+template <Condition Cond>
+LOCKSTEP_KERNEL void branchKernel(std::size_t count, const uint32_t* mask, const uint32_t* sr, uint32_t* pc, uint32_t taken, uint32_t next) {
+    for (std::size_t i = 0; i < count; i++) {
+        uint32_t target = (taken & conditionMask<Cond>(sr[i])) | (next & ~conditionMask<Cond>(sr[i]));
+        pc[i] = (pc[i] & ~mask[i]) | (target & mask[i]);
+    }
+}
+
+void branchKernel(Condition cond, std::size_t count, const uint32_t* mask, const uint32_t* sr, uint32_t* pc, uint32_t taken, uint32_t next) {
+    switch (cond) {
+        case COND_TRUE: branchKernel<COND_TRUE>(count, mask, sr, pc, taken, next); break;
+        case COND_FALSE: branchKernel<COND_FALSE>(count, mask, sr, pc, taken, next); break;
+        case COND_HIGHER: branchKernel<COND_HIGHER>(count, mask, sr, pc, taken, next); break;
+        case COND_LOWER_SAME: branchKernel<COND_LOWER_SAME>(count, mask, sr, pc, taken, next); break;
+        case COND_CARRY_CLEAR: branchKernel<COND_CARRY_CLEAR>(count, mask, sr, pc, taken, next); break;
+        case COND_CARRY_SET: branchKernel<COND_CARRY_SET>(count, mask, sr, pc, taken, next); break;
+        case COND_NOT_EQUAL: branchKernel<COND_NOT_EQUAL>(count, mask, sr, pc, taken, next); break;
+        case COND_EQUAL: branchKernel<COND_EQUAL>(count, mask, sr, pc, taken, next); break;
+        case COND_OVERFLOW_CLEAR: branchKernel<COND_OVERFLOW_CLEAR>(count, mask, sr, pc, taken, next); break;
+        case COND_OVERFLOW_SET: branchKernel<COND_OVERFLOW_SET>(count, mask, sr, pc, taken, next); break;
+        case COND_PLUS: branchKernel<COND_PLUS>(count, mask, sr, pc, taken, next); break;
+        case COND_MINUS: branchKernel<COND_MINUS>(count, mask, sr, pc, taken, next); break;
+        case COND_GREATER_EQUAL: branchKernel<COND_GREATER_EQUAL>(count, mask, sr, pc, taken, next); break;
+        case COND_LESS_THAN: branchKernel<COND_LESS_THAN>(count, mask, sr, pc, taken, next); break;
+        case COND_GREATER_THAN: branchKernel<COND_GREATER_THAN>(count, mask, sr, pc, taken, next); break;
+        case COND_LESS_EQUAL: branchKernel<COND_LESS_EQUAL>(count, mask, sr, pc, taken, next); break;
+    }
+}
+
+
+DataSize standardSize(uint16_t part) {
+    switch (part & 0x3) {
+        case 0x0: return SIZE_BYTE;
+        case 0x1: return SIZE_WORD;
+        case 0x2: return SIZE_LONG;
+    }
+    return (DataSize)0;
+}
+
+}  // namespace
+
+
+// Instruction at a PC, decoded for the kernels
+struct LockstepEngine::Op {
+    enum Kind { SCALAR, ALU, BRANCH };
+
+    Kind kind = SCALAR;
+    Instruction* instruction = nullptr;
+    Alu alu = ALU_MOVE;
+    DataSize size = SIZE_LONG;
+    RegisterType src = REG_D0;
+    bool immediate = false;  // imm instead of src
+    RegisterType dest = REG_D0;
+    uint32_t imm = 0;
+    Condition condition = COND_TRUE;
+    uint32_t next_pc = 0;
+    uint32_t target = 0;
+};
+
+
+LockstepEngine::LockstepEngine(BasicCPU<MemoryBus>& prototype, std::size_t count)
+    : lane_count(count), bank(REGS_COUNT * count), mask(count), operand(count), waiting(count) {
+    prototype.state.registers.materializeFlags();
+    for (std::size_t lane = 0; lane < count; lane++) {
+        this->lanes.push_back(prototype.clone());
+        for (std::size_t reg = 0; reg < REGS_COUNT; reg++) {
+            this->set(lane, (RegisterType)reg, prototype.state.registers.reg_buffer[reg]);
+        }
+    }
+}
+
+
+LockstepEngine::~LockstepEngine() = default;
+
+
+Registers LockstepEngine::registers(std::size_t lane) const {
+    Registers result;
+    for (std::size_t reg = 0; reg < REGS_COUNT; reg++) {
+        result.reg_buffer[reg] = this->get(lane, (RegisterType)reg);
+    }
+    return result;
+}
+
+
+const LockstepEngine::Op& LockstepEngine::decode(uint32_t pc) {
+    std::unique_ptr<Op>& cached = this->ops[pc];
+    if (cached) {
+        return *cached;
+    }
+    cached.reset(new Op());
+    Op& op = *cached;
+
+    MemoryBus& code = this->lanes[0]->memory;
+    uint16_t opcode = (uint16_t)code.get(pc, SIZE_WORD);
+    op.instruction = this->lanes[0]->instruction_decoder.Decode(opcode);
+    op.next_pc = pc + SIZE_WORD;
+    if (!op.instruction->is_valid) {
+        return op;
+    }
+
+    Instruction* instruction = op.instruction;
+    RegisterType data_reg = (RegisterType)((opcode >> 9) & 0x7);
+    uint16_t ea_mode = (opcode >> 3) & 0x7;
+    RegisterType ea_reg = (RegisterType)(opcode & 0x7);
+    bool ok = false;
+
+    if (dynamic_cast<Moveq*>(instruction)) {
+        op.alu = ALU_MOVE;
+        op.immediate = true;
+        op.imm = (uint32_t)(int32_t)(int8_t)(opcode & 0xFF);
+        op.dest = data_reg;
+        ok = true;
+    } else if (dynamic_cast<Move*>(instruction)) {
+        uint16_t size_part = (opcode >> 12) & 0x3;
+        op.alu = ALU_MOVE;
+        op.size = size_part == 1 ? SIZE_BYTE : (size_part == 3 ? SIZE_WORD : SIZE_LONG);
+        op.src = ea_reg;
+        op.dest = data_reg;
+        ok = ea_mode == 0 && ((opcode >> 6) & 0x7) == 0;
+    } else if (dynamic_cast<Add*>(instruction) || dynamic_cast<Sub*>(instruction) ||
+               dynamic_cast<And*>(instruction) || dynamic_cast<Or*>(instruction) || dynamic_cast<Cmp*>(instruction)) {
+        op.alu = dynamic_cast<Add*>(instruction) ? ALU_ADD
+               : dynamic_cast<Sub*>(instruction) ? ALU_SUB
+               : dynamic_cast<And*>(instruction) ? ALU_AND
+               : dynamic_cast<Or*>(instruction) ? ALU_OR : ALU_CMP;
+        op.size = standardSize(opcode >> 6);
+        op.src = ea_reg;
+        op.dest = data_reg;
+        ok = !(opcode & 0x0100) && ea_mode == 0;
+    } else if (dynamic_cast<Eor*>(instruction)) {
+        op.alu = ALU_XOR;
+        op.size = standardSize(opcode >> 6);
+        op.src = data_reg;
+        op.dest = ea_reg;
+        ok = ea_mode == 0;
+    } else if (dynamic_cast<Addq*>(instruction) || dynamic_cast<Subq*>(instruction)) {
+        op.alu = dynamic_cast<Addq*>(instruction) ? ALU_ADD : ALU_SUB;
+        op.size = standardSize(opcode >> 6);
+        op.immediate = true;
+        op.imm = data_reg ? (uint32_t)data_reg : 8;
+        op.dest = ea_reg;
+        ok = ea_mode == 0;
+    } else if (dynamic_cast<Tst*>(instruction)) {
+        // CMP of the register with 0 without writing it
+        op.alu = ALU_CMP;
+        op.size = standardSize(opcode >> 6);
+        op.immediate = true;
+        op.dest = ea_reg;
+        ok = ea_mode == 0;
+    } else if (dynamic_cast<Clr*>(instruction)) {
+        op.alu = ALU_MOVE;
+        op.size = standardSize(opcode >> 6);
+        op.immediate = true;
+        op.dest = ea_reg;
+        ok = ea_mode == 0;
+    } else if (dynamic_cast<Bcc*>(instruction)) {
+        // BSR pushes to memory and 32 bit displacements are left to the interpreter
+        uint16_t displacement = opcode & 0xFF;
+        int32_t offset = (int8_t)displacement;
+        if (displacement == 0x00) {
+            offset = (int16_t)code.get(pc + SIZE_WORD, SIZE_WORD);
+            op.next_pc += SIZE_WORD;
+        }
+        op.condition = (Condition)((opcode >> 8) & 0xF);
+        op.target = pc + SIZE_WORD + (uint32_t)offset;
+        if (op.condition != COND_FALSE && displacement != 0xFF) {
+            op.kind = Op::BRANCH;
+        }
+        return op;
+    }
+
+    if (ok && op.size != 0) {
+        op.kind = Op::ALU;
+    }
+    return op;
+}
+
+
+void LockstepEngine::executeScalar(std::size_t lane, Instruction* instruction) {
+    CPUState& state = this->lanes[lane]->state;
+    Registers& registers = state.registers;
+    for (std::size_t reg = 0; reg < REGS_COUNT; reg++) {
+        registers.reg_buffer[reg] = this->get(lane, (RegisterType)reg);
+    }
+    uint32_t pc = registers.pc;
+    Registers before = registers;
+    instruction->execute(state);
+    if (state.pendingException() != VECTOR_NONE) {
+        state.abortOnFault(before);
+        state.processException(pc);
+    }
+    registers.materializeFlags();
+    for (std::size_t reg = 0; reg < REGS_COUNT; reg++) {
+        this->set(lane, (RegisterType)reg, registers.reg_buffer[reg]);
+    }
+}
+
+
+uint64_t LockstepEngine::run(uint64_t step_limit, uint32_t stop_pc) {
+    const std::size_t count = this->lane_count;
+    uint32_t* pc = this->bankOf(REG_PC);
+    uint32_t* sr = this->bankOf(REG_SR);
+    uint32_t* mask = this->mask.data();
+    uint32_t* waiting = this->waiting.data();
+    uint64_t executed = 0;
+    uint32_t lowest = 0;  // PC of the step
+    std::size_t active = 0;
+    bool converged = false;  // every running lane is at lowest, the mask is still valid
+    std::fill(this->waiting.begin(), this->waiting.end(), 0u);
+
+    for (uint64_t step = 0; step < step_limit; step++) {
+        if (!converged) {
+            // Lanes at the lowest PC take the step, the others wait for them to catch up. A lane
+            // that waited wait_limit steps goes first, one that polls below it would starve it.
+            lowest = 0xFFFFFFFF;
+            std::size_t running = 0;
+            std::size_t longest = count;
+            for (std::size_t i = 0; i < count; i++) {
+                // a halted or stopped lane waits for an interrupt it never gets here
+                const CPUState& state = this->lanes[i]->state;
+                bool done = pc[i] == stop_pc || state.halted || state.stopped;
+                lowest = std::min(lowest, done ? 0xFFFFFFFF : pc[i]);
+                running += !done;
+                if (done) {
+                    waiting[i] = 0;
+                } else if (waiting[i] >= this->wait_limit && (longest == count || waiting[i] > waiting[longest])) {
+                    longest = i;
+                }
+            }
+            if (running == 0) {
+                break;
+            }
+            if (longest != count) {
+                lowest = pc[longest];
+            }
+            active = 0;
+            for (std::size_t i = 0; i < count; i++) {
+                mask[i] = 0u - (uint32_t)(pc[i] == lowest);
+                active += mask[i] & 1;
+                waiting[i] = mask[i] ? 0 : waiting[i] + 1;
+            }
+            converged = active == running;
+        }
+        executed += active;
+
+        const Op& op = this->decode(lowest);
+        switch (op.kind) {
+            case Op::ALU: {
+                const uint32_t* src = this->bankOf(op.src);
+                if (op.immediate) {
+                    std::fill(this->operand.begin(), this->operand.end(), op.imm);
+                    src = this->operand.data();
+                }
+                aluKernel(op.alu, op.size, count, mask, src, this->bankOf(op.dest), sr);
+                branchKernel(COND_TRUE, count, mask, sr, pc, op.next_pc, op.next_pc);
+                // all lanes moved on together
+                lowest = op.next_pc;
+                converged = converged && lowest != stop_pc;
+                break;
+            }
+            case Op::BRANCH:
+                branchKernel(op.condition, count, mask, sr, pc, op.target, op.next_pc);
+                converged = false;
+                break;
+            case Op::SCALAR:
+                for (std::size_t i = 0; i < count; i++) {
+                    if (mask[i]) {
+                        this->executeScalar(i, op.instruction);
+                    }
+                }
+                converged = false;
+                break;
+        }
+    }
+    return executed;
+}
+
+}  // namespace M68K
@@ -0,0 +1,53 @@
+#include "mapped_memory.hpp"
+
+#include <new>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+
+namespace M68K {
+
+MappedMemory::MappedMemory() : BaseMemory(reserve(MEMORY_SIZE), MEMORY_SIZE) {
+}
+
+
+MappedMemory::~MappedMemory() {
+#if defined(_WIN32)
+    VirtualFree(this->baseAddr, 0, MEM_RELEASE);
+#else
+    munmap(this->baseAddr, this->memSize);
+#endif
+}
+
+
+void* MappedMemory::reserve(std::size_t size) {
+#if defined(_WIN32)
+    // committed pages are only backed by RAM once touched
+    void* memory = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (!memory) {
+        throw std::bad_alloc();
+    }
+#else
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+    flags |= MAP_NORESERVE;  // no swap reservation for the untouched part of the 16 MB
+#endif
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+#endif
+    return memory;
+}
+
+};  // namespace M68K
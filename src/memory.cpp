@@ -1,60 +1,70 @@
 #include "memory.hpp"
 #include "helpers.hpp"
 #include <stdexcept>
+#include <algorithm>
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
 
 
 namespace M68K {
 
-uint32_t IMemory::read_real_mem(void* mem_addr, DataSize size) {
-    uint8_t* addr = (uint8_t*)(mem_addr);
-    uint32_t output_data = 0;
-    switch (size) {
-        case DataSize::SIZE_BYTE:
-            output_data = addr[0];
-            break;
-        case DataSize::SIZE_WORD:
-            output_data = addr[0];
-            output_data = (output_data << 8) | addr[1];
-            break;
-        case DataSize::SIZE_LONG:
-            output_data = addr[0];
-            output_data = (output_data << 8) | addr[1];
-            output_data = (output_data << 8) | addr[2];
-            output_data = (output_data << 8) | addr[3];
-            break;
-        default:
-            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+const uint32_t CodeWatch::CODE_PAGE_SHIFT;
+const uint32_t BaseMemory::DIRTY_PAGE_SHIFT;
+const uint32_t BaseMemory::DIRTY_PAGE_SIZE;  // std::min() takes it by reference
+
+
+void IMemory::read_block(std::size_t address, uint8_t* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        data[i] = (uint8_t)this->get(address + i, SIZE_BYTE);
     }
-    return output_data;
 }
 
 
-void IMemory::write_real_mem(void* mem_addr, DataSize size, uint32_t data) {
-    uint8_t* addr = (uint8_t*)(mem_addr);
-    switch (size) {
-        case DataSize::SIZE_BYTE:
-            addr[0] = (uint8_t)MASK_8(data);
-            break;
-        case DataSize::SIZE_WORD:
-            addr[0] = (uint8_t)MASK_8(data >> 8);
-            addr[1] = (uint8_t)MASK_8(data);
-            break;
-        case DataSize::SIZE_LONG:
-            addr[0] = (uint8_t)MASK_8(data >> 24);
-            addr[1] = (uint8_t)MASK_8(data >> 16);
-            addr[2] = (uint8_t)MASK_8(data >> 8);
-            addr[3] = (uint8_t)MASK_8(data);
-            break;
-        default:
-            throw std::length_error("Invalid memory request size. " + std::to_string(size));
+void IMemory::write_block(std::size_t address, const uint8_t* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        this->set(address + i, SIZE_BYTE, data[i]);
     }
-    return;
 }
 
 
+void IMemory::fill(std::size_t address, uint8_t value, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        this->set(address + i, SIZE_BYTE, value);
+    }
+}
+
 
- BaseMemory::BaseMemory(void* _baseAddr, uint32_t _size) : baseAddr((uint8_t*)_baseAddr), memSize(_size) {
+void CodeWatch::watchCode(uint32_t start, uint32_t end) {
+    if(this->code_map.empty()){
+        this->code_map.assign(this->code_page_count, 0);
+        this->written_code.reserve(this->code_page_count); // every page is listed once, codeWrite() never allocates
+    }
+    uint32_t last = std::min((end - 1) >> CODE_PAGE_SHIFT, this->code_page_count - 1);
+    for(uint32_t page = start >> CODE_PAGE_SHIFT; page <= last && end > start; page++){
+        this->code_map[page] = 1;
+    }
+}
+
+
+void CodeWatch::codeWriteRange(std::size_t address, std::size_t size) noexcept {
+    if(this->code_map.empty() || size == 0)
+        return;
+    uint32_t last = (uint32_t)std::min<std::size_t>((address + size - 1) >> CODE_PAGE_SHIFT, this->code_page_count - 1);
+    for(uint32_t page = (uint32_t)(address >> CODE_PAGE_SHIFT); page <= last; page++){
+        if(this->code_map[page])
+            this->codeWritten(page);
+    }
+}
+
+
+void CodeWatch::codeWritten(uint32_t page) noexcept {
+    this->code_map[page] = 0;
+    this->written_code.push_back(page);
+}
+
+
+BaseMemory::BaseMemory(void* _baseAddr, uint32_t _size) : CodeWatch(_size), baseAddr((uint8_t*)_baseAddr), memSize(_size) {
     if (baseAddr || memSize) {
         baseAddr[memSize - 1] = 0;
         assert(!baseAddr[memSize - 1] && "memory test fail");
@@ -62,37 +72,92 @@ void IMemory::write_real_mem(void* mem_addr, DataSize size, uint32_t data) {
 }
 
 
-uint32_t BaseMemory::get(std::size_t address, DataSize size){
-    address = MASK_ADDR(address);
-    if((size != DataSize::SIZE_BYTE) && (address % 2 != 0)){ // only even is valid in word and long mode
-        throw std::length_error("Memory address must be even."); //TODO: Throw special exception
-    }
-    if(address + size > this->memSize){ //memory overflow
+void BaseMemory::checkBlock(std::size_t address, std::size_t size) const {
+    if(address + size > this->memSize){
         throw std::out_of_range(
-            "Memory address out of range. " +
-            std::to_string(address) + ">" + std::to_string(memSize)
-        ); //TODO: Throw special exception
+            "Memory block out of range. " +
+            std::to_string(address) + "+" + std::to_string(size) + ">" + std::to_string(memSize)
+        );
     }
-    uint8_t* addr = &baseAddr[address];
-    return read_real_mem(addr, size);
 }
 
 
-void BaseMemory::set(std::size_t address, DataSize size, uint32_t data){
+void BaseMemory::read_block(std::size_t address, uint8_t* data, std::size_t size){
     address = MASK_ADDR(address);
-    if((size != DataSize::SIZE_BYTE) && (address % 2 != 0)){ // only even is valid in word and long mode
-        throw std::length_error("Memory address must be even."); //TODO: Throw special exception
+    this->checkBlock(address, size);
+    std::memcpy(data, this->baseAddr + address, size);
+}
+
+
+void BaseMemory::write_block(std::size_t address, const uint8_t* data, std::size_t size){
+    address = MASK_ADDR(address);
+    this->checkBlock(address, size);
+    std::memcpy(this->baseAddr + address, data, size);
+    this->markDirty(address, size);
+    this->codeWriteRange(address, size);
+}
+
+
+void BaseMemory::fill(std::size_t address, uint8_t value, std::size_t size){
+    address = MASK_ADDR(address);
+    this->checkBlock(address, size);
+    std::memset(this->baseAddr + address, value, size);
+    this->markDirty(address, size);
+    this->codeWriteRange(address, size);
+}
+
+
+MemorySnapshot BaseMemory::snapshot() {
+    MemorySnapshot result;
+    result.data.assign(this->baseAddr, this->baseAddr + this->memSize);
+    static std::atomic<uint64_t> snapshots(0);
+    result.generation = this->generation = ++snapshots;
+    this->dirty_map.assign((this->memSize + DIRTY_PAGE_SIZE - 1) >> DIRTY_PAGE_SHIFT, 0);
+    this->dirty_pages.clear();
+    this->dirty_pages.reserve(this->dirty_map.size()); // every page is listed once, store() never allocates
+    return result;
+}
+
+
+void BaseMemory::restore(const MemorySnapshot& snapshot) {
+    if(snapshot.data.size() != this->memSize){
+        throw std::invalid_argument("Snapshot size does not match the memory size.");
     }
-    
-    if(address + size > this->memSize){ // memory out of range.
-        throw std::out_of_range(
-            "Memory address out of range. " +
-            std::to_string(address) + ">" + std::to_string(memSize)
-        ); //TODO: Throw special exception
+    if(this->dirty_map.empty() || snapshot.generation == 0 || snapshot.generation != this->generation){
+        // nothing tracked yet or tracked since another snapshot, every page may differ
+        std::memcpy(this->baseAddr, snapshot.data.data(), this->memSize);
+        this->codeWriteRange(0, this->memSize);
+        this->dirty_map.assign((this->memSize + DIRTY_PAGE_SIZE - 1) >> DIRTY_PAGE_SHIFT, 0);
+        this->dirty_pages.clear();
+        this->dirty_pages.reserve(this->dirty_map.size());
+        this->generation = snapshot.generation;
+        return;
     }
+    for(uint32_t page : this->dirty_pages){
+        uint32_t address = page << DIRTY_PAGE_SHIFT;
+        uint32_t size = std::min(DIRTY_PAGE_SIZE, this->memSize - address);
+        std::memcpy(this->baseAddr + address, snapshot.data.data() + address, size);
+        this->codeWriteRange(address, size);
+        this->dirty_map[page] = 0;
+    }
+    this->dirty_pages.clear();
+}
 
-    uint8_t* addr = &baseAddr[address];
-    write_real_mem(addr, size, data);
+
+void BaseMemory::markDirty(uint32_t page) {
+    this->dirty_map[page] = 1;
+    this->dirty_pages.push_back(page);
+}
+
+
+void BaseMemory::markDirty(std::size_t address, std::size_t size) {
+    if(this->dirty_map.empty() || size == 0)
+        return;
+    uint32_t last = (uint32_t)((address + size - 1) >> DIRTY_PAGE_SHIFT);
+    for(uint32_t page = (uint32_t)(address >> DIRTY_PAGE_SHIFT); page <= last; page++){
+        if(!this->dirty_map[page])
+            this->markDirty(page);
+    }
 }
 
 
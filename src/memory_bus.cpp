@@ -0,0 +1,230 @@
+#include "memory_bus.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+
+namespace M68K {
+
+void MemoryBus::checkRange(uint32_t base, uint32_t size) const {
+    if ((base % PAGE_SIZE != 0) || (size % PAGE_SIZE != 0)) {
+        throw std::invalid_argument("Memory mapping must be page aligned.");
+    }
+    if ((uint64_t)base + size > MEMORY_SIZE) {
+        throw std::out_of_range(
+            "Memory mapping out of range. " +
+            std::to_string(base) + "+" + std::to_string(size) + ">" + std::to_string(MEMORY_SIZE)
+        );
+    }
+}
+
+
+MemoryBus::Page& MemoryBus::resetPage(uint32_t address) {
+    uint32_t index = address >> PAGE_SHIFT;
+    if (this->pages[index].owned) {
+        this->frames[index].reset();
+    }
+    if (this->pages[index].device) {
+        this->device_pages--;
+    }
+    this->pages[index] = Page();
+    this->codeWriteRange(address, PAGE_SIZE);
+    return this->pages[index];
+}
+
+
+void MemoryBus::mapMemory(uint32_t base, uint32_t size, uint8_t* host, PageAccess access) {
+    this->checkRange(base, size);
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        Page& page = this->resetPage(base + offset);
+        page.read = (access & PAGE_READ) ? host + offset : nullptr;
+        page.write = (access & PAGE_WRITE) ? host + offset : nullptr;
+    }
+}
+
+
+void MemoryBus::mapDevice(uint32_t base, uint32_t size, IMemory* device) {
+    this->checkRange(base, size);
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        Page& page = this->resetPage(base + offset);
+        page.device = device;
+        page.device_base = base;
+        this->device_pages++;
+    }
+}
+
+
+void MemoryBus::unmap(uint32_t base, uint32_t size) {
+    this->checkRange(base, size);
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        this->resetPage(base + offset);
+    }
+}
+
+
+void MemoryBus::mapRam(uint32_t base, uint32_t size) {
+    // read by every owned page that was never written
+    static uint8_t zero_page[PAGE_SIZE] = {};
+
+    this->checkRange(base, size);
+    if (this->frames.empty()) {
+        this->frames.resize(PAGE_COUNT);
+    }
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        Page& page = this->resetPage(base + offset);
+        page.read = zero_page;
+        page.owned = true;
+    }
+}
+
+
+void MemoryBus::mapRam(uint32_t base, uint32_t size, const uint8_t* data, std::shared_ptr<const void> owner) {
+    this->mapRam(base, size);
+    for (uint32_t offset = 0; offset < size; offset += PAGE_SIZE) {
+        // never written through, makePrivate() copies it like the zero page
+        this->pages[(base + offset) >> PAGE_SHIFT].read = const_cast<uint8_t*>(data + offset);
+    }
+    this->owners.push_back(std::move(owner));
+}
+
+
+void MemoryBus::mapRom(uint32_t base, uint32_t size, const uint8_t* data, std::shared_ptr<const void> owner) {
+    this->mapMemory(base, size, const_cast<uint8_t*>(data), PAGE_READ);
+    this->owners.push_back(std::move(owner));
+}
+
+
+void MemoryBus::shareFrom(MemoryBus& source) {
+    for (Page& page : source.pages) {
+        if (page.owned) {
+            page.write = nullptr;
+        }
+    }
+    std::copy(std::begin(source.pages), std::end(source.pages), std::begin(this->pages));
+    this->codeWriteRange(0, MEMORY_SIZE);
+    this->device_pages = source.device_pages;
+    this->frames = source.frames;
+    this->owners = source.owners;
+}
+
+
+void MemoryBus::makePrivate(uint32_t index) {
+    Page& page = this->pages[index];
+    std::shared_ptr<uint8_t>& frame = this->frames[index];
+    if (!frame || frame.use_count() > 1) {  // the zero page, initial data or a page another bus still reads
+        std::shared_ptr<uint8_t> copy(new uint8_t[PAGE_SIZE], std::default_delete<uint8_t[]>());
+        std::memcpy(copy.get(), page.read, PAGE_SIZE);
+        frame = std::move(copy);
+    }
+    page.read = page.write = frame.get();
+}
+
+
+uint8_t* MemoryBus::hostPointer(std::size_t address, PageAccess access) const {
+    uint32_t addr = (uint32_t)MASK_ADDR(address);
+    const Page& page = this->pages[addr >> PAGE_SHIFT];
+    uint8_t* host = (access & PAGE_WRITE) ? page.write : page.read;
+    if (!host || ((access & PAGE_READ) && !page.read)) {
+        return nullptr;
+    }
+    return host + (addr & (PAGE_SIZE - 1));
+}
+
+
+uint8_t* MemoryBus::writablePage(uint32_t address) {
+    uint32_t index = address >> PAGE_SHIFT;
+    if (this->pages[index].owned && !this->pages[index].write) {
+        this->makePrivate(index);
+    }
+    return this->pages[index].write;
+}
+
+
+void MemoryBus::read_block(std::size_t address, uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        uint32_t addr = (uint32_t)MASK_ADDR(address);
+        uint32_t offset = addr & (PAGE_SIZE - 1);
+        std::size_t chunk = std::min<std::size_t>(size, PAGE_SIZE - offset);
+        const uint8_t* page = this->pages[addr >> PAGE_SHIFT].read;
+        if (page) {
+            std::memcpy(data, page + offset, chunk);
+        } else {
+            IMemory::read_block(addr, data, chunk);
+        }
+        address += chunk, data += chunk, size -= chunk;
+    }
+}
+
+
+void MemoryBus::write_block(std::size_t address, const uint8_t* data, std::size_t size) {
+    while (size > 0) {
+        uint32_t addr = (uint32_t)MASK_ADDR(address);
+        uint32_t offset = addr & (PAGE_SIZE - 1);
+        std::size_t chunk = std::min<std::size_t>(size, PAGE_SIZE - offset);
+        uint8_t* page = this->writablePage(addr);
+        if (page) {
+            std::memcpy(page + offset, data, chunk);
+            this->codeWriteRange(addr, chunk);
+        } else {
+            IMemory::write_block(addr, data, chunk);
+        }
+        address += chunk, data += chunk, size -= chunk;
+    }
+}
+
+
+void MemoryBus::fill(std::size_t address, uint8_t value, std::size_t size) {
+    while (size > 0) {
+        uint32_t addr = (uint32_t)MASK_ADDR(address);
+        uint32_t offset = addr & (PAGE_SIZE - 1);
+        std::size_t chunk = std::min<std::size_t>(size, PAGE_SIZE - offset);
+        uint8_t* page = this->writablePage(addr);
+        if (page) {
+            std::memset(page + offset, value, chunk);
+            this->codeWriteRange(addr, chunk);
+        } else {
+            IMemory::fill(addr, value, chunk);
+        }
+        address += chunk, size -= chunk;
+    }
+}
+
+
+uint32_t MemoryBus::readSlow(uint32_t address, DataSize size) {
+    if (!inPage(address, size)) {  // a long word at the end of a page, each half may be mapped differently
+        uint32_t high = this->read<SIZE_WORD>(address);
+        return (high << 16) | this->read<SIZE_WORD>(address + 2);
+    }
+    const Page& page = this->pages[address >> PAGE_SHIFT];
+    if (page.device) {
+        return page.device->get(address - page.device_base, size);
+    }
+    throw std::out_of_range("Read from unmapped memory. " + std::to_string(address));
+}
+
+
+void MemoryBus::writeSlow(uint32_t address, DataSize size, uint32_t data) {
+    if (!inPage(address, size)) {
+        this->write<SIZE_WORD>(address, data >> 16);
+        this->write<SIZE_WORD>(address + 2, data);
+        return;
+    }
+    const Page& page = this->pages[address >> PAGE_SHIFT];
+    if (page.device) {
+        page.device->set(address - page.device_base, size, data);
+        return;
+    }
+    if (page.owned) {
+        this->makePrivate(address >> PAGE_SHIFT);
+        this->set(address, size, data);
+        return;
+    }
+    if (page.read) {  // ROM
+        return;
+    }
+    throw std::out_of_range("Write to unmapped memory. " + std::to_string(address));
+}
+
+};  // namespace M68K
@@ -6,6 +6,9 @@ using namespace M68K;
 uint32_t Registers::get(RegisterType reg_ind, DataSize size){
     assert((size_t)reg_ind < this->reg_buffer.size());
 
+    if (reg_ind == REG_SR)
+        this->materializeFlags();
+
     if (reg_ind == REG_A7 && sr.supervisor)
         reg_ind = REG_SSP;
 
@@ -60,6 +63,9 @@ void Registers::set(RegisterType reg_ind, DataSize size, uint32_t data){
     }
     if(reg_ind == REG_SR){
         reg_value = MASK_16(reg_value);
+#if M68K_LAZY_FLAGS
+        this->flags_op = FLAGS_NONE; // every size overwrites the whole CCR
+#endif
     }
 
     this->reg_buffer[reg_ind] = reg_value;
@@ -68,6 +74,7 @@ void Registers::set(RegisterType reg_ind, DataSize size, uint32_t data){
 
 
 bool Registers::get(StatusRegisterFlag flag){
+    this->materializeFlags();
     uint32_t sr_value = this->reg_buffer[REG_SR];
     uint32_t flag_mask = uint32_t(flag);
     return (sr_value & flag_mask) ? true : false;
@@ -75,6 +82,7 @@ bool Registers::get(StatusRegisterFlag flag){
 
 
 void Registers::set(StatusRegisterFlag flag, bool value){
+    this->materializeFlags();
     uint32_t sr_value = this->reg_buffer[REG_SR];
     uint32_t flag_mask = uint32_t(flag);
     sr_value &= ~flag_mask;
@@ -84,3 +92,46 @@ void Registers::set(StatusRegisterFlag flag, bool value){
     this->reg_buffer[REG_SR] = sr_value;
     return;
 }
+
+
+uint32_t Registers::computeFlags(FlagsOperation op, DataSize size, uint32_t src, uint32_t dest){
+    uint32_t flags = 0;
+    switch(op){
+        case FLAGS_ADD:
+        case FLAGS_SUB:
+        case FLAGS_CMP:{
+            uint64_t result = (op == FLAGS_ADD) ? (uint64_t)src + dest : (uint64_t)dest - src;
+            bool overflow = (op == FLAGS_ADD) ? IS_OVERFLOW(src, dest, size) : IS_OVERFLOW_SUB(src, dest, size);
+            if(IS_CARRY(result, size)){
+                flags |= SR_FLAG_CARRY | (op == FLAGS_CMP ? 0 : SR_FLAG_EXTEND);
+            }
+            flags |= IS_NEGATIVE(result, size) ? SR_FLAG_NEGATIVE : 0;
+            flags |= IS_ZERO(result, size) ? SR_FLAG_ZERO : 0;
+            flags |= overflow ? SR_FLAG_OVERFLOW : 0;
+            break;
+        }
+        case FLAGS_SHIFT:
+        case FLAGS_ROTATE:
+            if(src){
+                flags |= SR_FLAG_CARRY | (op == FLAGS_SHIFT ? SR_FLAG_EXTEND : 0);
+            }
+            // fallthrough
+        case FLAGS_LOGIC:
+            flags |= IS_NEGATIVE(dest, size) ? SR_FLAG_NEGATIVE : 0;
+            flags |= IS_ZERO(dest, size) ? SR_FLAG_ZERO : 0;
+            break;
+        case FLAGS_NONE:
+            break;
+    }
+    return flags;
+}
+
+
+#if M68K_LAZY_FLAGS
+void Registers::resolveFlags(){
+    uint32_t mask = flagsMask(this->flags_op);
+    uint32_t flags = computeFlags(this->flags_op, this->flags_size, this->flags_src, this->flags_dest);
+    this->reg_buffer[REG_SR] = (this->reg_buffer[REG_SR] & ~mask) | flags;
+    this->flags_op = FLAGS_NONE;
+}
+#endif
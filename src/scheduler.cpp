@@ -0,0 +1,51 @@
+#include "scheduler.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace M68K {
+
+const uint64_t Scheduler::NEVER;
+
+
+Scheduler::EventId Scheduler::schedule(uint64_t cycle, Callback callback) {
+    Event event;
+    event.cycle = cycle;
+    event.id = this->next_id++;
+    event.callback = std::move(callback);
+    EventId id = event.id;
+    this->events.push_back(std::move(event));
+    std::push_heap(this->events.begin(), this->events.end(), later);
+    this->update();
+    return id;
+}
+
+
+bool Scheduler::cancel(EventId id) {
+    auto it = std::find_if(this->events.begin(), this->events.end(), [id](const Event& event) { return event.id == id; });
+    if (it == this->events.end())
+        return false;
+    this->events.erase(it);
+    std::make_heap(this->events.begin(), this->events.end(), later);
+    this->update();
+    return true;
+}
+
+
+void Scheduler::clear() {
+    this->events.clear();
+    this->update();
+}
+
+
+void Scheduler::dispatch(uint64_t now) {
+    while (!this->events.empty() && this->events.front().cycle <= now) {
+        std::pop_heap(this->events.begin(), this->events.end(), later);
+        Callback callback = std::move(this->events.back().callback);
+        this->events.pop_back();
+        this->update();
+        callback(now);  // may change the heap
+    }
+}
+
+}  // namespace M68K
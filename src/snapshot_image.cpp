@@ -0,0 +1,321 @@
+#include "snapshot_image.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace M68K {
+
+namespace {
+
+const char IMAGE_MAGIC[8] = {'M', '6', '8', 'K', 'I', 'M', 'G', '2'};
+const uint32_t IMAGE_PAGE_SIZE = MemoryBus::PAGE_SIZE;
+const uint32_t IMAGE_STATE_COUNT = 6;  // longs of the run state after the registers
+
+// low bits of a page entry, the address is page aligned
+const uint32_t IMAGE_PAGE_ROM = 1;   // read-only page
+const uint32_t IMAGE_PAGE_ZERO = 2;  // page of zeros, without data in the file
+const uint32_t IMAGE_HALTED = 1;
+const uint32_t IMAGE_STOPPED = 2;
+
+struct ImageLayout {
+    Registers registers;
+    uint32_t flags = 0;
+    uint64_t cycles = 0;
+    uint8_t irq_levels = 0;
+    uint8_t irq_vectors[8] = {};
+    std::vector<uint32_t> pages;  // address | kind
+    std::vector<std::size_t> data;  // file offset of the data of each page, 0 for zero pages
+};
+
+void putLong(std::vector<uint8_t>& out, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back((uint8_t)(value >> (8 * i)));
+    }
+}
+
+uint32_t getLong(const uint8_t* in) {
+    return (uint32_t)in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+// the header of an image of size bytes, false if it is truncated or no image
+bool parseImage(const uint8_t* data, std::size_t size, ImageLayout& layout) {
+    const std::size_t fixed = sizeof(IMAGE_MAGIC) + 3 * 4;
+    if (size < fixed || std::memcmp(data, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0) {
+        return false;
+    }
+    const uint8_t* cursor = data + sizeof(IMAGE_MAGIC);
+    uint32_t page_size = getLong(cursor);
+    uint32_t register_count = getLong(cursor + 4);
+    uint32_t page_count = getLong(cursor + 8);
+    if (page_size != IMAGE_PAGE_SIZE || register_count != REGS_COUNT || page_count > MemoryBus::PAGE_COUNT) {
+        return false;
+    }
+    cursor += 12;
+
+    std::size_t header = fixed + 4 * ((std::size_t)register_count + IMAGE_STATE_COUNT + page_count);
+    if (size < header) {
+        return false;
+    }
+
+    layout.registers = Registers();
+    for (uint32_t i = 0; i < register_count; i++, cursor += 4) {
+        layout.registers.reg_buffer[i] = getLong(cursor);
+    }
+    layout.flags = getLong(cursor);
+    layout.cycles = getLong(cursor + 4) | ((uint64_t)getLong(cursor + 8) << 32);
+    layout.irq_levels = (uint8_t)getLong(cursor + 12);
+    for (int level = 0; level < 8; level++) {
+        layout.irq_vectors[level] = cursor[16 + level];
+    }
+    cursor += 4 * IMAGE_STATE_COUNT;
+
+    std::size_t offset = (header + IMAGE_PAGE_SIZE - 1) / IMAGE_PAGE_SIZE * IMAGE_PAGE_SIZE;
+    layout.pages.resize(page_count);
+    layout.data.resize(page_count);
+    for (uint32_t i = 0; i < page_count; i++, cursor += 4) {
+        uint32_t entry = getLong(cursor);
+        uint32_t address = entry & ~(IMAGE_PAGE_SIZE - 1);
+        if (address >= MEMORY_SIZE || (i > 0 && address <= (layout.pages[i - 1] & ~(IMAGE_PAGE_SIZE - 1)))) {
+            return false;
+        }
+        layout.pages[i] = entry;
+        layout.data[i] = 0;
+        if (!(entry & IMAGE_PAGE_ZERO)) {
+            layout.data[i] = offset;
+            offset += IMAGE_PAGE_SIZE;
+        }
+    }
+    return size >= offset;
+}
+
+// index of the entry of each page in layout.pages, page_count if it is not in the image
+std::vector<uint32_t> pageIndex(const ImageLayout& layout) {
+    std::vector<uint32_t> index(MemoryBus::PAGE_COUNT, (uint32_t)layout.pages.size());
+    for (uint32_t i = 0; i < layout.pages.size(); i++) {
+        index[layout.pages[i] >> MemoryBus::PAGE_SHIFT] = i;
+    }
+    return index;
+}
+
+void restoreState(CPUCore* cpu, const ImageLayout& layout) {
+    cpu->block_cache.clear();
+#if M68K_JIT
+    cpu->jit.clear();
+#endif
+    CPUState& state = cpu->state;
+    state.resetRunState();
+    state.registers = layout.registers;
+    state.halted = (layout.flags & IMAGE_HALTED) != 0;
+    state.stopped = (layout.flags & IMAGE_STOPPED) != 0;
+    state.cycles = layout.cycles;
+    for (int level = 1; level < 8; level++) {
+        if (layout.irq_levels & (1 << level)) {
+            state.raiseIRQ(level, layout.irq_vectors[level]);
+        }
+    }
+}
+
+
+// Read-only view of a whole file, unmapped with the last reference
+class MappedFile {
+public:
+    const uint8_t* data = nullptr;
+    std::size_t size = 0;
+
+    explicit MappedFile(const std::string& file_name) {
+#if defined(_WIN32)
+        HANDLE file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER file_size;
+        if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping) {
+                this->data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                this->size = this->data ? (std::size_t)file_size.QuadPart : 0;
+                CloseHandle(mapping);
+            }
+        }
+        CloseHandle(file);
+#else
+        int file = open(file_name.c_str(), O_RDONLY);
+        if (file < 0)
+            return;
+        struct stat info;
+        if (fstat(file, &info) == 0 && info.st_size > 0) {
+            void* memory = mmap(nullptr, (std::size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+            if (memory != MAP_FAILED) {
+                this->data = static_cast<const uint8_t*>(memory);
+                this->size = (std::size_t)info.st_size;
+            }
+        }
+        close(file);
+#endif
+    }
+
+    ~MappedFile() {
+        if (!this->data)
+            return;
+#if defined(_WIN32)
+        UnmapViewOfFile(this->data);
+#else
+        munmap(const_cast<uint8_t*>(this->data), this->size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+};
+
+}  // namespace
+
+
+bool save_image(CPUCore* cpu, const std::string& file_name) {
+    Registers registers = cpu->state.registers;
+    registers.materializeFlags();
+
+    std::vector<uint32_t> entries;
+    std::vector<uint8_t> pages;
+    std::vector<uint8_t> page(IMAGE_PAGE_SIZE);
+    const MemoryBus* bus = dynamic_cast<const MemoryBus*>(&cpu->state.memory);
+    for (uint32_t address = 0; address < MEMORY_SIZE; address += IMAGE_PAGE_SIZE) {
+        uint32_t kind = 0;
+        if (bus) {
+            PageAccess access = bus->pageAccess(address);
+            if (!(access & PAGE_READ)) {  // devices, reads of a device may have side effects
+                continue;
+            }
+            kind = (access & PAGE_WRITE) ? 0 : IMAGE_PAGE_ROM;
+        }
+        try {
+            cpu->state.memory.read_block(address, page.data(), page.size());
+        } catch (const std::out_of_range&) {
+            continue;
+        }
+        if (std::all_of(page.begin(), page.end(), [](uint8_t byte) { return byte == 0; })) {
+            kind |= IMAGE_PAGE_ZERO;
+        } else {
+            pages.insert(pages.end(), page.begin(), page.end());
+        }
+        entries.push_back(address | kind);
+    }
+
+    const CPUState& state = cpu->state;
+    std::vector<uint8_t> header(IMAGE_MAGIC, IMAGE_MAGIC + sizeof(IMAGE_MAGIC));
+    putLong(header, IMAGE_PAGE_SIZE);
+    putLong(header, REGS_COUNT);
+    putLong(header, (uint32_t)entries.size());
+    for (uint32_t value : registers.reg_buffer) {
+        putLong(header, value);
+    }
+    putLong(header, (state.halted ? IMAGE_HALTED : 0) | (state.stopped ? IMAGE_STOPPED : 0));
+    putLong(header, (uint32_t)state.cycles);
+    putLong(header, (uint32_t)(state.cycles >> 32));
+    putLong(header, state.requestedIRQs());
+    for (int level = 0; level < 8; level++) {
+        header.push_back(state.irqVector(level));
+    }
+    for (uint32_t entry : entries) {
+        putLong(header, entry);
+    }
+    header.resize((header.size() + IMAGE_PAGE_SIZE - 1) / IMAGE_PAGE_SIZE * IMAGE_PAGE_SIZE, 0);
+
+    std::ofstream file(file_name, std::ios::binary | std::ios::trunc);
+    file.write((const char*)header.data(), (std::streamsize)header.size());
+    file.write((const char*)pages.data(), (std::streamsize)pages.size());
+    return (bool)file;
+}
+
+
+bool load_image(CPUCore* cpu, const std::string& file_name) {
+    std::ifstream file(file_name, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    ImageLayout layout;
+    if (!parseImage(data.data(), data.size(), layout)) {
+        return false;
+    }
+
+    std::vector<uint32_t> index = pageIndex(layout);
+    std::vector<uint8_t> page(IMAGE_PAGE_SIZE);
+    const MemoryBus* bus = dynamic_cast<const MemoryBus*>(&cpu->state.memory);
+    for (uint32_t address = 0; address < MEMORY_SIZE; address += IMAGE_PAGE_SIZE) {
+        if (bus && bus->isDevicePage(address)) {
+            continue;
+        }
+        uint32_t i = index[address >> MemoryBus::PAGE_SHIFT];
+        try {
+            if (i < layout.pages.size() && layout.data[i]) {
+                cpu->state.memory.write_block(address, &data[layout.data[i]], IMAGE_PAGE_SIZE);
+                continue;
+            }
+            // pages that are zero or not in the image, only written if they are not zero yet so
+            // that the untouched RAM of a bus stays unallocated
+            cpu->state.memory.read_block(address, page.data(), page.size());
+            if (!std::all_of(page.begin(), page.end(), [](uint8_t byte) { return byte == 0; })) {
+                cpu->state.memory.fill(address, 0, IMAGE_PAGE_SIZE);
+            }
+        } catch (const std::out_of_range&) {
+        }
+    }
+    restoreState(cpu, layout);
+    return true;
+}
+
+
+bool load_image(BasicCPU<MemoryBus>* cpu, const std::string& file_name) {
+    // read by the ROM pages of zeros
+    static const uint8_t zero_page[IMAGE_PAGE_SIZE] = {};
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(file_name);
+    ImageLayout layout;
+    if (!file->data || !parseImage(file->data, file->size, layout)) {
+        return false;
+    }
+
+    std::vector<uint32_t> index = pageIndex(layout);
+    for (uint32_t address = 0; address < MEMORY_SIZE; address += IMAGE_PAGE_SIZE) {
+        if (cpu->memory.isDevicePage(address)) {
+            continue;
+        }
+        uint32_t i = index[address >> MemoryBus::PAGE_SHIFT];
+        if (i == layout.pages.size()) {
+            cpu->memory.unmap(address, IMAGE_PAGE_SIZE);
+            continue;
+        }
+        const uint8_t* page = layout.data[i] ? file->data + layout.data[i] : zero_page;
+        if (layout.pages[i] & IMAGE_PAGE_ROM) {
+            cpu->memory.mapRom(address, IMAGE_PAGE_SIZE, page, file);
+        } else if (layout.data[i]) {
+            cpu->memory.mapRam(address, IMAGE_PAGE_SIZE, page, file);
+        } else {
+            cpu->memory.mapRam(address, IMAGE_PAGE_SIZE);
+        }
+    }
+    restoreState(cpu, layout);
+    return true;
+}
+
+}  // namespace M68K
@@ -0,0 +1,239 @@
+#include "stats.hpp"
+#include "instruction_decoder.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace M68K {
+
+uint64_t ExecutionStats::instructions() const {
+    uint64_t sum = 0;
+    for (uint64_t count : this->opcodes) {
+        sum += count;
+    }
+    return sum;
+}
+
+void ExecutionStats::reset() {
+    this->reads = this->read_bytes = this->writes = this->write_bytes = 0;
+    std::fill(std::begin(this->opcodes), std::end(this->opcodes), 0);
+}
+
+ExecutionStats& ExecutionStats::operator+=(const ExecutionStats& other) {
+    this->reads += other.reads;
+    this->read_bytes += other.read_bytes;
+    this->writes += other.writes;
+    this->write_bytes += other.write_bytes;
+    for (std::size_t i = 0; i < 0x10000; i++) {
+        this->opcodes[i] += other.opcodes[i];
+    }
+    return *this;
+}
+
+
+#if M68K_STATS
+namespace {
+struct Registry {
+    std::mutex mutex;
+    std::vector<ExecutionStats*> threads;
+    ExecutionStats ended;  // counters of the threads that ended
+};
+
+Registry& registry() {
+    static Registry instance;  // thread_local counters of the main thread are destroyed before it
+    return instance;
+}
+
+// Estimated effective addresses of an opcode accepted by the decoder, read from the ea fields
+// of its instruction group. The instruction classes do not report the modes they decode, so
+// forms this table does not tell apart may be counted with the mode of a neighbouring form.
+std::size_t effectiveAddresses(uint16_t opcode, AddressingMode modes[2]) {
+    using INSTRUCTION::Instruction;
+    uint16_t ea_mode = (opcode >> 3) & 0x7;
+    uint16_t ea_reg = opcode & 0x7;
+    switch (opcode >> 12) {
+        case 0x0:  // the immediate forms, BTST Dn,<ea> and the others with a register
+            if (opcode & 0x0100) {
+                modes[0] = Instruction::getAddressingMode(ea_mode, ea_reg);
+                return 1;
+            }
+            modes[0] = ADDR_MODE_IMMEDIATE;
+            modes[1] = Instruction::getAddressingMode(ea_mode, ea_reg);
+            return 2;
+        case 0x1:
+        case 0x2:
+        case 0x3:  // MOVE
+            modes[0] = Instruction::getAddressingMode(ea_mode, ea_reg);
+            modes[1] = Instruction::getAddressingMode((opcode >> 6) & 0x7, (opcode >> 9) & 0x7);
+            return 2;
+        case 0x4:
+            if ((opcode & 0xFFF0) == 0x4E40 || (opcode & 0xFFF8) == 0x4E70)  // TRAP, NOP, RTE, RTS
+                return 0;
+            if ((opcode & 0xFFF0) == 0x4E50) {  // LINK, UNLK
+                modes[0] = ADDR_MODE_DIRECT_ADDR;
+                return 1;
+            }
+            if ((opcode & 0xFFB8) == 0x4880) {  // EXT
+                modes[0] = ADDR_MODE_DIRECT_DATA;
+                return 1;
+            }
+            break;
+        case 0x6:  // Bcc, BSR
+        case 0x7:  // MOVEQ
+            return 0;
+        case 0x9:
+        case 0xD:  // ADDX, SUBX
+            if ((opcode & 0x0130) == 0x0100) {
+                modes[0] = modes[1] = (opcode & 0x0008) ? ADDR_MODE_INDIRECT_PREDECREMENT : ADDR_MODE_DIRECT_DATA;
+                return 2;
+            }
+            break;
+        case 0xE:  // register shifts
+            if ((opcode & 0x00C0) != 0x00C0) {
+                modes[0] = ADDR_MODE_DIRECT_DATA;
+                return 1;
+            }
+            break;
+    }
+    modes[0] = Instruction::getAddressingMode(ea_mode, ea_reg);
+    return 1;
+}
+
+const char* modeName(AddressingMode mode) {
+    switch (mode) {
+        case ADDR_MODE_DIRECT_DATA: return "Dn";
+        case ADDR_MODE_DIRECT_ADDR: return "An";
+        case ADDR_MODE_INDIRECT: return "(An)";
+        case ADDR_MODE_INDIRECT_POSTINCREMENT: return "(An)+";
+        case ADDR_MODE_INDIRECT_PREDECREMENT: return "-(An)";
+        case ADDR_MODE_INDIRECT_DISPLACEMENT: return "(d16,An)";
+        case ADDR_MODE_INDIRECT_INDEX: return "(d8,An,Xn)";
+        case ADDR_MODE_PC_DISPLACEMENT: return "(d16,PC)";
+        case ADDR_MODE_PC_INDEX: return "(d8,PC,Xn)";
+        case ADDR_MODE_ABS_WORD: return "(xxx).W";
+        case ADDR_MODE_ABS_LONG: return "(xxx).L";
+        case ADDR_MODE_IMMEDIATE: return "#imm";
+        default: return "unknown";
+    }
+}
+
+typedef std::vector<std::pair<std::string, uint64_t>> Histogram;
+
+struct Report {
+    Histogram memory, handlers, modes, opcodes;
+};
+
+Histogram sorted(const std::map<std::string, uint64_t>& counts) {
+    Histogram result(counts.begin(), counts.end());
+    std::stable_sort(result.begin(), result.end(), [](const std::pair<std::string, uint64_t>& a, const std::pair<std::string, uint64_t>& b) {
+        return a.second > b.second;
+    });
+    return result;
+}
+
+Report report(const ExecutionStats& stats) {
+    const InstructionDecoder& decoder = InstructionDecoder::shared();
+    std::map<std::string, uint64_t> handlers, modes, opcodes;
+    for (uint32_t opcode = 0; opcode < 0x10000; opcode++) {
+        uint64_t count = stats.opcodes[opcode];
+        if (count == 0)
+            continue;
+        std::string handler = decoder.handlerName((uint16_t)opcode);
+        handlers[handler] += count;
+        char name[8];
+        std::snprintf(name, sizeof(name), "0x%04X", opcode);
+        opcodes[name] = count;
+        if (decoder.isValid((uint16_t)opcode) && handler != "Illegal") {
+            AddressingMode ea[2];
+            std::size_t n = effectiveAddresses((uint16_t)opcode, ea);
+            for (std::size_t i = 0; i < n; i++) {
+                modes[modeName(ea[i])] += count;
+            }
+        }
+    }
+    Report result;
+    result.memory = {{"reads", stats.reads}, {"read_bytes", stats.read_bytes}, {"writes", stats.writes}, {"write_bytes", stats.write_bytes}};
+    result.handlers = sorted(handlers);
+    result.modes = sorted(modes);
+    result.opcodes = sorted(opcodes);
+    return result;
+}
+
+void writeJsonObject(std::ostream& out, const char* name, const Histogram& histogram, bool last) {
+    out << "  \"" << name << "\": {";
+    for (std::size_t i = 0; i < histogram.size(); i++) {
+        out << (i ? ", " : "") << "\"" << histogram[i].first << "\": " << histogram[i].second;
+    }
+    out << (last ? "}\n" : "},\n");
+}
+}  // namespace
+
+
+STATS::LocalStats::LocalStats() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.threads.push_back(&this->stats);
+}
+
+STATS::LocalStats::~LocalStats() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.ended += this->stats;
+    shared.threads.erase(std::find(shared.threads.begin(), shared.threads.end(), &this->stats));
+}
+
+void STATS::total(ExecutionStats& sum) {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    sum = shared.ended;
+    for (const ExecutionStats* stats : shared.threads) {
+        sum += *stats;
+    }
+}
+
+void STATS::reset() {
+    Registry& shared = registry();
+    std::lock_guard<std::mutex> lock(shared.mutex);
+    shared.ended.reset();
+    for (ExecutionStats* stats : shared.threads) {
+        stats->reset();
+    }
+}
+
+void STATS::writeCsv(std::ostream& out, const ExecutionStats& stats) {
+    Report result = report(stats);
+    out << "kind,name,count\n";
+    out << "instructions,all," << stats.instructions() << "\n";
+    for (const auto& entry : result.memory) {
+        out << "memory," << entry.first << "," << entry.second << "\n";
+    }
+    for (const auto& entry : result.handlers) {
+        out << "handler," << entry.first << "," << entry.second << "\n";
+    }
+    for (const auto& entry : result.modes) {
+        out << "mode_estimate," << entry.first << "," << entry.second << "\n";
+    }
+    for (const auto& entry : result.opcodes) {
+        out << "opcode," << entry.first << "," << entry.second << "\n";
+    }
+}
+
+void STATS::writeJson(std::ostream& out, const ExecutionStats& stats) {
+    Report result = report(stats);
+    out << "{\n";
+    out << "  \"instructions\": " << stats.instructions() << ",\n";
+    writeJsonObject(out, "memory", result.memory, false);
+    writeJsonObject(out, "handlers", result.handlers, false);
+    writeJsonObject(out, "addressing_modes_estimate", result.modes, false);
+    writeJsonObject(out, "opcodes", result.opcodes, true);
+    out << "}\n";
+}
+#endif
+
+}  // namespace M68K
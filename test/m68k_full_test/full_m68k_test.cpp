@@ -67,7 +67,7 @@ class TestCpu {
 public:
     M68K::AlignedMemory memory = {};
     M68K::CPUState state = M68K::CPUState(&memory);
-    M68K::InstructionDecoder decoder;
+    const M68K::InstructionDecoder& decoder = M68K::InstructionDecoder::shared();
     TRamSnapshot ramControl;
 
 public:
@@ -264,6 +264,11 @@ bool WorkOnTest(TestCpu& cpu, const json& test) {
     curInst = cpu.decoder.Decode(opcode);
 
     curInst->execute(cpu.state);
+    // enter the handler like CPUCore::step(), a pending fault would drop the writes of the next test
+    if (cpu.state.pendingException() != VECTOR_NONE) {
+        cpu.state.processException(pc);
+    }
+    cpu.state.registers.materializeFlags();
 
     // this program counter means there really was an illegal instruction
     //return (expectedRegs.get(REG_PC) == 0x1400);
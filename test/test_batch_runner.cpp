@@ -0,0 +1,103 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace M68K;
+
+static const uint32_t DATA_ADDRESS = 0x3000;
+static const uint32_t DATA_COUNT = 30;
+static const uint32_t END_PC = 0x100c4; // for(;;) after bubblesort()
+
+// guest memory is big endian
+static std::vector<uint8_t> toGuest(const std::vector<int32_t>& values){
+    std::vector<uint8_t> bytes;
+    for(int32_t value : values){
+        for(int shift = 24; shift >= 0; shift -= 8){
+            bytes.push_back((uint8_t)((uint32_t)value >> shift));
+        }
+    }
+    return bytes;
+}
+
+static BatchJob sortJob(const std::vector<int32_t>& values){
+    BatchJob job;
+    job.program = "../../test/binary/bubblesort.elf";
+    job.input_address = DATA_ADDRESS;
+    job.input = toGuest(values);
+    job.stop_pc = END_PC;
+    job.max_instructions = 1000000;
+    job.output_address = DATA_ADDRESS;
+    job.output_size = DATA_COUNT * SIZE_LONG;
+    return job;
+}
+
+
+int main(int, char**){
+    TEST_NAME("Batch runner");
+
+    std::vector<BatchJob> jobs;
+    std::vector<std::vector<uint8_t>> expected;
+    for(int32_t i = 0; i < 64; i++){
+        std::vector<int32_t> values(DATA_COUNT);
+        for(uint32_t j = 0; j < DATA_COUNT; j++){
+            values[j] = (int32_t)((j * 7919 + i * 104729) % 1000) - 500;
+        }
+        jobs.push_back(sortJob(values));
+        std::sort(values.begin(), values.end());
+        expected.push_back(toGuest(values));
+    }
+
+    BatchRunner runner(4);
+    TEST_TRUE(runner.threadCount() == 4);
+
+    {
+        TEST_LABEL("sort inputs");
+        std::vector<BatchResult> results = runner.run(jobs);
+        bool all = results.size() == jobs.size();
+        for(size_t i = 0; all && i < results.size(); i++){
+            all = results[i].loaded && results[i].stopped && results[i].error.empty() && results[i].output == expected[i];
+        }
+        TEST_TRUE(all);
+        TEST_TRUE(results[0].registers.get(REG_PC, SIZE_LONG) == END_PC);
+    }
+
+    {
+        TEST_LABEL("reused workers");
+        // the second run restores the loaded program, the last job's input must not leak
+        std::vector<BatchResult> results = runner.run(jobs);
+        bool all = true;
+        for(size_t i = 0; i < results.size(); i++){
+            all = all && results[i].output == expected[i];
+        }
+        TEST_TRUE(all);
+    }
+
+    {
+        TEST_LABEL("instruction limit");
+        std::vector<BatchJob> limited(1, jobs[0]);
+        limited[0].max_instructions = 100;
+        std::vector<BatchResult> results = runner.run(limited);
+        TEST_TRUE(results[0].loaded && !results[0].stopped);
+        TEST_TRUE(results[0].instructions >= 100);
+    }
+
+    {
+        TEST_LABEL("halt without a stop pc");
+        std::vector<BatchJob> idle(2, jobs[2]);
+        idle[0].stop_pc = 0;
+        std::vector<BatchResult> results = runner.run(idle);
+        TEST_TRUE(results[0].halted && !results[0].stopped && results[0].output == expected[2]);
+        TEST_TRUE(results[1].stopped && !results[1].halted); // the snapshot does not keep the halt
+    }
+
+    {
+        TEST_LABEL("missing program");
+        std::vector<BatchJob> mixed(3, jobs[1]);
+        mixed[1].program = "missing.elf";
+        std::vector<BatchResult> results = runner.run(mixed);
+        TEST_FALSE(results[1].loaded);
+        TEST_TRUE(results[0].output == expected[1] && results[2].output == expected[1]);
+    }
+}
@@ -1,7 +1,9 @@
 #include "tests_functions.hpp"
 #include "m68k.hpp"
+#include "memory_bus.hpp"
 
 #include <chrono>
+#include <vector>
 
 using namespace M68K;
 
@@ -13,6 +15,35 @@ double timeInterval(void){
     return dt.count() / 1000.0;
 }
 
+// byte at a time big-endian access, the reference for the memory backends
+static uint32_t readBytes(const uint8_t* addr, DataSize size){
+    uint32_t data = 0;
+    for(int i = 0; i < size; i++){
+        data = (data << 8) | addr[i];
+    }
+    return data;
+}
+
+static void writeBytes(uint8_t* addr, DataSize size, uint32_t data){
+    for(int i = size - 1; i >= 0; i--){
+        addr[i] = (uint8_t)data;
+        data >>= 8;
+    }
+}
+
+// word fetches over 64 KB followed by a long read-modify-write pass, like a copy loop
+template<typename Read, typename Write>
+static uint32_t memoryPass(uint32_t size, Read read, Write write){
+    uint32_t sum = 0;
+    for(uint32_t address = 0; address < size; address += SIZE_WORD){
+        sum += read(address, SIZE_WORD);
+    }
+    for(uint32_t address = 0; address < size; address += SIZE_LONG){
+        write(address, SIZE_LONG, read(address, SIZE_LONG) + sum);
+    }
+    return sum;
+}
+
 int main(int, char**){
     TEST_NAME("Program benchmark");
     
@@ -32,4 +63,79 @@ int main(int, char**){
         std::cout << "Execute " << n << " instructions in " << dtime << " sec." << std::endl;
         std::cout << "Frequency: " << ((double)n/dtime)/1000.0 << " kHz" << std::endl;
     }
+
+    {
+        TEST_LABEL("benchmark block cache");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/benchmark.elf");
+
+        uint64_t n = 0;
+        timeInterval();
+        while(cpu.state.registers.get(REG_PC, SIZE_LONG) != 0x101A4){
+            n += cpu.run(1); // one block per call, 0x101A4 starts a block
+        }
+        double dtime = timeInterval();
+
+        std::cout << "Execute " << n << " instructions in " << dtime << " sec." << std::endl;
+        std::cout << "Frequency: " << ((double)n/dtime)/1000.0 << " kHz" << std::endl;
+    }
+
+    {
+        TEST_LABEL("benchmark run limits");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/benchmark.elf");
+
+        RunLimits limits;
+        limits.breakpoints.push_back(0x101A4);
+        timeInterval();
+        RunResult result = cpu.run(limits);
+        double dtime = timeInterval();
+        TEST_TRUE(result.reason == STOP_BREAKPOINT);
+
+        std::cout << "Execute " << result.instructions << " instructions in " << dtime << " sec." << std::endl;
+        std::cout << "Frequency: " << ((double)result.instructions/dtime)/1000.0 << " kHz" << std::endl;
+    }
+
+    {
+        TEST_LABEL("memory backends");
+        const uint32_t size = 0x10000;
+        const int passes = 2000;
+        std::vector<uint8_t> bytes(size, 0x5A);
+        SimpleMemory memory;
+        MemoryBus bus;
+        bus.mapMemory(0, size, bytes.data());
+        for(uint32_t i = 0; i < size; i++){
+            memory.set(i, SIZE_BYTE, 0x5A);
+        }
+
+        uint32_t check[3] = {0, 0, 0};
+        double times[3];
+        const char* names[3] = {"byte at a time", "SimpleMemory", "MemoryBus"};
+        timeInterval();
+        for(int i = 0; i < passes; i++){
+            check[0] += memoryPass(size,
+                [&](uint32_t a, DataSize sz){ return readBytes(&bytes[a], sz); },
+                [&](uint32_t a, DataSize sz, uint32_t d){ writeBytes(&bytes[a], sz, d); });
+        }
+        times[0] = timeInterval();
+        for(int i = 0; i < passes; i++){
+            check[1] += memoryPass(size,
+                [&](uint32_t a, DataSize sz){ return memory.get(a, sz); },
+                [&](uint32_t a, DataSize sz, uint32_t d){ memory.set(a, sz, d); });
+        }
+        times[1] = timeInterval();
+        std::fill(bytes.begin(), bytes.end(), (uint8_t)0x5A);
+        timeInterval();
+        for(int i = 0; i < passes; i++){
+            check[2] += memoryPass(size,
+                [&](uint32_t a, DataSize sz){ return bus.get(a, sz); },
+                [&](uint32_t a, DataSize sz, uint32_t d){ bus.set(a, sz, d); });
+        }
+        times[2] = timeInterval();
+
+        for(int i = 0; i < 3; i++){
+            std::cout << names[i] << ": " << times[i] << " sec." << std::endl;
+        }
+        TEST_TRUE(check[0] == check[1] && check[1] == check[2]);
+    }
 }
@@ -0,0 +1,286 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <memory>
+
+using namespace M68K;
+
+int main(int, char**){
+    TEST_NAME("CPU run");
+
+    {
+        TEST_LABEL("run equals step");
+        CPU step_cpu = CPU();
+        CPU run_cpu = CPU();
+        load_elf(&step_cpu, "../../test/binary/fibonacci.elf");
+        load_elf(&run_cpu, "../../test/binary/fibonacci.elf");
+
+        uint64_t n = 0;
+        while(n < 5000){
+            n += run_cpu.run(1);
+        }
+        for(uint64_t i = 0; i < n; i++){
+            step_cpu.step();
+        }
+
+        bool equal = true;
+        for(size_t i = 0; i < REGS_COUNT; i++){
+            RegisterType reg = static_cast<RegisterType>(i);
+            equal = equal && (step_cpu.state.registers.get(reg, SIZE_LONG) == run_cpu.state.registers.get(reg, SIZE_LONG));
+        }
+        TEST_TRUE(equal);
+        TEST_TRUE(run_cpu.block_cache.size() > 0);
+    }
+
+    {
+        TEST_LABEL("run bubblesort");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/bubblesort.elf");
+
+        while(cpu.state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+            cpu.run(1);
+        }
+
+        uint32_t data_ptr = 0x3000;
+        uint32_t last_data = 0;
+        bool sorted = true;
+        for(uint32_t i = 0; i < 30u; i++){
+            uint32_t data = cpu.state.memory.get(data_ptr + (uint32_t)(i * SIZE_LONG), SIZE_LONG);
+            sorted = sorted && (last_data <= data);
+            last_data = data;
+        }
+        TEST_TRUE(sorted);
+
+        // loading again starts over, whatever state the CPU was left in
+        cpu.state.halted = true;
+        cpu.state.stopped = true;
+        cpu.state.raiseIRQ(4);
+        cpu.state.raiseException(VECTOR_ZERO_DIVIDE);
+        TEST_TRUE(load_elf(&cpu, "../../test/binary/bubblesort.elf"));
+        TEST_FALSE(cpu.state.halted || cpu.state.stopped);
+        TEST_TRUE(cpu.state.cycles == 0 && cpu.state.requestedIRQs() == 0);
+        TEST_TRUE(cpu.state.pendingException() == VECTOR_NONE);
+        TEST_TRUE(cpu.block_cache.size() == 0);
+        TEST_TRUE(cpu.run(10) >= 10);
+    }
+
+    {
+        TEST_LABEL("run limits");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/bubblesort.elf");
+        RunLimits limits;
+        limits.breakpoints.push_back(0x100c4);
+        RunResult result = cpu.run(limits);
+        TEST_TRUE(result.reason == STOP_BREAKPOINT && cpu.state.registers.get(REG_PC, SIZE_LONG) == 0x100c4);
+        result = cpu.run(limits); // bra * runs once past the breakpoint
+        TEST_TRUE(result.reason == STOP_BREAKPOINT && result.instructions == 1);
+
+        limits.breakpoints.clear();
+        limits.instructions = 10;
+        result = cpu.run(limits);
+        TEST_TRUE(result.reason == STOP_INSTRUCTIONS && result.instructions >= 10);
+
+        cpu.state.halted = true;
+        result = cpu.run(limits);
+        TEST_TRUE(result.reason == STOP_HALT && result.instructions == 0);
+    }
+
+    {
+        TEST_LABEL("breakpoint inside a block");
+        CPU cpu = CPU();
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7001); // moveq #1,%d0
+        cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x7202); // moveq #2,%d1
+        cpu.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x7403); // moveq #3,%d2
+        cpu.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x60F8); // bra $1000
+        cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        RunLimits limits;
+        limits.breakpoints.push_back(0x1004);
+
+        RunResult result = cpu.run(limits); // a new block ends before the breakpoint
+        TEST_TRUE(result.reason == STOP_BREAKPOINT && result.instructions == 2);
+        TEST_TRUE(cpu.state.registers.get(REG_D2, SIZE_LONG) == 0);
+
+        CPU cached = CPU();
+        cached.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7001);
+        cached.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x7202);
+        cached.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x7403);
+        cached.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x60F8);
+        cached.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        cached.run(4);
+        result = cached.run(limits); // the whole block is cached
+        TEST_TRUE(result.reason == STOP_BREAKPOINT && result.instructions == 2);
+        TEST_TRUE(cached.state.registers.get(REG_PC, SIZE_LONG) == 0x1004);
+    }
+
+#if M68K_CYCLES
+    {
+        TEST_LABEL("cycles");
+        CPU cpu = CPU();
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7001); // moveq #1,%d0       4
+        cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x2200); // move.l %d0,%d1     4
+        cpu.state.memory.set(0x1004, DataSize::SIZE_WORD, 0xD481); // add.l %d1,%d2      8
+        cpu.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x60F8); // bra $1000         10
+        cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        RunLimits limits;
+        limits.detect_idle = false;
+        limits.instructions = 4;
+        RunResult result = cpu.run(limits);
+        TEST_TRUE(result.cycles == 26 && cpu.state.cycles == 26);
+
+        limits.instructions = std::numeric_limits<uint64_t>::max();
+        limits.cycles = 100;
+        result = cpu.run(limits); // whole blocks, 26 cycles each
+        TEST_TRUE(result.reason == STOP_CYCLES && result.cycles == 104 && result.instructions == 16);
+
+        CPU step_cpu = CPU();
+        CPU run_cpu = CPU();
+        load_elf(&step_cpu, "../../test/binary/fibonacci.elf");
+        load_elf(&run_cpu, "../../test/binary/fibonacci.elf");
+        uint64_t n = 0;
+        while(n < 5000){
+            n += run_cpu.run(1);
+        }
+        for(uint64_t i = 0; i < n; i++){
+            step_cpu.step();
+        }
+        TEST_TRUE(step_cpu.state.cycles == run_cpu.state.cycles && run_cpu.state.cycles > n * 4);
+    }
+#endif
+
+    {
+        TEST_LABEL("idle loop");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/bubblesort.elf");
+        RunResult result = cpu.run(RunLimits()); // ends in for(;;)
+        TEST_TRUE(result.reason == STOP_IDLE && !cpu.state.halted);
+        TEST_TRUE(cpu.state.registers.get(REG_PC, SIZE_LONG) == 0x100c4);
+
+        CPU poll = CPU();
+        poll.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x4A50); // tst.w (%a0)
+        poll.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x67FC); // beq $1000
+        poll.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x5280); // addq.l #1,%d0
+        poll.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x60FC); // bra $1004
+        poll.state.memory.set(0x2000, DataSize::SIZE_WORD, 0);
+        poll.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        poll.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        result = poll.run(RunLimits());
+        TEST_TRUE(result.reason == STOP_IDLE && poll.state.registers.get(REG_PC, SIZE_LONG) == 0x1000);
+
+        poll.state.memory.set(0x2000, DataSize::SIZE_WORD, 1);
+        RunLimits limits;
+        limits.instructions = 10000;
+        result = poll.run(limits); // counting makes progress
+        TEST_TRUE(result.reason == STOP_INSTRUCTIONS && poll.state.registers.get(REG_D0, SIZE_LONG) > 1000);
+    }
+
+    {
+        TEST_LABEL("invalidate");
+        CPU cpu = CPU();
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7064); // moveq #100,%d0
+        cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x60FC); // bra $1000
+        cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        cpu.run(4);
+        TEST_TRUE(cpu.state.registers.get(REG_D0, SIZE_LONG) == 100);
+
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7065); // moveq #101,%d0
+        cpu.block_cache.invalidate(0x1000, 2);
+        TEST_TRUE(cpu.block_cache.size() == 0);
+        cpu.run(2);
+        TEST_TRUE(cpu.state.registers.get(REG_D0, SIZE_LONG) == 101);
+    }
+
+    {
+        TEST_LABEL("self-modifying code");
+        CPU cpu = CPU();
+        cpu.state.memory.set(0x3000, DataSize::SIZE_WORD, 0x7600); // moveq #0,%d3
+        cpu.state.memory.set(0x3002, DataSize::SIZE_WORD, 0x6000); // bra.w $1000
+        cpu.state.memory.set(0x3004, DataSize::SIZE_WORD, 0xDFFC);
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7001); // moveq #1,%d0
+        cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x3081); // move.w %d1,(%a0)
+        cpu.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x5282); // addq.l #1,%d2
+        cpu.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x60F8); // bra $1000
+        cpu.state.registers.set(REG_D1, SIZE_LONG, 0x7002); // moveq #2,%d0
+        cpu.state.registers.set(REG_A0, SIZE_LONG, 0x1000);
+        cpu.state.registers.set(REG_PC, SIZE_LONG, 0x3000);
+        cpu.run(10000);
+        TEST_TRUE(cpu.state.registers.get(REG_D0, SIZE_LONG) == 2);
+
+        // a host write drops the blocks of its page only
+        cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7003); // moveq #3,%d0
+        cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x4E71); // nop
+        cpu.run(10000);
+        TEST_TRUE(cpu.state.registers.get(REG_D0, SIZE_LONG) == 3);
+        TEST_TRUE(cpu.block_cache.find(0x3000) != nullptr);
+
+        std::unique_ptr<BasicCPU<MemoryBus>> bus_cpu(new BasicCPU<MemoryBus>());
+        bus_cpu->memory.mapRam(0, 0x10000);
+        const uint8_t loop[] = {0x70, 0x01, 0x52, 0x82, 0x60, 0xFA}; // moveq #1,%d0; addq.l #1,%d2; bra $1000
+        bus_cpu->memory.write_block(0x1000, loop, sizeof(loop));
+        bus_cpu->state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        bus_cpu->run(10000);
+        const uint8_t patch[] = {0x70, 0x04}; // moveq #4,%d0
+        bus_cpu->memory.write_block(0x1000, patch, sizeof(patch));
+        bus_cpu->run(10000);
+        TEST_TRUE(bus_cpu->state.registers.get(REG_D0, SIZE_LONG) == 4);
+    }
+
+    {
+        TEST_LABEL("clone");
+        std::unique_ptr<BasicCPU<MemoryBus>> parent(new BasicCPU<MemoryBus>());
+        parent->memory.mapRam(0, (uint32_t)MEMORY_SIZE);
+        load_elf(parent.get(), "../../test/binary/bubblesort.elf");
+        parent->run(100);
+
+        parent->state.raiseIRQ(2, 0x40);
+        std::unique_ptr<BasicCPU<MemoryBus>> child = parent->clone();
+        TEST_TRUE(child->state.registers.get(REG_PC, SIZE_LONG) == parent->state.registers.get(REG_PC, SIZE_LONG));
+        TEST_TRUE(child->state.cycles == parent->state.cycles);
+        TEST_TRUE(child->state.requestedIRQs() == (1 << 2) && child->state.irqVector(2) == 0x40);
+        child->state.clearIRQ(2);
+        parent->state.clearIRQ(2);
+
+        parent->state.stopped = true;
+        parent->state.halted = true;
+        std::unique_ptr<BasicCPU<MemoryBus>> idle = parent->clone();
+        TEST_TRUE(idle->state.stopped && idle->state.halted);
+        parent->state.stopped = false;
+        parent->state.halted = false;
+
+        // the child sorts its copy of the data, the parent's stays as it was
+        uint32_t first = parent->state.memory.get(0x3000, SIZE_LONG);
+        while(child->state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+            child->run(1);
+        }
+        bool sorted = true;
+        for(uint32_t i = 1; i < 30u; i++){
+            uint32_t address = 0x3000 + i * SIZE_LONG;
+            sorted = sorted && (child->state.memory.get(address - SIZE_LONG, SIZE_LONG) <= child->state.memory.get(address, SIZE_LONG));
+        }
+        TEST_TRUE(sorted);
+        TEST_TRUE(parent->state.memory.get(0x3000, SIZE_LONG) == first);
+
+        parent->state.memory.set(0x3000, SIZE_LONG, 0xFFFFFFFF);
+        TEST_TRUE(child->state.memory.get(0x3000, SIZE_LONG) != 0xFFFFFFFF);
+    }
+
+    {
+        TEST_LABEL("snapshot restore");
+        CPU cpu = CPU();
+        load_elf(&cpu, "../../test/binary/bubblesort.elf");
+        cpu.run(100);
+        CPUSnapshot start = cpu.snapshot();
+        uint32_t first = cpu.state.memory.get(0x3000, SIZE_LONG);
+        uint32_t pc = cpu.state.registers.get(REG_PC, SIZE_LONG);
+
+        for(int i = 0; i < 3; i++){
+            while(cpu.state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+                cpu.run(1);
+            }
+            TEST_TRUE(cpu.memory.dirtyPages().size() <= 2); // the data and the stack
+            cpu.restore(start);
+            TEST_TRUE(cpu.state.registers.get(REG_PC, SIZE_LONG) == pc);
+            TEST_TRUE(cpu.state.memory.get(0x3000, SIZE_LONG) == first);
+            TEST_TRUE(cpu.memory.dirtyPages().empty());
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include "tests_functions.hpp"
 #include "m68k.hpp"
 
+#include <memory>
+#include <vector>
+
 using namespace M68K;
 
 int main(int, char**){
@@ -32,4 +35,105 @@ int main(int, char**){
         return_data = cpu.state.registers.get(REG_D1, DataSize::SIZE_LONG);
         TEST_TRUE(return_data == 200);
     }
+    {
+        TEST_LABEL("shared decoder");
+        CPU other = CPU();
+        TEST_TRUE(&other.instruction_decoder == &cpu.instruction_decoder);
+        TEST_TRUE(other.instruction_decoder.Decode(0xD280) == cpu.instruction_decoder.Decode(0xD280));
+
+        // the second CPU runs on the same decoded instructions with its own state
+        other.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7005); // moveq #5,%d0
+        other.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        other.step();
+        TEST_TRUE(other.state.registers.get(REG_D0, DataSize::SIZE_LONG) == 5);
+        TEST_TRUE(cpu.state.registers.get(REG_D0, DataSize::SIZE_LONG) == 100);
+    }
+    {
+        TEST_LABEL("specialized addressing forms");
+        // 0:   2018            movel %a0@+,%d0
+        // 2:   d240            addw %d0,%d1
+        // 4:   5321            subqb #1,%a1@-
+        // 6:   4a99            tstl %a1@+
+        CPU other = CPU();
+        other.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x2018);
+        other.state.memory.set(0x1002, DataSize::SIZE_WORD, 0xD240);
+        other.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x5321);
+        other.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x4A99);
+        other.state.memory.set(0x2000, DataSize::SIZE_LONG, 0x1234FFFF);
+        other.state.memory.set(0x3000, DataSize::SIZE_LONG, 0x01000000);
+        other.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        other.state.registers.set(REG_A1, SIZE_LONG, 0x3001);
+        other.state.registers.set(REG_D1, SIZE_LONG, 0xAAAA0001);
+        other.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+
+        other.step();
+        TEST_TRUE(other.state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0x1234FFFF);
+        TEST_TRUE(other.state.registers.get(REG_A0, DataSize::SIZE_LONG) == 0x2004);
+
+        other.step();
+        TEST_TRUE(other.state.registers.get(REG_D1, DataSize::SIZE_LONG) == 0xAAAA0000);
+        TEST_TRUE(other.state.registers.get(SR_FLAG_ZERO) && other.state.registers.get(SR_FLAG_CARRY));
+
+        other.step();
+        TEST_TRUE(other.state.memory.get(0x3000, DataSize::SIZE_BYTE) == 0x00);
+        TEST_TRUE(other.state.registers.get(REG_A1, DataSize::SIZE_LONG) == 0x3000);
+
+        other.step();
+        TEST_TRUE(other.state.registers.get(SR_FLAG_ZERO));
+        TEST_TRUE(other.state.registers.get(REG_A1, DataSize::SIZE_LONG) == 0x3004);
+        TEST_TRUE(other.state.registers.get(REG_PC, DataSize::SIZE_LONG) == 0x1008);
+    }
+    {
+        TEST_LABEL("read-modify-write with extension words");
+        // 0:   0668 0001 0010  addiw #1,%a0@(16)
+        // 6:   44b8 4000       negl 0x4000
+        CPU other = CPU();
+        other.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x0668);
+        other.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x0001);
+        other.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x0010);
+        other.state.memory.set(0x1006, DataSize::SIZE_WORD, 0x44B8);
+        other.state.memory.set(0x1008, DataSize::SIZE_WORD, 0x4000);
+        other.state.memory.set(0x2010, DataSize::SIZE_WORD, 0x7FFF);
+        other.state.memory.set(0x4000, DataSize::SIZE_LONG, 1);
+        other.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        other.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+
+        other.step();
+        TEST_TRUE(other.state.memory.get(0x2010, DataSize::SIZE_WORD) == 0x8000);
+        TEST_TRUE(other.state.registers.get(SR_FLAG_OVERFLOW) && other.state.registers.get(SR_FLAG_NEGATIVE));
+        TEST_TRUE(other.state.registers.get(REG_PC, DataSize::SIZE_LONG) == 0x1006);
+
+        other.step();
+        TEST_TRUE(other.state.memory.get(0x4000, DataSize::SIZE_LONG) == 0xFFFFFFFF);
+        TEST_TRUE(other.state.registers.get(REG_PC, DataSize::SIZE_LONG) == 0x100A);
+    }
+    {
+        TEST_LABEL("memory policies");
+        // 0x1000: addq.l #1,(a0)
+        SimpleMemory shared_memory;
+        BasicCPU<IMemory> virtual_cpu(shared_memory);
+        virtual_cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x5290);
+        virtual_cpu.state.memory.set(0x2000, DataSize::SIZE_LONG, 41);
+        virtual_cpu.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        virtual_cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        virtual_cpu.step();
+        TEST_TRUE(shared_memory.get(0x2000, DataSize::SIZE_LONG) == 42);
+
+        std::vector<uint8_t> ram(0x4000, 0);
+        std::unique_ptr<BasicCPU<MemoryBus>> bus_cpu(new BasicCPU<MemoryBus>());
+        bus_cpu->memory.mapMemory(0, (uint32_t)ram.size(), ram.data());
+        bus_cpu->state.memory.set(0x1000, DataSize::SIZE_WORD, 0x5290);
+        bus_cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        bus_cpu->state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        bus_cpu->step();
+        TEST_TRUE(ram[0x2003] == 1);
+        // an unmapped page is a bus error, not an exception of the host
+        bus_cpu->state.memory.set(VECTOR_BUS_ERROR * SIZE_LONG, DataSize::SIZE_LONG, 0x3000);
+        bus_cpu->state.registers.set(REG_SSP, SIZE_LONG, 0x4000);
+        bus_cpu->state.registers.set(REG_A0, SIZE_LONG, 0x8000);
+        bus_cpu->state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        TEST_NO_THROW({ bus_cpu->step(); });
+        TEST_TRUE(bus_cpu->state.registers.pc == 0x3000);
+        TEST_TRUE(bus_cpu->state.memory.get(0x4000 - 14 + 2, DataSize::SIZE_LONG) == 0x8000);
+    }
 }
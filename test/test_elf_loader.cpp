@@ -0,0 +1,56 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+using namespace M68K;
+
+static const ElfSymbol* findSymbol(const ElfImage& image, const std::string& name){
+    for(const ElfSymbol& symbol : image.symbols){
+        if(symbol.name == name){
+            return &symbol;
+        }
+    }
+    return nullptr;
+}
+
+int main(int, char**){
+    TEST_NAME("ELF loader");
+
+    {
+        TEST_LABEL("segments");
+        SimpleMemory memory;
+        memory.fill(0x4000, 0xFF, 0x10);
+        ElfImage image;
+        TEST_TRUE(load_elf_image(memory, "../../test/binary/fibonacci.elf", image));
+        TEST_TRUE(image.entry == 0x10044);
+        TEST_TRUE(image.segments.size() == 2);
+        TEST_TRUE(image.segments[0].address == 0x2000 && image.segments[0].memory_size == 0x2004);
+        TEST_TRUE(image.segments[1].address == 0x10000 && image.segments[1].file_size == 0x5A);
+
+        TEST_LABEL("bss is zeroed");
+        TEST_TRUE(memory.get(0x4000, SIZE_LONG) == 0);
+
+        TEST_LABEL("code");
+        uint8_t code[0x5A];
+        memory.read_block(0x10000, code, sizeof(code));
+        TEST_TRUE(memory.get(0x10000, SIZE_WORD) == (uint32_t)(code[0] << 8 | code[1]));
+    }
+
+    {
+        TEST_LABEL("symbols");
+        SimpleMemory memory;
+        ElfImage image;
+        load_elf_image(memory, "../../test/binary/fibonacci.elf", image);
+        const ElfSymbol* main_symbol = findSymbol(image, "main");
+        const ElfSymbol* result = findSymbol(image, "result");
+        TEST_TRUE(main_symbol && main_symbol->address == 0x10044 && main_symbol->size == 22);
+        TEST_TRUE(result && result->address == 0x4000 && result->size == 4);
+    }
+
+    {
+        TEST_LABEL("not an executable");
+        SimpleMemory memory;
+        ElfImage image;
+        TEST_FALSE(load_elf_image(memory, "../../test/binary/missing.elf", image));
+        TEST_FALSE(load_elf_image(memory, "../../test/CMakeLists.txt", image));
+    }
+}
@@ -0,0 +1,479 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+using namespace M68K;
+
+static const uint32_t CODE = 0x1000;
+static const uint32_t HANDLERS = 0x3000;  // handler of vector n at HANDLERS + n * 0x10
+static const uint32_t STACK = 0x8000;
+
+static std::unique_ptr<CPU> makeCPU(const uint16_t* program, std::size_t count){
+    std::unique_ptr<CPU> cpu(new CPU());
+    cpu->memory.fill(0, 0, 0x10000);
+    for(uint32_t vector = 2; vector < 48; vector++){
+        cpu->memory.set(vector * SIZE_LONG, SIZE_LONG, HANDLERS + vector * 0x10);
+        cpu->memory.set(HANDLERS + vector * 0x10, SIZE_WORD, 0x60FE); // bra.s *
+    }
+    for(uint32_t i = 0; i < count; i++){
+        cpu->memory.set(CODE + i * SIZE_WORD, SIZE_WORD, program[i]);
+    }
+    cpu->state.registers.set(REG_SSP, SIZE_LONG, STACK);
+    cpu->state.registers.set(REG_PC, SIZE_LONG, CODE);
+    return cpu;
+}
+
+// a device that refuses every access
+class FailingDevice final : public IMemory {
+public:
+    virtual uint32_t get(std::size_t, DataSize) override {
+        throw std::runtime_error("device failure");
+    }
+    virtual void set(std::size_t, DataSize, uint32_t) override {
+        throw std::runtime_error("device failure");
+    }
+};
+
+static uint32_t stackWord(CPU& cpu, uint32_t offset){
+    return cpu.memory.get(cpu.state.registers.ssp + offset, SIZE_WORD);
+}
+
+static uint32_t stackLong(CPU& cpu, uint32_t offset){
+    return cpu.memory.get(cpu.state.registers.ssp + offset, SIZE_LONG);
+}
+
+
+int main(int, char**){
+    TEST_NAME("Exceptions");
+
+    {
+        TEST_LABEL("address error");
+        const uint16_t program[] = {0x3010}; // move.w (a0),d0
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2001);
+        TEST_NO_THROW({ cpu->step(); });
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_ADDRESS_ERROR * 0x10);
+        TEST_TRUE(cpu->state.registers.sr.supervisor);
+        TEST_TRUE(cpu->state.registers.ssp == STACK - 14);
+        TEST_TRUE(stackWord(*cpu, 0) == 0x11); // read, user data
+        TEST_TRUE(stackLong(*cpu, 2) == 0x2001);
+        TEST_TRUE(stackWord(*cpu, 6) == 0x3010);
+        TEST_TRUE((stackWord(*cpu, 8) & 0x2000) == 0); // SR of user mode
+        TEST_TRUE(stackLong(*cpu, 10) == CODE + 2);
+    }
+
+    {
+        TEST_LABEL("address error on write");
+        const uint16_t program[] = {0x2080, 0x7201}; // move.l d0,(a0); moveq #1,d1
+        std::unique_ptr<CPU> cpu = makeCPU(program, 2);
+        cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2003);
+        cpu->memory.set(0x2002, SIZE_LONG, 0);
+        cpu->state.registers.set(REG_D0, SIZE_LONG, 0x12345678);
+        RunLimits limits;
+        limits.instructions = 2;
+        cpu->run(limits);
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_ADDRESS_ERROR * 0x10);
+        TEST_TRUE(stackWord(*cpu, 0) == 0x01); // write, user data
+        TEST_TRUE(stackLong(*cpu, 2) == 0x2003);
+        TEST_TRUE(cpu->memory.get(0x2002, SIZE_LONG) == 0);
+        TEST_TRUE(cpu->state.registers.d1 == 0);
+    }
+
+    {
+        TEST_LABEL("a fault aborts the instruction");
+        const uint16_t program[] = {0x3018, 0x32D8}; // move.w (a0)+,d0; move.w (a0)+,(a1)+
+        for(int use_run = 0; use_run < 2; use_run++){
+            std::unique_ptr<CPU> cpu = makeCPU(program, 2);
+            cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2001);
+            cpu->state.registers.set(REG_D0, SIZE_LONG, 0x5555);
+            cpu->state.registers.set(REG_SR, SIZE_WORD, 0x0004); // Z
+            if(use_run)
+                cpu->run(1);
+            else
+                cpu->step();
+            TEST_TRUE(cpu->state.registers.a0 == 0x2001 && cpu->state.registers.d0 == 0x5555);
+            TEST_TRUE(stackWord(*cpu, 8) == 0x0004);
+
+            cpu = makeCPU(program, 2);
+            cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 2);
+            cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+            cpu->state.registers.set(REG_A1, SIZE_LONG, 0x2101);
+            cpu->memory.set(0x2000, SIZE_WORD, 0x8000);
+            if(use_run)
+                cpu->run(1);
+            else
+                cpu->step();
+            TEST_TRUE(cpu->state.registers.a0 == 0x2000 && cpu->state.registers.a1 == 0x2101);
+            TEST_TRUE(stackWord(*cpu, 8) == 0); // N of the move undone
+            TEST_TRUE(stackLong(*cpu, 2) == 0x2101);
+        }
+    }
+
+    {
+        TEST_LABEL("a fault in a hot block");
+        // move.w (a0)+,(a1)+ until a1 leaves the RAM, compiled to native code after two passes
+        std::unique_ptr<BasicCPU<MemoryBus>> cpus[2];
+        for(int i = 0; i < 2; i++){
+            cpus[i].reset(new BasicCPU<MemoryBus>());
+            BasicCPU<MemoryBus>& cpu = *cpus[i];
+            cpu.memory.mapRam(0, 0x10000);
+            cpu.memory.set(VECTOR_BUS_ERROR * SIZE_LONG, SIZE_LONG, HANDLERS);
+            cpu.memory.set(HANDLERS, SIZE_WORD, 0x60FE); // bra.s *
+            cpu.memory.set(CODE, SIZE_WORD, 0x32D8);     // move.w (a0)+,(a1)+
+            cpu.memory.set(CODE + 2, SIZE_WORD, 0x60FC); // bra.s CODE
+            cpu.memory.set(0x2000 + 2 * 49, SIZE_WORD, 0xFFFF);
+            cpu.state.registers.set(REG_SSP, SIZE_LONG, STACK);
+            cpu.state.registers.set(REG_PC, SIZE_LONG, CODE);
+            cpu.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+            cpu.state.registers.set(REG_A1, SIZE_LONG, 0x10000 - 2 * 50);
+#if M68K_JIT
+            cpu.jit.threshold = 2;
+#endif
+        }
+        while(cpus[0]->state.registers.pc != HANDLERS){
+            cpus[0]->step();
+        }
+        RunLimits limits;
+        limits.instructions = 200;
+        cpus[1]->run(limits);
+
+        bool equal = true;
+        for(size_t i = 0; i < REGS_COUNT; i++){
+            RegisterType reg = static_cast<RegisterType>(i);
+            equal = equal && (cpus[0]->state.registers.get(reg, SIZE_LONG) == cpus[1]->state.registers.get(reg, SIZE_LONG));
+        }
+        TEST_TRUE(equal);
+        TEST_TRUE(cpus[1]->state.registers.a0 == 0x2000 + 2 * 50 && cpus[1]->state.registers.a1 == 0x10000);
+        for(uint32_t offset = 0; offset < 14; offset += SIZE_WORD){
+            equal = equal && (cpus[0]->memory.get(STACK - 14 + offset, SIZE_WORD) == cpus[1]->memory.get(STACK - 14 + offset, SIZE_WORD));
+        }
+        TEST_TRUE(equal);
+        TEST_TRUE((cpus[1]->memory.get(STACK - 6, SIZE_WORD) & 0xC) == 0x8); // N of the 50th move, not Z of the faulting one
+    }
+
+    {
+        TEST_LABEL("the next instruction after a fault");
+        // the way a single instruction test runs them, without step()
+        const uint16_t program[] = {0x3010, 0x3280}; // move.w (a0),d0; move.w d0,(a1)
+        std::unique_ptr<CPU> cpu = makeCPU(program, 2);
+        const InstructionDecoder& decoder = InstructionDecoder::shared();
+        cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2001);
+        cpu->state.registers.set(REG_A1, SIZE_LONG, 0x2000);
+        decoder.Decode(program[0])->execute(cpu->state);
+        TEST_TRUE(cpu->state.pendingException() == VECTOR_ADDRESS_ERROR);
+        cpu->state.processException(CODE);
+        TEST_TRUE(cpu->state.pendingException() == VECTOR_NONE);
+
+        cpu->state.registers.set(REG_D0, SIZE_LONG, 0x1234);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 2);
+        decoder.Decode(program[1])->execute(cpu->state);
+        TEST_TRUE(cpu->state.pendingException() == VECTOR_NONE);
+        TEST_TRUE(cpu->memory.get(0x2000, SIZE_WORD) == 0x1234);
+    }
+
+    {
+        TEST_LABEL("fetch from an odd address");
+        std::unique_ptr<CPU> cpu = makeCPU(nullptr, 0);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 1);
+        cpu->run(1);
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_ADDRESS_ERROR * 0x10);
+        TEST_TRUE(stackWord(*cpu, 0) == 0x12); // read, user program
+        TEST_TRUE(stackLong(*cpu, 2) == CODE + 1);
+    }
+
+    {
+        TEST_LABEL("illegal instruction");
+        const uint16_t program[] = {0x4AFC, 0xA123, 0xF000};
+        std::unique_ptr<CPU> cpu = makeCPU(program, 3);
+        cpu->state.registers.set(SR_FLAG_CARRY, true);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_ILLEGAL_INSTRUCTION * 0x10);
+        TEST_TRUE(cpu->state.registers.ssp == STACK - 6);
+        TEST_TRUE(stackWord(*cpu, 0) == 0x0001);
+        TEST_TRUE(stackLong(*cpu, 2) == CODE);
+        TEST_TRUE(cpu->state.registers.get(REG_SR, SIZE_WORD) == 0x2001);
+
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 2);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_LINE_A * 0x10);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 4);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_LINE_F * 0x10);
+    }
+
+    {
+        TEST_LABEL("line A and F instances");
+        // the vector follows the decoded instance, not the word at the PC
+        const uint16_t program[] = {0x4E71}; // nop
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        const InstructionDecoder& decoder = InstructionDecoder::shared();
+        TEST_TRUE(decoder.Decode(0xA123)->getOpcode() >> 12 == 0xA);
+        TEST_TRUE(decoder.Decode(0xFFFF)->getOpcode() >> 12 == 0xF);
+        TEST_TRUE(decoder.Decode(0x4E7B) == decoder.Decode(0x4E7C));
+        TEST_FALSE(decoder.isValid(0xA123));
+        TEST_TRUE(decoder.isValid(0x4E71));
+        TEST_TRUE(std::string(decoder.handlerName(0x4E7B)) == "Illegal");
+        TEST_TRUE(std::string(decoder.handlerName(0xA123)) == "LineA");
+        TEST_TRUE(std::string(decoder.handlerName(0xF000)) == "LineF");
+
+        decoder.Decode(0xA123)->execute(cpu->state);
+        TEST_TRUE(cpu->state.pendingException() == VECTOR_LINE_A);
+        cpu->state.processException(CODE);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE);
+        decoder.Decode(0xF000)->execute(cpu->state);
+        TEST_TRUE(cpu->state.pendingException() == VECTOR_LINE_F);
+    }
+
+    {
+        TEST_LABEL("zero divide");
+        const uint16_t program[] = {0x80C1}; // divu d1,d0
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        cpu->state.registers.set(REG_D0, SIZE_LONG, 100);
+        cpu->state.registers.set(REG_D1, SIZE_LONG, 0);
+        TEST_NO_THROW({ cpu->step(); });
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_ZERO_DIVIDE * 0x10);
+        TEST_TRUE(stackLong(*cpu, 2) == CODE + 2);
+        TEST_TRUE(cpu->state.registers.d0 == 100);
+    }
+
+    {
+        TEST_LABEL("trap and rte");
+        const uint16_t program[] = {
+            0x7000, // loop: moveq #0,d0
+            0x4E42, // trap #2
+            0x5281, // addq.l #1,d1
+            0xB2BC, 0x0000, 0x0064, // cmp.l #100,d1
+            0x66F2, // bne.s loop
+            0x60FE, // bra.s *
+        };
+        std::unique_ptr<CPU> cpu = makeCPU(program, sizeof(program) / sizeof(program[0]));
+        const uint16_t handler[] = {
+            0x5282, // addq.l #1,d2
+            0x7007, // moveq #7,d0
+            0x4E73, // rte
+        };
+        for(uint32_t i = 0; i < 3; i++){
+            cpu->memory.set(HANDLERS + (VECTOR_TRAP_0 + 2) * 0x10 + i * SIZE_WORD, SIZE_WORD, handler[i]);
+        }
+        RunLimits limits;
+        limits.breakpoints.push_back(CODE + 14);
+        RunResult result = cpu->run(limits);
+        TEST_TRUE(result.reason == STOP_BREAKPOINT);
+        TEST_TRUE(cpu->state.registers.d0 == 7);
+        TEST_TRUE(cpu->state.registers.d1 == 100);
+        TEST_TRUE(cpu->state.registers.d2 == 100);
+        TEST_FALSE(cpu->state.registers.sr.supervisor);
+        TEST_TRUE(cpu->state.registers.ssp == STACK);
+    }
+
+    {
+        TEST_LABEL("bus error on a memory bus");
+        const uint16_t program[] = {
+            0x2080, // move.l d0,(a0)
+            0x2211, // move.l (a1),d1
+        };
+        FailingDevice device;
+        std::unique_ptr<BasicCPU<MemoryBus>> cpu(new BasicCPU<MemoryBus>());
+        cpu->memory.mapRam(0, 0x10000);
+        cpu->memory.mapDevice(0x20000, MemoryBus::PAGE_SIZE, &device);
+        cpu->memory.set(VECTOR_BUS_ERROR * SIZE_LONG, SIZE_LONG, HANDLERS);
+        cpu->memory.set(HANDLERS, SIZE_WORD, 0x4E73); // rte
+        for(uint32_t i = 0; i < 2; i++){
+            cpu->memory.set(CODE + i * SIZE_WORD, SIZE_WORD, program[i]);
+        }
+        cpu->state.registers.set(REG_SSP, SIZE_LONG, STACK);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE);
+        cpu->state.registers.set(REG_A0, SIZE_LONG, 0xFFFE); // the second word is unmapped
+        cpu->state.registers.set(REG_A1, SIZE_LONG, 0x20000);
+        TEST_NO_THROW({ cpu->step(); });
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS);
+        TEST_TRUE(cpu->memory.get(STACK - 14, SIZE_WORD) == 0x01); // write, user data
+        TEST_TRUE(cpu->memory.get(STACK - 12, SIZE_LONG) == 0xFFFE);
+        TEST_TRUE(cpu->memory.get(0xFFFE, SIZE_WORD) == 0); // the mapped half is not written either
+
+        cpu->state.registers.set(REG_SSP, SIZE_LONG, STACK);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, CODE + 2);
+        TEST_NO_THROW({ cpu->step(); });
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS);
+        TEST_TRUE(cpu->memory.get(STACK - 12, SIZE_LONG) == 0x20000);
+    }
+
+    {
+        TEST_LABEL("rte in user mode");
+        const uint16_t program[] = {0x4E73};
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_PRIVILEGE_VIOLATION * 0x10);
+        TEST_TRUE(stackLong(*cpu, 2) == CODE);
+    }
+
+    {
+        TEST_LABEL("double fault halts");
+        const uint16_t program[] = {0x4AFC};
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        cpu->state.registers.set(REG_SSP, SIZE_LONG, STACK + 1);
+        RunResult result = cpu->run(RunLimits());
+        TEST_TRUE(result.reason == STOP_HALT);
+        TEST_TRUE(cpu->state.halted);
+
+        // step() does nothing either, interrupts included, until the host clears halted
+        uint32_t pc = cpu->state.registers.pc;
+        cpu->state.registers.set(REG_SSP, SIZE_LONG, STACK);
+        cpu->state.raiseIRQ(7);
+        cpu->step();
+        TEST_TRUE(cpu->state.halted && cpu->state.registers.pc == pc && cpu->state.attention());
+        TEST_TRUE(cpu->run(RunLimits()).reason == STOP_HALT);
+        cpu->state.halted = false;
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 7) * 0x10);
+    }
+
+    {
+        TEST_LABEL("stop waits for an interrupt");
+        const uint16_t program[] = {0x4E72, 0x2300, 0x7201}; // stop #$2300; moveq #1,d1
+        std::unique_ptr<CPU> cpu = makeCPU(program, 3);
+        cpu->state.registers.set(REG_SR, SIZE_WORD, 0x2700);
+        RunResult result = cpu->run(RunLimits());
+        TEST_TRUE(result.reason == STOP_IDLE && result.instructions == 1);
+        TEST_TRUE(cpu->state.stopped && !cpu->state.halted);
+        TEST_TRUE(cpu->state.registers.pc == CODE + 4 && cpu->state.registers.get(REG_SR, SIZE_WORD) == 0x2300);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == CODE + 4 && cpu->state.registers.d1 == 0);
+
+        cpu->state.raiseIRQ(2); // masked, the CPU keeps waiting
+        TEST_TRUE(cpu->run(RunLimits()).reason == STOP_IDLE && cpu->state.stopped);
+        cpu->state.raiseIRQ(4);
+        cpu->step();
+        TEST_FALSE(cpu->state.stopped);
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 4) * 0x10);
+        TEST_TRUE(stackLong(*cpu, 2) == CODE + 4);
+
+        cpu = makeCPU(program, 3); // user mode
+        cpu->step();
+        TEST_FALSE(cpu->state.stopped);
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + VECTOR_PRIVILEGE_VIOLATION * 0x10);
+    }
+
+    {
+        TEST_LABEL("interrupt mask and autovector");
+        const uint16_t program[] = {
+            0x7001, // moveq #1,d0
+            0x60FC, // bra.s -4
+        };
+        std::unique_ptr<CPU> cpu = makeCPU(program, 2);
+        cpu->state.registers.sr.interrupt_mask = 3;
+        cpu->state.raiseIRQ(2);
+        RunLimits limits;
+        limits.instructions = 10;
+        limits.detect_idle = false;
+        cpu->run(limits);
+        TEST_TRUE(cpu->state.attention() && !cpu->state.registers.sr.supervisor); // masked
+
+        cpu->state.raiseIRQ(5);
+        cpu->run(limits);
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 5) * 0x10);
+        TEST_TRUE(cpu->state.registers.sr.supervisor && cpu->state.registers.sr.interrupt_mask == 5);
+        TEST_TRUE((stackWord(*cpu, 0) & 0x2700) == 0x0300);
+        TEST_TRUE(stackLong(*cpu, 2) == CODE || stackLong(*cpu, 2) == CODE + 2);
+        TEST_TRUE(cpu->state.attention()); // level 2 waits for the mask
+
+        cpu->state.clearIRQ(2);
+        TEST_FALSE(cpu->state.attention());
+    }
+
+    {
+        TEST_LABEL("vectored and non-maskable interrupts");
+        const uint16_t program[] = {0x60FE}; // bra.s *
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        cpu->memory.set(70 * SIZE_LONG, SIZE_LONG, HANDLERS);
+        cpu->memory.set(HANDLERS, SIZE_WORD, 0x60FE);
+        cpu->state.raiseIRQ(4, 70);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS && cpu->state.registers.ssp == STACK - 6);
+
+        cpu->state.registers.sr.interrupt_mask = 7;
+        cpu->state.raiseIRQ(6);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS);
+        cpu->state.raiseIRQ(7);
+        cpu->step();
+        TEST_TRUE(cpu->state.registers.pc == HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 7) * 0x10);
+        TEST_THROW(std::out_of_range, {cpu->state.raiseIRQ(8);});
+    }
+
+    {
+        TEST_LABEL("rte unmasks lower levels");
+        const uint16_t program[] = {0x60FE}; // bra.s *
+        std::unique_ptr<CPU> cpu = makeCPU(program, 1);
+        const uint16_t level5[] = {0x5281, 0x4E73}; // addq.l #1,d1; rte
+        const uint16_t level2[] = {0x2601, 0x4E73}; // move.l d1,d3; rte
+        for(uint32_t i = 0; i < 2; i++){
+            cpu->memory.set(HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 5) * 0x10 + i * SIZE_WORD, SIZE_WORD, level5[i]);
+            cpu->memory.set(HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 2) * 0x10 + i * SIZE_WORD, SIZE_WORD, level2[i]);
+        }
+        cpu->state.raiseIRQ(2);
+        cpu->state.raiseIRQ(5);
+        RunResult result = cpu->run(RunLimits());
+        TEST_TRUE(result.reason == STOP_IDLE && cpu->state.registers.pc == CODE);
+        TEST_TRUE(cpu->state.registers.d1 == 1 && cpu->state.registers.d3 == 1);
+        TEST_TRUE(cpu->state.registers.ssp == STACK && !cpu->state.attention());
+    }
+
+#if M68K_CYCLES
+    {
+        TEST_LABEL("timer interrupt");
+        const uint16_t program[] = {0x60FE}; // bra.s *
+        const uint16_t handler[] = {0x5281, 0x4E73}; // addq.l #1,d1; rte
+        std::unique_ptr<CPU> cpus[2];
+        std::function<void(uint64_t)> ticks[2];
+        RunResult results[2];
+        for(int i = 0; i < 2; i++){
+            cpus[i] = makeCPU(program, 1);
+            CPU& cpu = *cpus[i];
+            for(uint32_t j = 0; j < 2; j++){
+                cpu.memory.set(HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 1) * 0x10 + j * SIZE_WORD, SIZE_WORD, handler[j]);
+            }
+            std::function<void(uint64_t)>& tick = ticks[i];
+            tick = [&cpu, &tick](uint64_t now){
+                cpu.state.raiseIRQ(1);
+                cpu.scheduler.schedule(now - now % 1000 + 1000, tick);
+            };
+            cpu.scheduler.schedule(1000, tick);
+            RunLimits limits;
+            limits.cycles = 10000;
+            limits.detect_idle = i == 0;
+            results[i] = cpu.run(limits);
+        }
+        // the tenth interrupt is taken, its handler has not run yet
+        TEST_TRUE(results[0].reason == STOP_CYCLES && cpus[0]->state.registers.d1 == 9);
+        TEST_TRUE(cpus[0]->state.registers.pc == HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 1) * 0x10);
+        // the iterations of bra.s skipped by the idle loop count as executed
+        TEST_TRUE(results[0].instructions == results[1].instructions && results[0].cycles == results[1].cycles);
+    }
+
+    {
+        TEST_LABEL("stop until a timer interrupt");
+        const uint16_t program[] = {0x4E72, 0x2000, 0x60FA}; // stop #$2000; bra.s CODE
+        const uint16_t handler[] = {0x5281, 0x4E73}; // addq.l #1,d1; rte
+        std::unique_ptr<CPU> cpu = makeCPU(program, 3);
+        CPU& cpu_ref = *cpu;
+        for(uint32_t j = 0; j < 2; j++){
+            cpu->memory.set(HANDLERS + (VECTOR_SPURIOUS_INTERRUPT + 1) * 0x10 + j * SIZE_WORD, SIZE_WORD, handler[j]);
+        }
+        std::function<void(uint64_t)> tick = [&cpu_ref, &tick](uint64_t now){
+            cpu_ref.state.raiseIRQ(1);
+            cpu_ref.scheduler.schedule(now + 1000, tick);
+        };
+        cpu->scheduler.schedule(1000, tick);
+        cpu->state.registers.set(REG_SR, SIZE_WORD, 0x2000);
+        RunLimits limits;
+        limits.cycles = 10500;
+        RunResult result = cpu->run(limits);
+        TEST_TRUE(result.reason == STOP_CYCLES && result.cycles == 10500);
+        TEST_TRUE(cpu->state.stopped && cpu->state.registers.d1 == 10);
+    }
+#endif
+}
@@ -0,0 +1,79 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+using namespace M68K;
+
+static const uint32_t CCR_MASK = SR_FLAG_EXTEND | SR_FLAG_NEGATIVE | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY;
+
+int main(int, char**){
+    TEST_NAME("Condition codes");
+
+    {
+        TEST_LABEL("add sets all flags");
+        Registers registers;
+        registers.setFlags(FLAGS_ADD, SIZE_BYTE, 0x80, 0x80); // 0x80 + 0x80 = 0x100
+        TEST_TRUE(registers.get(REG_SR, SIZE_WORD) == (SR_FLAG_EXTEND | SR_FLAG_ZERO | SR_FLAG_OVERFLOW | SR_FLAG_CARRY));
+
+        registers.setFlags(FLAGS_ADD, SIZE_WORD, 0x0001, 0x7FFF);
+        TEST_TRUE(registers.get(REG_SR, SIZE_WORD) == (SR_FLAG_NEGATIVE | SR_FLAG_OVERFLOW));
+    }
+
+    {
+        TEST_LABEL("compare keeps extend");
+        Registers registers;
+        registers.setFlags(FLAGS_SUB, SIZE_LONG, 1, 0); // 0 - 1 borrows
+        registers.setFlags(FLAGS_CMP, SIZE_LONG, 5, 5);
+        TEST_TRUE(registers.get(REG_SR, SIZE_WORD) == (SR_FLAG_EXTEND | SR_FLAG_ZERO));
+
+        registers.setFlags(FLAGS_LOGIC, SIZE_WORD, 0, 0x8000);
+        TEST_TRUE(registers.get(REG_SR, SIZE_WORD) == (SR_FLAG_EXTEND | SR_FLAG_NEGATIVE));
+    }
+
+    {
+        TEST_LABEL("sr write replaces pending flags");
+        Registers registers;
+        registers.set(REG_SR, SIZE_WORD, SR_FLAG_SUPERVISOR);
+        registers.setFlags(FLAGS_ADD, SIZE_BYTE, 0xFF, 0x01);
+        registers.set(REG_SR, SIZE_BYTE, SR_FLAG_NEGATIVE);
+        TEST_TRUE(registers.get(REG_SR, SIZE_WORD) == (SR_FLAG_SUPERVISOR | SR_FLAG_NEGATIVE));
+    }
+
+    {
+        TEST_LABEL("single flag write");
+        Registers registers;
+        registers.setFlags(FLAGS_SUB, SIZE_BYTE, 0x01, 0x00);
+        registers.set(SR_FLAG_ZERO, true);
+        TEST_TRUE(registers.get(SR_FLAG_CARRY));
+        TEST_TRUE(registers.get(SR_FLAG_ZERO));
+        TEST_TRUE(registers.get(SR_FLAG_NEGATIVE));
+    }
+
+    {
+        TEST_LABEL("materialize");
+        Registers registers;
+        registers.setFlags(FLAGS_SHIFT, SIZE_LONG, 1, 0);
+        registers.materializeFlags();
+        TEST_TRUE((registers.srr & CCR_MASK) == (SR_FLAG_EXTEND | SR_FLAG_ZERO | SR_FLAG_CARRY));
+
+        registers.setFlags(FLAGS_ROTATE, SIZE_LONG, 0, 0x80000000);
+        registers.materializeFlags();
+        TEST_TRUE((registers.srr & CCR_MASK) == (SR_FLAG_EXTEND | SR_FLAG_NEGATIVE));
+    }
+
+    {
+        TEST_LABEL("cmp, bne");
+        // 0x1000: cmp.l d0,d1
+        // 0x1002: bne.s +4
+        CPU cpu = CPU();
+        cpu.state.memory.set(0x1000, SIZE_WORD, 0xB280);
+        cpu.state.memory.set(0x1002, SIZE_WORD, 0x6604);
+        cpu.state.registers.set(REG_D0, SIZE_LONG, 7);
+        cpu.state.registers.set(REG_D1, SIZE_LONG, 7);
+        cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        cpu.step();
+        TEST_TRUE(cpu.state.checkCondition(COND_EQUAL));
+        TEST_TRUE(cpu.state.checkCondition(COND_GREATER_EQUAL));
+        cpu.step();
+        TEST_TRUE(cpu.state.registers.get(REG_PC, SIZE_LONG) == 0x1004);
+    }
+}
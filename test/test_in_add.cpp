@@ -9,6 +9,40 @@ using namespace M68K;
 
 int main(int, char**){
     TEST_NAME("Instruction ADD");
+
+    {
+        TEST_LABEL("add.l D1, D0 carry out of bit 31");
+        auto instruction = INSTRUCTION::Add::create(0xD081);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0xFFFFFFFF);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000001);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0x00000000);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == true);
+    }
+
+    {
+        TEST_LABEL("add.l D1, D0 signed overflow");
+        auto instruction = INSTRUCTION::Add::create(0xD081);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0x7FFFFFFF);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000001);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0x80000000);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == false);
+    }
     
     {
         TEST_LABEL("add.w #$CCDD, D1");
@@ -10,6 +10,37 @@ using namespace M68K;
 int main(int, char**){
     TEST_NAME("Instruction MOVEQ");
 
+    {
+        TEST_LABEL("moveq #-1, D0");
+        auto instruction = INSTRUCTION::Moveq::create(0x70FF);
+        CPUState state = CPUState();
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0xFFFFFFFF);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == false);
+    }
+
+    {
+        TEST_LABEL("moveq #-128, D3");
+        auto instruction = INSTRUCTION::Moveq::create(0x7680);
+        CPUState state = CPUState();
+        state.registers.set(REG_D3, DataSize::SIZE_LONG, 0x12345678);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D3, DataSize::SIZE_LONG) == 0xFFFFFF80);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == false);
+    }
+
     {
         TEST_LABEL("moveq #100, D0");
         auto instruction = INSTRUCTION::Moveq::create(0x7064); // moveq #100, D0
@@ -9,6 +9,40 @@ using namespace M68K;
 
 int main(int, char**){
     TEST_NAME("Instruction Sub");
+
+    {
+        TEST_LABEL("sub.l D1, D0 borrow out of bit 31");
+        auto instruction = INSTRUCTION::Sub::create(0x9081);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0x00000000);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000001);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0xFFFFFFFF);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == true);
+    }
+
+    {
+        TEST_LABEL("sub.l D1, D0 signed overflow");
+        auto instruction = INSTRUCTION::Sub::create(0x9081);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0x80000000);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000001);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0x7FFFFFFF);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == false);
+    }
     
     {
         TEST_LABEL("sub.w #$1111, D1");
@@ -10,6 +10,44 @@ using namespace M68K;
 int main(int, char**){
     TEST_NAME("Instruction SUBX");
 
+    {
+        TEST_LABEL("subx.l D1, D0 borrow out of bit 31");
+        auto instruction = INSTRUCTION::Subx::create(0x9181);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0x00000000);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000000);
+        state.registers.set(SR_FLAG_EXTEND, true);
+        state.registers.set(SR_FLAG_ZERO, true);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0xFFFFFFFF);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == true);
+    }
+
+    {
+        TEST_LABEL("subx.l D1, D0 signed overflow by the extend bit");
+        auto instruction = INSTRUCTION::Subx::create(0x9181);
+        CPUState state = CPUState();
+        state.registers.set(REG_D0, DataSize::SIZE_LONG, 0x80000000);
+        state.registers.set(REG_D1, DataSize::SIZE_LONG, 0x00000000);
+        state.registers.set(SR_FLAG_EXTEND, true);
+        state.registers.set(SR_FLAG_ZERO, true);
+
+        instruction.get()->execute(state);
+        TEST_TRUE(state.registers.get(REG_D0, DataSize::SIZE_LONG) == 0x7FFFFFFF);
+
+        TEST_TRUE(state.registers.get(SR_FLAG_EXTEND) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_NEGATIVE) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_ZERO) == false);
+        TEST_TRUE(state.registers.get(SR_FLAG_OVERFLOW) == true);
+        TEST_TRUE(state.registers.get(SR_FLAG_CARRY) == false);
+    }
+
     {
         TEST_LABEL("subx.w D0, D1");
         auto instruction = INSTRUCTION::Subx::create(0x9340); // subx.w D0, D1
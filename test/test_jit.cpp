@@ -0,0 +1,192 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <thread>
+
+using namespace M68K;
+
+#if M68K_JIT
+static bool sameRegisters(CPU& l, CPU& r){
+    bool equal = true;
+    for(size_t i = 0; i < REGS_COUNT; i++){
+        RegisterType reg = static_cast<RegisterType>(i);
+        equal = equal && (l.state.registers.get(reg, SIZE_LONG) == r.state.registers.get(reg, SIZE_LONG));
+    }
+    return equal;
+}
+
+static bool sameMemory(CPU& l, CPU& r, uint32_t address, uint32_t size){
+    bool equal = true;
+    for(uint32_t i = 0; i < size; i += SIZE_LONG){
+        equal = equal && (l.state.memory.get(address + i, SIZE_LONG) == r.state.memory.get(address + i, SIZE_LONG));
+    }
+    return equal;
+}
+
+static void clearMemory(CPU& cpu, uint32_t address, uint32_t size){
+    for(uint32_t i = 0; i < size; i += SIZE_LONG){
+        cpu.state.memory.set(address + i, SIZE_LONG, 0);
+    }
+}
+
+static void loadWords(CPU& cpu, uint32_t address, const uint16_t* words, size_t count){
+    for(size_t i = 0; i < count; i++){
+        cpu.state.memory.set(address + (uint32_t)(i * SIZE_WORD), SIZE_WORD, words[i]);
+    }
+    cpu.state.registers.set(REG_PC, SIZE_LONG, address);
+}
+#endif
+
+int main(int, char**){
+    TEST_NAME("JIT");
+
+#if M68K_JIT
+    {
+        TEST_LABEL("fibonacci");
+        CPU interpreter = CPU();
+        CPU jit = CPU();
+        interpreter.jit.enabled = false;
+        load_elf(&interpreter, "../../test/binary/fibonacci.elf");
+        load_elf(&jit, "../../test/binary/fibonacci.elf");
+
+        uint64_t n = 0;
+        while(n < 20000){
+            n += jit.run(1);
+        }
+        uint64_t m = 0;
+        while(m < n){
+            m += interpreter.run(1);
+        }
+        TEST_TRUE(m == n);
+        TEST_TRUE(sameRegisters(interpreter, jit));
+        TEST_TRUE(sameMemory(interpreter, jit, 0x4000, 0x100));
+    }
+
+    {
+        TEST_LABEL("bubblesort");
+        CPU interpreter = CPU();
+        CPU jit = CPU();
+        interpreter.jit.enabled = false;
+        load_elf(&interpreter, "../../test/binary/bubblesort.elf");
+        load_elf(&jit, "../../test/binary/bubblesort.elf");
+
+        while(interpreter.state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+            interpreter.run(1);
+        }
+        while(jit.state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+            jit.run(1);
+        }
+        TEST_TRUE(sameRegisters(interpreter, jit));
+        TEST_TRUE(sameMemory(interpreter, jit, 0x3000, 30 * SIZE_LONG));
+    }
+
+    {
+        TEST_LABEL("condition codes");
+        const uint16_t program[] = {
+            0x70FF,                 // moveq #-1,d0
+            0x7205,                 // moveq #5,d1
+            0x7E64,                 // moveq #100,d7
+            0x41F9, 0x0000, 0x2000, // lea $2000,a0
+            0x43F9, 0x0000, 0x3000, // lea $3000,a1
+            0xD200,                 // loop: add.b d0,d1
+            0x5642,                 // addq.w #3,d2
+            0x9680,                 // sub.l d0,d3
+            0x30C1,                 // move.w d1,(a0)+
+            0xB304,                 // eor.b d1,d4
+            0xB460,                 // cmp.w -(a0),d2
+            0xD391,                 // add.l d1,(a1)
+            0xC491,                 // and.l (a1),d2
+            0x8A41,                 // or.w d1,d5
+            0x4A43,                 // tst.w d3
+            0x5DC6,                 // slt d6
+            0xDC06,                 // add.b d6,d6
+            0x5889,                 // addq.l #4,a1
+            0x5387,                 // subq.l #1,d7
+            0x66E2,                 // bne loop
+            0x60FE,                 // bra *
+        };
+        CPU interpreter = CPU();
+        CPU jit = CPU();
+        interpreter.jit.enabled = false;
+        loadWords(interpreter, 0x1000, program, sizeof(program) / sizeof(program[0]));
+        loadWords(jit, 0x1000, program, sizeof(program) / sizeof(program[0]));
+        for(CPU* cpu : {&interpreter, &jit}){
+            clearMemory(*cpu, 0x2000, 0x10);
+            clearMemory(*cpu, 0x3000, 100 * SIZE_LONG);
+        }
+
+        while(interpreter.state.registers.get(REG_PC, SIZE_LONG) != 0x1030){
+            interpreter.run(1);
+        }
+        while(jit.state.registers.get(REG_PC, SIZE_LONG) != 0x1030){
+            jit.run(1);
+        }
+        TEST_TRUE(sameRegisters(interpreter, jit));
+        TEST_TRUE(sameMemory(interpreter, jit, 0x2000, 0x10));
+        TEST_TRUE(sameMemory(interpreter, jit, 0x3000, 100 * SIZE_LONG));
+    }
+
+    {
+        TEST_LABEL("code buffer of a thread");
+        CPU interpreter = CPU();
+        CPU moved = CPU();
+        CPU other = CPU();
+        interpreter.jit.enabled = false;
+        load_elf(&interpreter, "../../test/binary/fibonacci.elf");
+        load_elf(&moved, "../../test/binary/fibonacci.elf");
+        load_elf(&other, "../../test/binary/fibonacci.elf");
+
+        // moved compiles into the buffer of the worker, then continues in the one of this thread
+        uint64_t n = 0;
+        std::thread worker([&](){
+            while(n < 10000){
+                n += moved.run(1);
+            }
+        });
+        worker.join();
+        uint64_t m = 0;
+        while(n < 20000){
+            n += moved.run(1);
+            m += other.run(1);
+        }
+        uint64_t k = 0;
+        while(k < n){
+            k += interpreter.run(1);
+        }
+        TEST_TRUE(k == n && sameRegisters(interpreter, moved));
+
+        CPU reference = CPU();
+        reference.jit.enabled = false;
+        load_elf(&reference, "../../test/binary/fibonacci.elf");
+        for(k = 0; k < m;){
+            k += reference.run(1);
+        }
+        TEST_TRUE(k == m && sameRegisters(reference, other));
+    }
+
+    {
+        TEST_LABEL("memory fault");
+        const uint16_t program[] = {
+            0x41F9, 0x0000, 0x2000, // lea $2000,a0
+            0x7E28,                 // moveq #40,d7
+            0x2210,                 // loop: move.l (a0),d1
+            0x5387,                 // subq.l #1,d7
+            0x66FA,                 // bne loop
+            0x5288,                 // addq.l #1,a0
+            0x60F6,                 // bra loop
+        };
+        CPU cpu = CPU();
+        loadWords(cpu, 0x1000, program, sizeof(program) / sizeof(program[0]));
+        cpu.memory.set(0x4000, SIZE_WORD, 0x60FE); // handler: bra.s *
+        cpu.memory.set(VECTOR_ADDRESS_ERROR * SIZE_LONG, SIZE_LONG, 0x4000);
+        cpu.state.registers.set(REG_SSP, SIZE_LONG, 0x8000);
+        while(cpu.state.registers.get(REG_PC, SIZE_LONG) != 0x4000){
+            cpu.run(1);
+        }
+        TEST_TRUE(cpu.state.registers.get(REG_A0, SIZE_LONG) == 0x2001);
+        TEST_TRUE(cpu.memory.get(0x8000 - 12, SIZE_LONG) == 0x2001);  // access address
+        TEST_TRUE(cpu.memory.get(0x8000 - 8, SIZE_WORD) == 0x2210);   // opcode
+        TEST_TRUE(cpu.memory.get(0x8000 - 4, SIZE_LONG) == 0x100A);   // after the opcode
+    }
+#endif
+}
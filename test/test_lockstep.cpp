@@ -0,0 +1,124 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+using namespace M68K;
+
+static const uint32_t CODE = 0x1000;
+static const uint32_t END_PC = 0x1012;
+static const uint32_t RESULT = 0x2000;
+
+// d1 = d0 + (d0 - 1) + ... + 1, flipped by eor.b d3 when below d2, stored to (a0)
+static const uint16_t PROGRAM[] = {
+    0x7200, // moveq #0,d1
+    0xD280, // add.l d0,d1
+    0x5380, // subq.l #1,d0
+    0x66FA, // bne.s $1002
+    0xB242, // cmp.w d2,d1
+    0x6C02, // bge.s $100e
+    0xB701, // eor.b d3,d1
+    0x2081, // move.l d1,(a0)
+    0x4A81, // tst.l d1
+    0x60FE, // bra.s $1012
+};
+
+static const std::size_t LANES = 24;
+
+static void setupLane(std::size_t lane, std::function<void(RegisterType, uint32_t)> set){
+    set(REG_D0, (uint32_t)lane + 1);
+    set(REG_D2, 50);
+    set(REG_D3, 0x5A);
+    set(REG_A0, RESULT);
+}
+
+
+int main(int, char**){
+    TEST_NAME("Lockstep");
+
+    BasicCPU<MemoryBus> prototype;
+    prototype.memory.mapRam(0, 0x10000);
+    for(uint32_t i = 0; i < sizeof(PROGRAM) / sizeof(PROGRAM[0]); i++){
+        prototype.memory.set(CODE + i * SIZE_WORD, SIZE_WORD, PROGRAM[i]);
+    }
+    prototype.state.registers.set(REG_PC, SIZE_LONG, CODE);
+
+    LockstepEngine engine(prototype, LANES);
+    TEST_TRUE(engine.laneCount() == LANES);
+    for(std::size_t lane = 0; lane < LANES; lane++){
+        setupLane(lane, [&](RegisterType reg, uint32_t value){ engine.set(lane, reg, value); });
+    }
+
+    {
+        TEST_LABEL("run to the end");
+        uint64_t executed = engine.run(100000, END_PC);
+        bool all = executed > 0;
+        for(std::size_t lane = 0; lane < LANES; lane++){
+            all = all && engine.stopped(lane, END_PC);
+        }
+        TEST_TRUE(all);
+    }
+
+    {
+        TEST_LABEL("same as the interpreter");
+        bool same = true;
+        for(std::size_t lane = 0; lane < LANES; lane++){
+            std::unique_ptr<BasicCPU<MemoryBus>> cpu = prototype.clone();
+            setupLane(lane, [&](RegisterType reg, uint32_t value){ cpu->state.registers.set(reg, SIZE_LONG, value); });
+            while(cpu->state.registers.get(REG_PC, SIZE_LONG) != END_PC){
+                cpu->step();
+            }
+            Registers registers = engine.registers(lane);
+            for(size_t reg = 0; reg < REGS_COUNT; reg++){
+                same = same && registers.get((RegisterType)reg, SIZE_LONG) == cpu->state.registers.get((RegisterType)reg, SIZE_LONG);
+            }
+            same = same && engine.memory(lane).get(RESULT, SIZE_LONG) == cpu->memory.get(RESULT, SIZE_LONG);
+        }
+        TEST_TRUE(same);
+    }
+
+    {
+        TEST_LABEL("lanes own their memory");
+        TEST_TRUE(engine.memory(0).get(RESULT, SIZE_LONG) == (1u ^ 0x5A));
+        TEST_TRUE(engine.memory(LANES - 1).get(RESULT, SIZE_LONG) == LANES * (LANES + 1) / 2);
+        TEST_TRUE(prototype.memory.get(RESULT, SIZE_LONG) == 0);
+    }
+
+    {
+        TEST_LABEL("a polling lane does not starve the others");
+        // lane 0 waits for d4 below the code lane 1 runs
+        const uint16_t program[] = {
+            0x4A85, // tst.l d5
+            0x6604, // bne.s $1008
+            0x4A84, // tst.l d4
+            0x67FC, // beq.s $1004
+            0x7005, // moveq #5,d0
+            0x5380, // subq.l #1,d0
+            0x66FC, // bne.s $100a
+            0x60FE, // bra.s $100e
+        };
+        const uint32_t end_pc = CODE + 14;
+        BasicCPU<MemoryBus> poller;
+        poller.memory.mapRam(0, 0x10000);
+        for(uint32_t i = 0; i < sizeof(program) / sizeof(program[0]); i++){
+            poller.memory.set(CODE + i * SIZE_WORD, SIZE_WORD, program[i]);
+        }
+        poller.state.registers.set(REG_PC, SIZE_LONG, CODE);
+
+        LockstepEngine polling(poller, 2);
+        polling.set(1, REG_D5, 1);
+        polling.run(10000, end_pc);
+        TEST_TRUE(polling.stopped(1, end_pc));
+        TEST_TRUE(polling.get(1, REG_D0) == 0);
+        TEST_FALSE(polling.stopped(0, end_pc));
+    }
+
+    {
+        TEST_LABEL("step limit");
+        LockstepEngine limited(prototype, 4);
+        TEST_TRUE(limited.run(3, END_PC) == 12);
+        TEST_TRUE(limited.get(0, REG_PC) == CODE + 6);
+    }
+}
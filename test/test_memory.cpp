@@ -2,8 +2,13 @@
 
 #include "m68k.hpp"
 #include "memory.hpp"
+#include "mapped_memory.hpp"
 #include "helpers.hpp"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 using namespace M68K;
 
 int main(int, char**){
@@ -120,4 +125,65 @@ int main(int, char**){
     //         data = memory.get(0xFFFFFF, DataSize::SIZE_WORD);
     //     }
     // );
+
+    // Lazily committed memory
+    TEST_LABEL("mapped memory starts zeroed");
+    MappedMemory mapped;
+    TEST_TRUE(mapped.get(0x000000, DataSize::SIZE_LONG) == 0);
+    TEST_TRUE(mapped.get(0x7FFFFC, DataSize::SIZE_LONG) == 0);
+
+    TEST_LABEL("mapped memory get/set");
+    mapped.set(0x10000, DataSize::SIZE_LONG, 0xAABBCCDD);
+    TEST_TRUE(mapped.get(0x10002, DataSize::SIZE_WORD) == 0xCCDD);
+    TEST_THROW(std::out_of_range, { mapped.get(0xFFFFFE, DataSize::SIZE_LONG); });
+
+    TEST_LABEL("many mapped instances");
+    std::vector<std::unique_ptr<MappedMemory>> instances;
+    for (int i = 0; i < 512; i++) { // 8 GB of guest address space, a few pages of host memory
+        instances.emplace_back(new MappedMemory());
+        instances.back()->set(0x3000, DataSize::SIZE_LONG, (uint32_t)i);
+    }
+    TEST_TRUE(instances[511]->get(0x3000, DataSize::SIZE_LONG) == 511);
+
+    // Dirty page tracking
+    TEST_LABEL("snapshot restore");
+    memory.set(0x2000, DataSize::SIZE_LONG, 0x11111111);
+    MemorySnapshot snapshot = memory.snapshot();
+    TEST_TRUE(memory.dirtyPages().empty());
+    memory.set(0x2000, DataSize::SIZE_LONG, 0x22222222);
+    memory.set(0x2FFE, DataSize::SIZE_LONG, 0x33333333); // crosses into the next page
+    memory.set(0x2004, DataSize::SIZE_BYTE, 0x44);
+    TEST_TRUE(memory.dirtyPages().size() == 2);
+    memory.restore(snapshot);
+    TEST_TRUE(memory.get(0x2000, DataSize::SIZE_LONG) == 0x11111111);
+    TEST_TRUE(memory.get(0x3000, DataSize::SIZE_WORD) == snapshot.data[0x3000] * 0x100u + snapshot.data[0x3001]);
+    TEST_TRUE(memory.dirtyPages().empty());
+
+    TEST_LABEL("restore an older snapshot");
+    memory.set(0x2000, DataSize::SIZE_LONG, 0x55555555);
+    MemorySnapshot newer = memory.snapshot();
+    memory.set(0x5000, DataSize::SIZE_LONG, 0x66666666);
+    memory.restore(snapshot); // taken before newer, 0x2000 was not written since newer
+    TEST_TRUE(memory.get(0x2000, DataSize::SIZE_LONG) == 0x11111111);
+    TEST_TRUE(memory.get(0x5000, DataSize::SIZE_LONG) != 0x66666666);
+    memory.set(0x2000, DataSize::SIZE_BYTE, 0x77);
+    memory.restore(snapshot); // the last restored one, dirty pages only
+    TEST_TRUE(memory.get(0x2000, DataSize::SIZE_LONG) == 0x11111111);
+    memory.restore(newer);
+    TEST_TRUE(memory.get(0x2000, DataSize::SIZE_LONG) == 0x55555555);
+
+    // Blocks
+    TEST_LABEL("write/read block");
+    const uint8_t block[6] = {1, 2, 3, 4, 5, 6};
+    uint8_t read_back[6] = {};
+    memory.write_block(0x4001, block, sizeof(block));
+    memory.read_block(0x4001, read_back, sizeof(read_back));
+    TEST_TRUE(std::equal(block, block + 6, read_back));
+    TEST_TRUE(memory.get(0x4002, DataSize::SIZE_WORD) == 0x0203);
+
+    TEST_LABEL("fill");
+    memory.fill(0x4000, 0xEE, 0x2000);
+    TEST_TRUE(memory.get(0x5FFC, DataSize::SIZE_LONG) == 0xEEEEEEEE);
+    TEST_TRUE(memory.dirtyPages().size() == 2);
+    TEST_THROW(std::out_of_range, { memory.fill(0xFFFFF0, 0, 0x20); });
 }
@@ -0,0 +1,129 @@
+#include "tests_functions.hpp"
+
+#include "m68k.hpp"
+#include "memory_bus.hpp"
+
+#include <vector>
+
+using namespace M68K;
+
+// records the last access, reads return the offset
+class TestDevice final : public IMemory {
+public:
+    uint32_t last_offset = 0;
+    uint32_t last_data = 0;
+    DataSize last_size = SIZE_BYTE;
+
+    virtual uint32_t get(std::size_t address, DataSize size) override {
+        last_offset = (uint32_t)address, last_size = size;
+        return (uint32_t)address;
+    }
+    virtual void set(std::size_t address, DataSize size, uint32_t data) override {
+        last_offset = (uint32_t)address, last_size = size, last_data = data;
+    }
+};
+
+
+int main(int, char**){
+    TEST_NAME("memory bus");
+
+    std::vector<uint8_t> ram(0x4000, 0);
+    std::vector<uint8_t> rom(MemoryBus::PAGE_SIZE, 0x4E);
+    TestDevice device;
+
+    MemoryBus bus;
+    bus.mapMemory(0x0000, (uint32_t)ram.size(), ram.data());
+    bus.mapMemory(0x8000, (uint32_t)rom.size(), rom.data(), PAGE_READ);
+    bus.mapDevice(0xF00000, 2 * MemoryBus::PAGE_SIZE, &device);
+
+    TEST_LABEL("ram");
+    bus.set(0x10, SIZE_LONG, 0xAABBCCDD);
+    TEST_TRUE(ram[0x10] == 0xAA && ram[0x13] == 0xDD);
+    TEST_TRUE(bus.get(0x12, SIZE_WORD) == 0xCCDD);
+    TEST_TRUE(bus.read<SIZE_BYTE>(0x11) == 0xBB);
+    TEST_TRUE(bus.hostPointer(0x11, PAGE_READ_WRITE) == &ram[0x11]);
+
+    TEST_LABEL("long across pages");
+    bus.write<SIZE_LONG>(0x0FFE, 0x11223344);
+    TEST_TRUE(ram[0x0FFF] == 0x22 && ram[0x1000] == 0x33);
+    TEST_TRUE(bus.read<SIZE_LONG>(0x0FFE) == 0x11223344);
+
+    TEST_LABEL("rom");
+    bus.set(0x8000, SIZE_WORD, 0x1234);
+    TEST_TRUE(bus.get(0x8000, SIZE_WORD) == 0x4E4E);
+    TEST_TRUE(bus.hostPointer(0x8000, PAGE_WRITE) == nullptr);
+
+    TEST_LABEL("mmio");
+    TEST_TRUE(bus.get(0xF01004, SIZE_WORD) == 0x1004);
+    bus.set(0xF00002, SIZE_LONG, 0xCAFE);
+    TEST_TRUE(device.last_offset == 2 && device.last_size == SIZE_LONG && device.last_data == 0xCAFE);
+    TEST_TRUE(bus.hostPointer(0xF00000, PAGE_READ) == nullptr);
+
+    TEST_LABEL("unmapped");
+    TEST_THROW(std::out_of_range, { bus.get(0x4000, SIZE_BYTE); });
+    TEST_THROW(std::out_of_range, { bus.set(0x7FFE, SIZE_LONG, 0); });
+    TEST_THROW(std::length_error, { bus.get(0x0001, SIZE_WORD); });
+    bus.unmap(0x0000, MemoryBus::PAGE_SIZE);
+    TEST_THROW(std::out_of_range, { bus.get(0x0010, SIZE_LONG); });
+
+    TEST_LABEL("mapping alignment");
+    TEST_THROW(std::invalid_argument, { bus.mapMemory(0x100, MemoryBus::PAGE_SIZE, ram.data()); });
+    TEST_THROW(std::out_of_range, { bus.mapDevice(0xFFF000, 2 * MemoryBus::PAGE_SIZE, &device); });
+
+    {
+        TEST_LABEL("instruction on the bus");
+        // 0x1000: move.w d0,$f00010
+        bus.mapMemory(0x0000, MemoryBus::PAGE_SIZE, ram.data());
+        bus.set(0x1000, SIZE_WORD, 0x33C0);
+        bus.set(0x1002, SIZE_LONG, 0x00F00010);
+        CPUState state(&bus);
+        state.registers.set(REG_D0, SIZE_LONG, 0x5A5A);
+        state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        InstructionDecoder::shared().Decode((uint16_t)bus.get(0x1000, SIZE_WORD))->execute(state);
+        TEST_TRUE(device.last_offset == 0x10 && device.last_size == SIZE_WORD && device.last_data == 0x5A5A);
+        TEST_TRUE(state.registers.get(REG_PC, SIZE_LONG) == 0x1006);
+    }
+
+    {
+        TEST_LABEL("copy-on-write ram");
+        MemoryBus parent;
+        parent.mapRam(0x10000, 2 * MemoryBus::PAGE_SIZE);
+        TEST_TRUE(parent.get(0x10000, SIZE_LONG) == 0);
+        TEST_TRUE(parent.hostPointer(0x10000, PAGE_WRITE) == nullptr); // nothing committed yet
+        parent.set(0x10000, SIZE_LONG, 0x12345678);
+
+        MemoryBus child;
+        child.shareFrom(parent);
+        TEST_TRUE(child.hostPointer(0x10000, PAGE_READ) == parent.hostPointer(0x10000, PAGE_READ));
+        child.set(0x10002, SIZE_WORD, 0xBEEF);
+        TEST_TRUE(child.get(0x10000, SIZE_LONG) == 0x1234BEEF);
+        TEST_TRUE(parent.get(0x10000, SIZE_LONG) == 0x12345678);
+        parent.set(0x11000, SIZE_BYTE, 0x7F);
+        TEST_TRUE(child.get(0x11000, SIZE_BYTE) == 0);
+        TEST_TRUE(child.hostPointer(0x10000, PAGE_READ) != parent.hostPointer(0x10000, PAGE_READ));
+    }
+
+    {
+        TEST_LABEL("blocks across pages");
+        MemoryBus blocks;
+        std::vector<uint8_t> host(MemoryBus::PAGE_SIZE, 0);
+        blocks.mapRam(0x0000, MemoryBus::PAGE_SIZE);
+        blocks.mapMemory(0x1000, MemoryBus::PAGE_SIZE, host.data());
+        blocks.mapDevice(0x2000, MemoryBus::PAGE_SIZE, &device);
+
+        std::vector<uint8_t> data(0x20);
+        for(size_t i = 0; i < data.size(); i++){
+            data[i] = (uint8_t)i;
+        }
+        blocks.write_block(0x0FF0, data.data(), data.size());
+        TEST_TRUE(blocks.get(0x0FFE, SIZE_LONG) == 0x0E0F1011);
+        TEST_TRUE(host[0x0F] == 0x1F);
+
+        std::vector<uint8_t> read_back(data.size());
+        blocks.read_block(0x0FF0, read_back.data(), read_back.size());
+        TEST_TRUE(read_back == data);
+
+        blocks.fill(0x1FFE, 0xAB, 3);
+        TEST_TRUE(host[0xFFF] == 0xAB && device.last_offset == 0 && device.last_data == 0xAB);
+    }
+}
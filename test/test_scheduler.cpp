@@ -0,0 +1,143 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <memory>
+#include <vector>
+
+using namespace M68K;
+
+// 26 cycles an iteration, instructions end at 4, 8, 16 and 26
+static const uint16_t LOOP[] = {
+    0x7001, // moveq #1,%d0
+    0x2200, // move.l %d0,%d1
+    0xD481, // add.l %d1,%d2
+    0x60F8, // bra $1000
+};
+
+static std::unique_ptr<CPU> makeCPU(const uint16_t* program, std::size_t count){
+    std::unique_ptr<CPU> cpu(new CPU());
+    for(uint32_t i = 0; i < count; i++){
+        cpu->memory.set(0x1000 + i * SIZE_WORD, SIZE_WORD, program[i]);
+    }
+    cpu->state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+    return cpu;
+}
+
+struct Call {
+    uint64_t now;
+    uint32_t pc;
+};
+
+
+int main(int, char**){
+    TEST_NAME("Scheduler");
+
+    {
+        TEST_LABEL("order");
+        Scheduler scheduler;
+        std::vector<int> calls;
+        scheduler.schedule(30, [&](uint64_t){ calls.push_back(3); });
+        scheduler.schedule(10, [&](uint64_t){ calls.push_back(1); });
+        Scheduler::EventId cancelled = scheduler.schedule(10, [&](uint64_t){ calls.push_back(0); });
+        scheduler.schedule(10, [&](uint64_t){ calls.push_back(2); });
+        TEST_TRUE(scheduler.deadline() == 10 && scheduler.size() == 4);
+        TEST_TRUE(scheduler.cancel(cancelled) && !scheduler.cancel(cancelled));
+
+        scheduler.dispatch(20);
+        TEST_TRUE(calls == std::vector<int>({1, 2}) && scheduler.deadline() == 30);
+
+        // an event scheduled by a callback for the current cycle is called by the same dispatch
+        scheduler.schedule(40, [&](uint64_t now){ scheduler.schedule(now, [&](uint64_t){ calls.push_back(5); }); });
+        scheduler.dispatch(50);
+        TEST_TRUE(calls == std::vector<int>({1, 2, 3, 5}) && scheduler.empty());
+        TEST_TRUE(scheduler.deadline() == Scheduler::NEVER);
+    }
+
+#if M68K_CYCLES
+    {
+        TEST_LABEL("run calls events at the same instruction as step");
+        std::unique_ptr<CPU> step_cpu = makeCPU(LOOP, 4);
+        std::unique_ptr<CPU> run_cpu = makeCPU(LOOP, 4);
+        std::vector<Call> step_calls;
+        std::vector<Call> run_calls;
+        // in a block being recorded, in a cached block, at its last instruction
+        for(uint64_t deadline : {5u, 50u, 130u}){
+            step_cpu->scheduler.schedule(deadline, [&](uint64_t now){ step_calls.push_back({now, step_cpu->state.registers.pc}); });
+            run_cpu->scheduler.schedule(deadline, [&](uint64_t now){ run_calls.push_back({now, run_cpu->state.registers.pc}); });
+        }
+        while(step_cpu->state.cycles < 200){
+            step_cpu->step();
+        }
+        RunLimits limits;
+        limits.cycles = 200;
+        RunResult result = run_cpu->run(limits);
+        TEST_TRUE(result.reason == STOP_CYCLES && run_cpu->state.cycles == step_cpu->state.cycles);
+
+        bool equal = step_calls.size() == 3 && run_calls.size() == 3;
+        for(size_t i = 0; equal && i < 3; i++){
+            equal = step_calls[i].now == run_calls[i].now && step_calls[i].pc == run_calls[i].pc;
+        }
+        TEST_TRUE(equal);
+        TEST_TRUE(run_calls[0].now == 8 && run_calls[0].pc == 0x1004);
+        TEST_TRUE(run_calls[1].now == 52 && run_calls[1].pc == 0x1000);
+    }
+
+    {
+        TEST_LABEL("periodic event");
+        std::unique_ptr<CPU> cpu = makeCPU(LOOP, 4);
+        std::vector<uint64_t> late;
+        std::function<void(uint64_t)> tick = [&](uint64_t now){
+            late.push_back(now % 100);
+            cpu->scheduler.schedule(now - now % 100 + 100, tick);
+        };
+        cpu->scheduler.schedule(100, tick);
+        RunLimits limits;
+        limits.cycles = 1000;
+        cpu->run(limits);
+        bool in_time = late.size() == 10;
+        for(uint64_t cycles : late){
+            in_time = in_time && cycles < 10; // bra.s is the longest instruction of the loop
+        }
+        TEST_TRUE(in_time);
+    }
+
+    {
+        TEST_LABEL("idle loop waits for the next event");
+        static const uint16_t POLL[] = {
+            0x4A50, // tst.w (%a0)
+            0x67FC, // beq $1000
+            0x5280, // addq.l #1,%d0
+            0x60FC, // bra $1004
+        };
+        std::unique_ptr<CPU> cpu = makeCPU(POLL, 4);
+        cpu->memory.set(0x2000, SIZE_WORD, 0);
+        cpu->state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+        uint64_t called = 0;
+        cpu->scheduler.schedule(1000000, [&](uint64_t now){
+            called = now;
+            cpu->memory.set(0x2000, SIZE_WORD, 1);
+        });
+
+        // the skipped iterations count as executed and stop at the instruction limit
+        RunLimits limits;
+        limits.instructions = 1001;
+        RunResult result = cpu->run(limits);
+        TEST_TRUE(result.reason == STOP_INSTRUCTIONS && called == 0);
+        TEST_TRUE(result.instructions == 1002 && result.cycles == 1002 / 2 * 18);
+        TEST_TRUE(cpu->state.cycles == result.cycles);
+
+        limits.instructions = 200000; // about 111000 of them up to the event
+        result = cpu->run(limits);
+        TEST_TRUE(called >= 1000000 && called < 1000000 + 18);
+        TEST_TRUE(result.reason == STOP_INSTRUCTIONS && !cpu->state.halted);
+        TEST_TRUE(result.instructions >= 200000 && result.instructions < 200000 + 2);
+        TEST_TRUE(cpu->state.registers.get(REG_D0, SIZE_LONG) > 0);
+
+        // without events the loop stops as before
+        cpu->memory.set(0x2000, SIZE_WORD, 0);
+        cpu->state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+        result = cpu->run(RunLimits());
+        TEST_TRUE(result.reason == STOP_IDLE && result.instructions < 1000 && !cpu->state.halted);
+    }
+#endif
+}
@@ -0,0 +1,173 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <cstdio>
+#include <memory>
+
+using namespace M68K;
+
+// a status register that counts its reads
+class ReadCounter final : public IMemory {
+public:
+    uint32_t reads = 0;
+
+    virtual uint32_t get(std::size_t, DataSize) override {
+        return ++reads;
+    }
+    virtual void set(std::size_t, DataSize, uint32_t) override {
+    }
+};
+
+static bool sameRegisters(CPUCore& l, CPUCore& r){
+    bool equal = true;
+    for(size_t i = 0; i < REGS_COUNT; i++){
+        RegisterType reg = static_cast<RegisterType>(i);
+        equal = equal && (l.state.registers.get(reg, SIZE_LONG) == r.state.registers.get(reg, SIZE_LONG));
+    }
+    return equal;
+}
+
+static bool sorted(CPUCore& cpu){
+    bool result = true;
+    for(uint32_t i = 1; i < 30u; i++){
+        uint32_t address = 0x3000 + i * SIZE_LONG;
+        result = result && (cpu.state.memory.get(address - SIZE_LONG, SIZE_LONG) <= cpu.state.memory.get(address, SIZE_LONG));
+    }
+    return result;
+}
+
+static void runToEnd(CPUCore& cpu){
+    while(cpu.state.registers.get(REG_PC, SIZE_LONG) != 0x100c4){
+        cpu.run(1);
+    }
+}
+
+int main(int, char**){
+    TEST_NAME("Snapshot image");
+    const std::string file_name = "bubblesort.m68kimg";
+
+    std::unique_ptr<BasicCPU<MemoryBus>> booted(new BasicCPU<MemoryBus>());
+    booted->memory.mapRam(0, (uint32_t)MEMORY_SIZE);
+    load_elf(booted.get(), "../../test/binary/bubblesort.elf");
+    booted->run(100);
+
+    {
+        TEST_LABEL("save");
+        TEST_TRUE(save_image(booted.get(), file_name));
+    }
+
+    {
+        TEST_LABEL("load into a flat memory");
+        CPU cpu = CPU();
+        cpu.state.memory.fill(0, 0x55, MEMORY_SIZE);
+        TEST_TRUE(load_image(&cpu, file_name));
+        TEST_TRUE(sameRegisters(cpu, *booted));
+        TEST_TRUE(cpu.state.memory.get(0x800000, SIZE_LONG) == 0); // a page of zeros
+        TEST_TRUE(cpu.state.memory.get(0x3000, SIZE_LONG) == booted->state.memory.get(0x3000, SIZE_LONG));
+        runToEnd(cpu);
+        TEST_TRUE(sorted(cpu));
+    }
+
+    {
+        TEST_LABEL("map onto a memory bus");
+        std::unique_ptr<BasicCPU<MemoryBus>> cpu(new BasicCPU<MemoryBus>());
+        cpu->memory.mapRam(0, (uint32_t)MEMORY_SIZE);
+        TEST_TRUE(load_image(cpu.get(), file_name));
+        TEST_TRUE(sameRegisters(*cpu, *booted));
+        TEST_TRUE(cpu->memory.hostPointer(0x3000, PAGE_WRITE) == nullptr); // still the file
+        runToEnd(*cpu);
+        TEST_TRUE(sorted(*cpu));
+
+        // a second guest on the same file starts from the saved data
+        std::unique_ptr<BasicCPU<MemoryBus>> other(new BasicCPU<MemoryBus>());
+        other->memory.mapRam(0, (uint32_t)MEMORY_SIZE);
+        TEST_TRUE(load_image(other.get(), file_name));
+        TEST_TRUE(other->state.memory.get(0x3000, SIZE_LONG) == booted->state.memory.get(0x3000, SIZE_LONG));
+    }
+
+    {
+        TEST_LABEL("device pages are skipped");
+        const std::string device_file = "device.m68kimg";
+        ReadCounter device;
+        std::unique_ptr<BasicCPU<MemoryBus>> cpu(new BasicCPU<MemoryBus>());
+        cpu->memory.mapRam(0, 0x10000);
+        cpu->memory.mapDevice(0x10000, MemoryBus::PAGE_SIZE, &device);
+        cpu->memory.set(0x1000, SIZE_LONG, 0x12345678);
+        TEST_TRUE(save_image(cpu.get(), device_file));
+        TEST_TRUE(device.reads == 0);
+
+        CPU flat = CPU();
+        flat.state.memory.fill(0, 0x55, MEMORY_SIZE);
+        TEST_TRUE(load_image(&flat, device_file));
+        TEST_TRUE(flat.state.memory.get(0x1000, SIZE_LONG) == 0x12345678);
+        TEST_TRUE(flat.state.memory.get(0x10000, SIZE_LONG) == 0); // not in the image
+
+        // pages that are not in the image are unmapped, devices stay
+        std::unique_ptr<BasicCPU<MemoryBus>> mapped(new BasicCPU<MemoryBus>());
+        mapped->memory.mapRam(0, 0x100000);
+        mapped->memory.mapDevice(0x10000, MemoryBus::PAGE_SIZE, &device);
+        TEST_TRUE(load_image(mapped.get(), device_file));
+        TEST_TRUE(mapped->memory.get(0x1000, SIZE_LONG) == 0x12345678);
+        TEST_TRUE(mapped->memory.pageAccess(0x2000) == PAGE_READ_WRITE);
+        TEST_TRUE(mapped->memory.isDevicePage(0x10000));
+        TEST_TRUE(mapped->memory.pageAccess(0x20000) == PAGE_NONE);
+        TEST_TRUE(device.reads == 0);
+        std::remove(device_file.c_str());
+    }
+
+    {
+        TEST_LABEL("read-only pages stay read-only");
+        const std::string rom_file = "rom.m68kimg";
+        static uint8_t rom[MemoryBus::PAGE_SIZE] = {0x12, 0x34};
+        std::unique_ptr<BasicCPU<MemoryBus>> cpu(new BasicCPU<MemoryBus>());
+        cpu->memory.mapMemory(0, MemoryBus::PAGE_SIZE, rom, PAGE_READ);
+        cpu->memory.mapRam(0x1000, 0x1000);
+        TEST_TRUE(save_image(cpu.get(), rom_file));
+
+        std::unique_ptr<BasicCPU<MemoryBus>> other(new BasicCPU<MemoryBus>());
+        TEST_TRUE(load_image(other.get(), rom_file));
+        TEST_TRUE(other->memory.pageAccess(0) == PAGE_READ);
+        TEST_TRUE(other->memory.pageAccess(0x1000) == PAGE_READ_WRITE);
+        other->memory.set(0, SIZE_WORD, 0xFFFF);
+        TEST_TRUE(other->memory.get(0, SIZE_WORD) == 0x1234);
+        std::remove(rom_file.c_str());
+    }
+
+    {
+        TEST_LABEL("run state");
+        const std::string state_file = "state.m68kimg";
+        std::unique_ptr<BasicCPU<MemoryBus>> cpu(new BasicCPU<MemoryBus>());
+        cpu->memory.mapRam(0, 0x10000);
+        cpu->state.stopped = true;
+        cpu->state.cycles = 0x123456789ull;
+        cpu->state.raiseIRQ(3, 0x40);
+        cpu->state.raiseIRQ(5);
+        TEST_TRUE(save_image(cpu.get(), state_file));
+
+        CPU flat = CPU();
+        flat.state.halted = true;
+        flat.state.raiseIRQ(7);
+        TEST_TRUE(load_image(&flat, state_file));
+        TEST_FALSE(flat.state.halted);
+        TEST_TRUE(flat.state.stopped);
+        TEST_TRUE(flat.state.cycles == 0x123456789ull);
+        TEST_TRUE(flat.state.requestedIRQs() == ((1 << 3) | (1 << 5)));
+        TEST_TRUE(flat.state.irqVector(3) == 0x40 && flat.state.irqVector(5) == 0);
+
+        cpu->state.halted = true;
+        TEST_TRUE(save_image(cpu.get(), state_file));
+        std::unique_ptr<BasicCPU<MemoryBus>> other(new BasicCPU<MemoryBus>());
+        TEST_TRUE(load_image(other.get(), state_file));
+        TEST_TRUE(other->state.halted && other->state.stopped);
+        std::remove(state_file.c_str());
+    }
+
+    {
+        TEST_LABEL("not an image");
+        CPU cpu = CPU();
+        TEST_FALSE(load_image(&cpu, "../../test/binary/bubblesort.elf"));
+        TEST_FALSE(load_image(&cpu, "missing.m68kimg"));
+    }
+
+    std::remove(file_name.c_str());
+}
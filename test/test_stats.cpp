@@ -0,0 +1,97 @@
+#include "tests_functions.hpp"
+#include "m68k.hpp"
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace M68K;
+
+static void loadLoop(CPU& cpu){
+    cpu.state.memory.set(0x1000, DataSize::SIZE_WORD, 0x7001); // moveq #1,%d0
+    cpu.state.memory.set(0x1002, DataSize::SIZE_WORD, 0x20C0); // move.l %d0,(%a0)+
+    cpu.state.memory.set(0x1004, DataSize::SIZE_WORD, 0x60FA); // bra $1000
+    cpu.state.registers.set(REG_A0, SIZE_LONG, 0x2000);
+    cpu.state.registers.set(REG_PC, SIZE_LONG, 0x1000);
+}
+
+int main(int, char**){
+    TEST_NAME("Execution stats");
+
+    {
+        // the counters do not change what the CPU does, with M68K_STATS or without it
+        TEST_LABEL("run and step agree");
+        CPU run_cpu = CPU();
+        CPU step_cpu = CPU();
+        loadLoop(run_cpu);
+        loadLoop(step_cpu);
+        uint64_t executed = run_cpu.run(300);
+        for(uint64_t i = 0; i < executed; i++){
+            step_cpu.step();
+        }
+        bool equal = true;
+        for(size_t i = 0; i < REGS_COUNT; i++){
+            RegisterType reg = static_cast<RegisterType>(i);
+            equal = equal && run_cpu.state.registers.get(reg, SIZE_LONG) == step_cpu.state.registers.get(reg, SIZE_LONG);
+        }
+        for(uint32_t address = 0x2000; address < 0x2000 + 110 * SIZE_LONG; address += SIZE_LONG){
+            equal = equal && run_cpu.memory.get(address, SIZE_LONG) == step_cpu.memory.get(address, SIZE_LONG);
+        }
+        TEST_TRUE(equal);
+        TEST_TRUE(run_cpu.state.cycles == step_cpu.state.cycles);
+    }
+
+#if M68K_STATS
+    {
+        TEST_LABEL("counters");
+        STATS::reset();
+        CPU cpu = CPU();
+        loadLoop(cpu);
+        uint64_t executed = cpu.run(300);
+        for(int i = 0; i < 30; i++){
+            cpu.step();
+        }
+        executed += 30;
+
+        const ExecutionStats& stats = STATS::local();
+        TEST_TRUE(stats.instructions() == executed);
+        TEST_TRUE(stats.opcodes[0x7001] == executed / 3 && stats.opcodes[0x20C0] == executed / 3);
+        TEST_TRUE(stats.writes == executed / 3 && stats.write_bytes == executed / 3 * SIZE_LONG);
+
+        std::ostringstream csv;
+        cpu.writeStatsCsv(csv);
+        std::string text = csv.str();
+        TEST_TRUE(text.find("kind,name,count\n") == 0);
+        TEST_TRUE(text.find("handler,Moveq,110\n") != std::string::npos);
+        TEST_TRUE(text.find("mode_estimate,(An)+,110\n") != std::string::npos);
+        TEST_TRUE(text.find("memory,write_bytes,440\n") != std::string::npos);
+
+        std::ostringstream json;
+        cpu.writeStatsJson(json);
+        text = json.str();
+        TEST_TRUE(text.find("\"instructions\": 330") != std::string::npos);
+        TEST_TRUE(text.find("\"Bra\": 110") != std::string::npos);
+        TEST_TRUE(text.find("\"0x20C0\": 110") != std::string::npos);
+        TEST_TRUE(text.find("\"addressing_modes_estimate\": {") != std::string::npos);
+    }
+
+    {
+        TEST_LABEL("threads");
+        STATS::reset();
+        std::thread worker([](){
+            CPU cpu = CPU();
+            load_elf(&cpu, "../../test/binary/fibonacci.elf");
+            cpu.run(1000);
+        });
+        worker.join();
+        TEST_TRUE(STATS::local().instructions() == 0);
+
+        static ExecutionStats sum;
+        STATS::total(sum);
+        TEST_TRUE(sum.instructions() >= 1000 && sum.reads > 0);
+        STATS::reset();
+        STATS::total(sum);
+        TEST_TRUE(sum.instructions() == 0);
+    }
+#endif
+}
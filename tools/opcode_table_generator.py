@@ -111,11 +111,11 @@ def gen_py_mask():
 
 def gen_mask():
     check_opcode_table()
-    print("std::vector<MaskTableElement> opcode_mask_table = {")
+    print("static const MaskTableElement opcode_mask_table[] = {")
     for opcode in opcode_table:
-        line = "{{0x{0:04X}, 0x{1:04X}, INSTRUCTION::{2}::create}},".format(*opcode)
+        line = "{{0x{0:04X}, 0x{1:04X}, instructionType<INSTRUCTION::{2}>(), \"{2}\"}},".format(*opcode)
         comment = "//(0b{0:016b}, 0b{1:016b}, \"{2}\")".format(*opcode)
-        print("    {0:50s} {1}".format(line, comment))
+        print("    {0:80s} {1}".format(line, comment))
     print("};")
 
 def gen_opcode():